@@ -0,0 +1,98 @@
+/**
+ * @file doip_example.c
+ * @brief MicroUDS ECU as a DoIP (ISO 13400-2) entity.
+ *
+ * Build (PC / Linux):
+ * @code
+ * gcc -O2 -Iinlcude -Irely/Isotp/include -Irely/MicroHash/include -Iport/DoIP/include \
+ *     example/doip_example.c port/DoIP/src/Microuds_doip.c \
+ *     src/Microuds.c rely/Isotp/src/Isotp.c rely/MicroHash/src/MicroHash.c
+ * @endcode
+ *
+ * Run on localhost (announcements to 127.0.0.1, logical address 0x1001):
+ * @code
+ * ./a.out 127.0.0.1
+ * @endcode
+ * then connect a DoIP tester to TCP 127.0.0.1:13400, activate routing
+ * (0x0005) and send diagnostic messages (0x8001) with TA = 0x1001, or
+ * 0xE400 for functional requests. example/doip_tester.py does that and
+ * checks every answer:
+ * @code
+ * python3 example/doip_tester.py
+ * @endcode
+ */
+
+#include "Microuds_doip.h"
+#include <stdio.h>
+
+static MicroUDS_NRC_t Example_TesterPresent(void *param)
+{
+    (void)param;
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_NRC_t Example_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    if (req->len != 2)
+        return UDS_NRC_INVALID_FORMAT;
+
+    /* 回显 DID，后接 1000 字节数据：DoIP 上整报文发送，无分帧 */
+    MicroUDS_ResponseAppend(rsp, req->data, 2);
+    uint8_t *data = MicroUDS_ResponseReserve(rsp, 1000);
+    if (data == NULL)
+        return UDS_NRC_RESPONSE_TOO_LONG;
+
+    for (size_t i = 0; i < 1000; i++)
+        data[i] = (uint8_t)i;
+
+    return UDS_NRC_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    MicroUDS_DoIP_t port;
+    MicroUDS_Conf_t conf = {0};
+    MicroUDS_Handle_t ecu = NULL;
+
+    MicroUDS_DoIPConf_t doipConf = {
+        .AnnounceAddr = argc > 1 ? argv[1] : NULL,
+        .LogicalAddr = 0x1001,
+        .Vin = "MICROUDS000000001",
+        .Eid = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    };
+
+    if (MicroUDS_DoIP_Open(&port, &doipConf) != MICROUDS_OK)
+    {
+        perror("MicroUDS_DoIP_Open");
+        return 1;
+    }
+
+    MicroUDS_DoIP_Attach(&port, &conf);
+    if (MicroUDS_Create(&ecu, &conf) != MICROUDS_OK)
+        return 1;
+    MicroUDS_DoIP_Bind(&port, ecu);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TESTER_PRESENT, Example_TesterPresent, NULL, NULL, NULL},
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Example_ReadDid, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+
+    printf("MicroUDS DoIP entity 0x%04X on port %d\n", doipConf.LogicalAddr, MICROUDS_DOIP_PORT);
+
+    for (;;)
+    {
+        if (MicroUDS_DoIP_Poll(&port, -1) < 0) // 等到下一个截止时刻、报文或通知，空闲时休眠
+            break;
+
+        MicroUDS_TimerHandler(ecu); // 端口提供时钟，无需 MicroUDS_TickHandler
+    }
+
+    MicroUDS_Destroy(&ecu);
+    MicroUDS_DoIP_Close(&port);
+
+    return 0;
+}
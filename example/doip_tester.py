@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Scripted DoIP tester for example/doip_example.c.
+
+Start the entity with announcements to localhost, then run this script:
+
+    ./doip_example 127.0.0.1 &
+    python3 example/doip_tester.py
+
+Every exchange is checked; the script stops at the first mismatch and
+exits with status 1. Only the Python standard library is used.
+"""
+
+import socket
+import struct
+import sys
+import time
+
+HOST = sys.argv[1] if len(sys.argv) > 1 else '127.0.0.1'
+PORT = 13400
+ECU = 0x1001      # doip_example 的逻辑地址
+FUNC = 0xE400     # 功能寻址地址（默认）
+TESTER = 0x0E00   # 测试仪源地址
+
+
+def header(ptype, length, version=2):
+    return struct.pack('>BBHI', version, version ^ 0xFF, ptype, length)
+
+
+def message(ptype, payload=b''):
+    return header(ptype, len(payload)) + payload
+
+
+def diag(target, uds, source=TESTER):
+    return message(0x8001, struct.pack('>HH', source, target) + uds)
+
+
+def check(name, cond):
+    print('%s %s' % ('ok  ' if cond else 'FAIL', name))
+    if not cond:
+        sys.exit(1)
+
+
+def receive(sock):
+    """读一条 TCP 报文，返回 (类型, 负载)，超时返回 (None, b'')"""
+    try:
+        head = b''
+        while len(head) < 8:
+            chunk = sock.recv(8 - len(head))
+            if not chunk:
+                return None, b''
+            head += chunk
+        length = struct.unpack('>I', head[4:])[0]
+        payload = b''
+        while len(payload) < length:
+            payload += sock.recv(length - len(payload))
+        return struct.unpack('>H', head[2:4])[0], payload
+    except socket.timeout:
+        return None, b''
+
+
+def activate(sock, source=TESTER):
+    sock.sendall(message(0x0005, struct.pack('>HB', source, 0) + bytes(4)))
+    return receive(sock)
+
+
+def transact(sock, target, uds):
+    """发送诊断报文，返回 (应答类型, 响应负载)；没有响应时负载为 None"""
+    sock.sendall(diag(target, uds))
+    ack, _ = receive(sock)
+    ptype, payload = receive(sock)
+    return ack, payload[4:] if ptype == 0x8001 else None
+
+
+udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+udp.bind((HOST, 0))
+udp.settimeout(1)
+
+udp.sendto(header(0x0001, 0), (HOST, PORT))
+data = udp.recv(100)
+check('vehicle identification', data[2:4] == b'\x00\x04' and data[8:25] == b'MICROUDS000000001'
+      and struct.unpack('>H', data[25:27])[0] == ECU)
+
+udp.sendto(message(0x4001), (HOST, PORT))
+check('entity status', udp.recv(100)[2:4] == b'\x40\x02')
+
+udp.sendto(message(0x1234), (HOST, PORT))
+check('unknown payload type NACK', udp.recv(100)[8:] == b'\x01')
+
+tcp = socket.create_connection((HOST, PORT))
+tcp.settimeout(1)
+
+tcp.sendall(diag(ECU, b'\x3e\x00'))
+ptype, payload = receive(tcp)
+check('diagnostic message before activation', ptype == 0x8003 and payload[4] == 0x02)
+
+ptype, payload = activate(tcp)
+check('routing activation', ptype == 0x0006 and payload[4] == 0x10)
+
+ptype, payload = activate(tcp, 0x0E80)
+check('activation with another SA', ptype == 0x0006 and payload[4] == 0x02)
+
+check('tester present', transact(tcp, ECU, b'\x3e\x00') == (0x8002, b'\x7e'))
+
+ack, rsp = transact(tcp, ECU, b'\x22\xf1\x90')
+check('1003-byte response', ack == 0x8002 and len(rsp) == 1003 and rsp[:3] == b'\x62\xf1\x90'
+      and rsp[-1] == 999 & 0xFF)
+
+check('unknown service, physical', transact(tcp, ECU, b'\x85\x02') == (0x8002, b'\x7f\x85\x11'))
+check('unknown service, functional: no NRC', transact(tcp, FUNC, b'\x85\x02') == (0x8002, None))
+check('tester present, functional', transact(tcp, FUNC, b'\x3e\x00') == (0x8002, b'\x7e'))
+
+tcp.sendall(diag(0x2002, b'\x3e\x00'))
+ptype, payload = receive(tcp)
+check('unknown target address', ptype == 0x8003 and payload[4] == 0x03)
+
+tcp.sendall(diag(ECU, b'\x2e' + bytes(70000)))
+ptype, payload = receive(tcp)
+check('message too large', ptype == 0x0000 and payload == b'\x02')
+
+for byte in diag(ECU, b'\x3e\x00'):
+    tcp.send(bytes([byte]))
+    time.sleep(0.002)
+ack, _ = receive(tcp)
+ptype, payload = receive(tcp)
+check('request split into single bytes', ack == 0x8002 and ptype == 0x8001 and payload[4:] == b'\x7e')
+
+second = socket.create_connection((HOST, PORT))
+second.settimeout(1)
+check('second connection closed', second.recv(10) == b'')
+
+tcp.sendall(b'\x03\x03\x00\x00\x00\x00\x00\x00')
+ptype, payload = receive(tcp)
+check('bad header NACK closes the socket', ptype == 0x0000 and payload == b'\x00' and tcp.recv(10) == b'')
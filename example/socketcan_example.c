@@ -0,0 +1,126 @@
+/**
+ * @file socketcan_example.c
+ * @brief MicroUDS ECU on a Linux SocketCAN interface.
+ *
+ * Uses kernel ISO-TP sockets (CAN_ISOTP) when available and falls back to
+ * the user-space ISO-TP state machine on a CAN_RAW socket otherwise.
+ *
+ * Build (PC / Linux):
+ * @code
+ * gcc -O2 -Iinlcude -Irely/Isotp/include -Irely/MicroHash/include -Iport/SocketCan/include -Iport/CanIsotp/include \
+ *     example/socketcan_example.c port/SocketCan/src/Microuds_socketcan.c port/CanIsotp/src/Microuds_canisotp.c \
+ *     src/Microuds.c rely/Isotp/src/Isotp.c rely/MicroHash/src/MicroHash.c
+ * @endcode
+ *
+ * Try it with can-utils on a virtual bus:
+ * @code
+ * sudo modprobe vcan
+ * sudo ip link add dev vcan0 type vcan && sudo ip link set vcan0 up
+ * ./a.out vcan0 &
+ * isotpsend -s 7E0 -d 7E8 vcan0 <<< "3E 00"
+ * isotprecv -s 7E0 -d 7E8 vcan0
+ * @endcode
+ */
+
+#include "Microuds_canisotp.h"
+#include "Microuds_socketcan.h"
+#include <stdio.h>
+
+static MicroUDS_NRC_t Example_TesterPresent(void *param)
+{
+    (void)param;
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_NRC_t Example_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    if (req->len != 2)
+        return UDS_NRC_INVALID_FORMAT;
+
+    /* 回显 DID，后接 100 字节数据（多帧响应） */
+    MicroUDS_ResponseAppend(rsp, req->data, 2);
+    uint8_t *data = MicroUDS_ResponseReserve(rsp, 100);
+    if (data == NULL)
+        return UDS_NRC_RESPONSE_TOO_LONG;
+
+    for (size_t i = 0; i < 100; i++)
+        data[i] = (uint8_t)i;
+
+    return UDS_NRC_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    static MicroUDS_CanIsotp_t isotp;
+    MicroUDS_SocketCan_t raw;
+    const char *ifname = argc > 1 ? argv[1] : "vcan0";
+    MicroUDS_Conf_t conf = {0};
+    MicroUDS_Handle_t ecu = NULL;
+
+    MicroUDS_CanIsotpConf_t isotpConf = {
+        .IfName = ifname,
+        .RxId = 0x7E0,
+        .FuncId = 0x7DF,
+        .TxId = 0x7E8,
+    };
+    MicroUDS_SocketCanConf_t rawConf = {
+        .IfName = ifname,
+        .RxId = 0x7E0,
+        .FuncId = 0x7DF,
+        .TxId = 0x7E8,
+    };
+
+    /* 优先使用内核 ISO-TP，不可用时回退到 CAN_RAW + 用户态 ISO-TP */
+    bool kernel = MicroUDS_CanIsotp_Open(&isotp, &isotpConf) == MICROUDS_OK;
+    if (kernel)
+    {
+        MicroUDS_CanIsotp_Attach(&isotp, &conf);
+    }
+    else if (MicroUDS_SocketCan_Open(&raw, &rawConf) == MICROUDS_OK)
+    {
+        MicroUDS_SocketCan_Attach(&raw, &conf);
+    }
+    else
+    {
+        perror("MicroUDS_SocketCan_Open");
+        return 1;
+    }
+
+    if (MicroUDS_Create(&ecu, &conf) != MICROUDS_OK)
+        return 1;
+
+    if (kernel)
+        MicroUDS_CanIsotp_Bind(&isotp, ecu);
+    else
+        MicroUDS_SocketCan_Bind(&raw, ecu);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TESTER_PRESENT, Example_TesterPresent, NULL, NULL, NULL},
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Example_ReadDid, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+
+    printf("MicroUDS listening on %s (0x7E0 / 0x7DF -> 0x7E8, %s)\n", ifname, kernel ? "CAN_ISOTP" : "CAN_RAW");
+
+    for (;;)
+    {
+        /* 端口提供 CLOCK_MONOTONIC 时钟，无需 MicroUDS_TickHandler；
+           Poll 最多等到实例的下一个截止时刻，有帧或通知时提前返回，空闲时休眠 */
+        int ret = kernel ? MicroUDS_CanIsotp_Poll(&isotp, -1) : MicroUDS_SocketCan_Poll(&raw, -1);
+        if (ret < 0)
+            break;
+
+        MicroUDS_TimerHandler(ecu);
+    }
+
+    MicroUDS_Destroy(&ecu);
+    if (kernel)
+        MicroUDS_CanIsotp_Close(&isotp);
+    else
+        MicroUDS_SocketCan_Close(&raw);
+
+    return 0;
+}
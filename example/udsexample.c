@@ -3,7 +3,7 @@
  * @brief Basic example for MicroUDS usage.
  */
 
-#include "MicroUDS.h"
+#include "Microuds.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -14,9 +14,9 @@
 /**
  * @brief User-defined transmit function (replace with your CAN TX API)
  */
-static int MyCAN_Transmit(uint8_t *data, size_t size)
+static int MyCAN_Transmit(void *user, uint8_t *data, size_t size)
 {
-    printf("[CAN TX] ");
+    printf("[%s TX] ", (const char *)user);
     for (size_t i = 0; i < size; i++)
         printf("%02X ", data[i]);
     printf("\n");
@@ -48,16 +48,48 @@ static MicroUDS_NRC_t Example_Service_0x01(void *param)
     return UDS_NRC_SUCCESS; // return postitive response
 }
 
+/**
+ * @brief Example handler for service 0x22 (Read Data By Identifier)
+ *
+ * Uses the request view / response builder API: the response is written
+ * straight into the instance transmit buffer and segmented automatically.
+ */
+static MicroUDS_NRC_t Example_Service_0x22(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    if (req->len != 2)
+        return UDS_NRC_INVALID_FORMAT;
+
+    uint16_t did = (uint16_t)((req->data[0] << 8) | req->data[1]);
+    if (did != 0xF190)
+        return UDS_NRC_REQUEST_OUT_OF_RANGE;
+
+    static const char vin[] = "WVWZZZ1JZXW000001";
+    uint8_t *out = MicroUDS_ResponseReserve(rsp, 2 + sizeof(vin) - 1);
+    if (out == NULL)
+        return UDS_NRC_RESPONSE_TOO_LONG;
+
+    out[0] = req->data[0];
+    out[1] = req->data[1];
+    memcpy(&out[2], vin, sizeof(vin) - 1);
+
+    printf("[Service 0x22] DID %04X\n", did);
+    return UDS_NRC_SUCCESS; // 62 F1 90 + VIN, sent as FF + CFs
+}
+
 /* -------------------------------------------------------------------------- */
 /*                               Service Table                                */
 /* -------------------------------------------------------------------------- */
 
-static MicroUDS_ServiceTable_t serviceTable[] = {
-    {UDS_DIAGNOSTIC_SESSION_CONTROL, Example_Service_0x10, NULL},
+static const MicroUDS_ServiceTable_t serviceTable[] = {
+    {UDS_DIAGNOSTIC_SESSION_CONTROL, Example_Service_0x10, NULL, NULL, NULL},
+    {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Example_Service_0x22, NULL},
 };
 
-static MicroUDS_SessionTable_t sessionTable[] = {
-    {UDS_SESSION_DEFAULT, Example_Service_0x01, NULL},
+static const MicroUDS_SessionTable_t sessionTable[] = {
+    {UDS_SESSION_DEFAULT, Example_Service_0x01, NULL, NULL},
 };
 
 /* -------------------------------------------------------------------------- */
@@ -68,28 +100,48 @@ int main(void)
 {
     printf("=== MicroUDS Example Start ===\n");
 
-    /* 1. Assign user transmit callback */
-
-    /* 2. Initialize MicroUDS */
-    if (MicroUDS_Init() != MICROUDS_OK)
+    /* 1. Describe the transport (classic CAN, 0x7E0 -> 0x7E8) */
+    static const MicroUDS_Transport_t can = {
+        .Tx = MyCAN_Transmit,
+        .MaxFrameSize = 8,
+        .Addressing = {.Source = 0x7E0, .Target = 0x7E8, .Functional = 0x7DF},
+    };
+    MicroUDS_Conf_t conf = {
+        .Transport = &can,
+        .TransportCtx = "ECU1",
+    };
+
+    /* 2. Create a MicroUDS instance (one per emulated ECU) */
+    MicroUDS_Handle_t ecu = NULL;
+    if (MicroUDS_Create(&ecu, &conf) != MICROUDS_OK)
     {
         printf("MicroUDS Init failed!\n");
         return -1;
     }
 
     /* 3. Register UDS Services */
-    MicroUDS_RegisterService(serviceTable, sizeof(serviceTable) / sizeof(serviceTable[0]));
+    MicroUDS_RegisterService(ecu, serviceTable, sizeof(serviceTable) / sizeof(serviceTable[0]));
 
-    MicroUDS_RegisterSession(UDS_DIAGNOSTIC_SESSION_CONTROL, sessionTable, sizeof(sessionTable) / sizeof(sessionTable[0]));
+    MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, sessionTable, sizeof(sessionTable) / sizeof(sessionTable[0]));
     /* 4. Simulate receiving a UDS frame */
     uint8_t testFrame[8] = {0x02, 0x10, 0x01, 0x00, 0, 0, 0, 0}; // SID = 0x10
-    MicroUDS_ReceiveCallback(testFrame);
+    MicroUDS_ReceiveCallback(ecu, testFrame);
+    MicroUDS_TimerHandler(ecu);
+
+    uint8_t readVin[8] = {0x03, 0x22, 0xF1, 0x90, 0, 0, 0, 0}; // ReadDataByIdentifier VIN
+    MicroUDS_ReceiveCallback(ecu, readVin);
+    MicroUDS_TimerHandler(ecu);
+
+    uint8_t flowControl[8] = {0x30, 0x00, 0x00, 0, 0, 0, 0, 0}; // tester FC: CTS, BS = 0, STmin = 0
+    MicroUDS_ReceiveCallback(ecu, flowControl);
 
     /* 5. Main loop */
     for (;;)
     {
-        MicroUDS_TimerHandler(); // periodic service logic
+        MicroUDS_TimerHandler(ecu); // periodic service logic
     }
 
+    MicroUDS_Destroy(&ecu);
+
     return 0;
 }
@@ -26,52 +26,314 @@ extern "C"
 #endif
 
 /**
- * @brief Global UDS handle instance.
+ * @brief Create a MicroUDS instance on the heap and initialize it.
  *
- * This object contains all internal runtime states and buffers.
- * It should be initialized by calling @ref MicroUDS_Init().
+ * Every instance owns its own state, buffers and service tables, so any
+ * number of independent ECUs can live in one address space. Instances
+ * share nothing; different instances may be driven from different threads.
+ *
+ * @param handle Address of the handle, must point to a NULL handle.
+ * @param conf Pointer to configuration structure @ref MicroUDS_Conf_t (may be NULL).
+ * @return MicroUDS_Sta_t Creation result.
+ * - MICROUDS_OK: Instance created.
+ * - MICROUDS_ERR_PARAM: Invalid handle.
+ * - MICROUDS_ERR_MEMORY: Memory allocation failure.
  */
-extern MicroUDS_Handle_t const MicroUDS_Handle;
+extern MicroUDS_Sta_t MicroUDS_Create(MicroUDS_Handle_t *handle, const MicroUDS_Conf_t *conf);
 
 /**
- * @brief Initialize the MicroUDS module.
+ * @brief Delete an instance created by @ref MicroUDS_Create() and free it.
  *
- * @param conf Pointer to configuration structure @ref MicroUDS_Conf_t.
+ * @param handle Address of the handle, set to NULL on return.
+ * @return MicroUDS_Sta_t
+ */
+extern MicroUDS_Sta_t MicroUDS_Destroy(MicroUDS_Handle_t *handle);
+
+/**
+ * @brief Initialize a MicroUDS instance in caller-provided storage.
+ *
+ * Together with @ref MicroUDS_Conf_t::Arena this performs no heap
+ * allocation at all: the object and every internal table live in
+ * caller-provided memory (see @ref MICROUDS_ARENA_SIZE).
+ *
+ * @param handle Pointer to the instance object (e.g. a static @ref MicroUDS_Obj).
+ * @param conf Pointer to configuration structure @ref MicroUDS_Conf_t (may be NULL).
  * @return MicroUDS_Sta_t Initialization result.
  * - MICROUDS_OK: Initialization successful.
  * - MICROUDS_ERR_PARAM: Invalid configuration.
  * - MICROUDS_ERR_MEMORY: Memory allocation failure.
  */
-extern MicroUDS_Sta_t MicroUDS_Init(void);
+extern MicroUDS_Sta_t MicroUDS_Init(MicroUDS_Handle_t handle, const MicroUDS_Conf_t *conf);
+
+/**
+ * @brief Initialize a buffer pool shared by several instances.
+ *
+ * Instances configured with @ref MicroUDS_Conf_t::RxPool carry no
+ * reassembly buffer of their own: they borrow one block from the pool when
+ * a First Frame (or a whole message passed to @ref MicroUDS_ReceiveMessage)
+ * needs reassembly and return it once the request has been handled. When
+ * no block is free the First Frame is answered with a Flow Control
+ * overflow (FS = 2).
+ *
+ * Instances configured with @ref MicroUDS_Conf_t::TxPool likewise carry no
+ * transmit buffer: one block is borrowed while a handler builds its
+ * response, while the request is pending and while a segmented response is
+ * being sent. When no block is free the request is answered with
+ * NRC 0x21 (busy, repeat request).
+ *
+ * Blocks are taken and returned lock-free, so instances running on
+ * different threads may share one pool, and one pool may serve both roles.
+ *
+ * @param pool Pool object (caller storage, must outlive every instance using it).
+ * @param mem Block storage, sized with @ref MICROUDS_POOL_SIZE.
+ * @param mem_size Size of @p mem in bytes.
+ * @param block_size Size of each buffer, i.e. the largest request an instance
+ *                   can receive (RxPool) or the largest response it can send (TxPool).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Pool ready.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR_MEMORY: @p mem cannot hold a single block.
+ */
+extern MicroUDS_Sta_t MicroUDS_PoolInit(MicroUDS_Pool_t *pool, void *mem, size_t mem_size, size_t block_size);
+
+/**
+ * @brief Number of free blocks in a buffer pool (monitoring only).
+ *
+ * @param pool Initialized pool.
+ * @return size_t Free blocks at the time of the call.
+ */
+extern size_t MicroUDS_PoolAvailable(MicroUDS_Pool_t *pool);
+
+/**
+ * @brief Initialize a statistics block.
+ *
+ * Point @ref MicroUDS_Conf_t::Stats at it before @ref MicroUDS_Init.
+ * The instance then counts:
+ * - dispatched requests per SID;
+ * - responses sent, with negative responses per NRC;
+ * - requests dropped as busy, on a sequence error or as too long;
+ * - N_Cs and S3 timeouts, RX queue drops, transmit errors and aborts.
+ *
+ * It also records the latency from a request becoming ready to its first
+ * response, excluding 0x78. Requests that went through Response-Pending
+ * land in a separate histogram. Timestamps come from
+ * @ref MicroUDS_Transport_t::NowNs when set, otherwise from the tick.
+ *
+ * Every update is a relaxed atomic increment, so several instances, on any
+ * threads, may share one block. Build with MICROUDS_STATS_ENABLE = 0 to
+ * compile the hooks out.
+ *
+ * @param stats Statistics block (caller storage, must outlive every instance using it).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Counters cleared.
+ * - MICROUDS_ERR_PARAM: @p stats is NULL.
+ */
+extern MicroUDS_Sta_t MicroUDS_StatsInit(MicroUDS_Stats_t *stats);
+
+/**
+ * @brief Copy the counters, optionally clearing them at the same time.
+ *
+ * May be called from any thread while the instances run. Each counter is
+ * read atomically. The snapshot as a whole is not one atomic cut, but no
+ * increment is lost when @p reset is set.
+ *
+ * @param stats Statistics block.
+ * @param snap Destination, or NULL to only reset.
+ * @param reset Clear each counter as it is read.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Snapshot taken.
+ * - MICROUDS_ERR_PARAM: @p stats is NULL, or @p snap is NULL without @p reset.
+ */
+extern MicroUDS_Sta_t MicroUDS_StatsSnapshot(MicroUDS_Stats_t *stats, MicroUDS_StatsSnapshot_t *snap, bool reset);
+
+/**
+ * @brief Lower bound of a latency histogram bucket.
+ *
+ * Bucket @c i holds latencies from MicroUDS_StatsBucketUs(i) up to
+ * MicroUDS_StatsBucketUs(i + 1) - 1. Below @ref MICROUDS_STATS_SUB the
+ * buckets are 1 μs wide. Above that, every power of two is split into
+ * @ref MICROUDS_STATS_SUB equal buckets.
+ *
+ * @param bucket Bucket index, below @ref MICROUDS_STATS_BUCKETS.
+ * @return uint32_t Lower bound in microseconds, UINT32_MAX for an invalid index.
+ */
+extern uint32_t MicroUDS_StatsBucketUs(size_t bucket);
+
+/**
+ * @brief Initialize a frame trace ring.
+ *
+ * Point @ref MicroUDS_Conf_t::Trace at it before @ref MicroUDS_Init.
+ * The instance then records:
+ * - every frame entering @ref MicroUDS_ReceiveFrame;
+ * - every frame accepted by the transport's Tx / TxBurst;
+ * - First Frame accepted, sequence error, N_Cs abort and S3 session reset.
+ *
+ * Each record carries a nanosecond timestamp. It comes from
+ * @ref MicroUDS_Trace_t::Clock when set (e.g. a cycle counter), otherwise
+ * from the instance's clock source. When the ring is full the oldest
+ * records are overwritten.
+ *
+ * Writing a record claims a slot with one atomic increment and copies at
+ * most one frame. Several instances, ISRs and threads may share one ring.
+ * Build with MICROUDS_TRACE_ENABLE = 0 to compile the hooks out.
+ *
+ * @param trace Ring object (caller storage, must outlive every instance using it).
+ * @param rec Record storage.
+ * @param count Number of records in @p rec, a power of two.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Ring ready, @ref MicroUDS_Trace_t::Clock cleared.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ */
+extern MicroUDS_Sta_t MicroUDS_TraceInit(MicroUDS_Trace_t *trace, MicroUDS_TraceRec_t *rec, size_t count);
+
+/**
+ * @brief Export the ring, oldest record first, as a candump log or pcap file image.
+ *
+ * - MICROUDS_TRACE_CANDUMP: `candump -l` log lines. Events are written
+ *   as comment lines starting with '#'.
+ * - MICROUDS_TRACE_PCAP: nanosecond pcap with LINKTYPE_CAN_SOCKETCAN (227),
+ *   readable by Wireshark and tcpdump. Events are left out.
+ *
+ * May run on any thread while the ring is written. Records being
+ * overwritten during the export are skipped.
+ *
+ * @param trace Initialized ring.
+ * @param fmt Output format.
+ * @param ifname Interface name for candump lines (NULL = "can0").
+ * @param buf Output buffer, or NULL to get the buffer size that always suffices.
+ * @param cap Size of @p buf.
+ * @return size_t Bytes written (the required size when @p buf is NULL); 0 on error.
+ */
+extern size_t MicroUDS_TraceExport(MicroUDS_Trace_t *trace, MicroUDS_TraceFormat_t fmt, const char *ifname, uint8_t *buf, size_t cap);
 
 /**
  * @brief UDS tick handler, should be called periodically (e.g., every 1 ms).
  *
- * Used for managing timeout counters and protocol timers.
+ * Used for managing timeout counters and protocol timers. Only increments
+ * a 32-bit counter (safe from a timer ISR); @ref MicroUDS_TimerHandler
+ * folds it into the instance's 64-bit time base, so the counter may wrap.
+ * Not needed when the transport provides a clock
+ * (@ref MicroUDS_Transport_t::Now or NowNs); the time base is then taken
+ * from it on every call into the instance (timer handler, received frame
+ * or message, submitted request, sent message, next deadline).
+ *
+ * @param handle Instance handle.
  */
-extern void MicroUDS_TickHandler(void);
+extern void MicroUDS_TickHandler(MicroUDS_Handle_t handle);
 
 /**
  * @brief Get tick count value
  * 
- * @return uint32_t 
+ * @param handle Instance handle.
+ * @return uint32_t Low 32 bits of the time base as of the last call into the instance.
  */
-extern uint32_t MicroUDS_GetTickCount(void);
+extern uint32_t MicroUDS_GetTickCount(MicroUDS_Handle_t handle);
 
 /**
  * @brief Reset internal timer counters.
  *
  * This function is typically called when a valid frame or flow control is received.
+ * It also refreshes the time base from the clock source, so call it from the
+ * context that drives @ref MicroUDS_TimerHandler.
+ *
+ * @param handle Instance handle.
  */
-extern void MicroUDS_ResetTimer(void);
+extern void MicroUDS_ResetTimer(MicroUDS_Handle_t handle);
 
 /**
  * @brief Handle timeout-related events and pending requests.
  *
  * Call this function in a main loop
  * It will automatically generate NRC (negative response) on timeout.
+ *
+ * Complete requests are queued (see @ref MICROUDS_REQ_QUEUE_DEPTH) and
+ * served in arrival order, at most @ref MicroUDS_Conf_t::ReqBudget per call.
+ * A request that arrives while the queue is full is answered with
+ * NRC 0x21 (busy, repeat request).
+ *
+ * Each instance keeps its next deadline (S3, N_Cr, N_Bs, STmin, P2/P2*,
+ * received frames and queued requests); a call made before that deadline
+ * returns after a single comparison, so idle instances cost almost nothing.
+ *
+ * To block instead of polling, set @ref MicroUDS_Conf_t::Notify: the hook
+ * is called (possibly from an ISR or another thread) when a request is
+ * ready, a Flow Control frame lets transmission continue, or a pending
+ * request was completed with @ref MicroUDS_CompleteRequest, at most once
+ * until the next call here. Wait on the hook (e.g. an eventfd in epoll)
+ * with @ref MicroUDS_NextDeadline as the timeout; timer expiry itself is
+ * not notified.
+ *
+ * @param handle Instance handle.
+ */
+extern void MicroUDS_TimerHandler(MicroUDS_Handle_t handle);
+
+/**
+ * @brief Time until @ref MicroUDS_TimerHandler next has work to do.
+ *
+ * Lets a single-instance main loop sleep (epoll / poll timeout, RTOS
+ * delay, low-power wait) instead of polling. Any received frame or
+ * transmitted message makes the instance due immediately, so re-read the
+ * deadline after each event. N_As is not tracked: transmission through
+ * @ref MicroUDS_Transport_t is synchronous.
+ *
+ * @param handle Instance handle.
+ * @return uint32_t Milliseconds (rounded up, so a sub-millisecond STmin
+ * gap reads as 1; 0 = call now), or @ref MICROUDS_DEADLINE_NONE when no
+ * timer is running (default session, idle).
+ */
+extern uint32_t MicroUDS_NextDeadline(MicroUDS_Handle_t handle);
+
+/**
+ * @brief Initialize a timer wheel shared by many instances.
+ *
+ * Instances configured with @ref MicroUDS_Conf_t::Wheel are linked into a
+ * four-level hierarchical wheel (64 slots per level, covering 2^24 ticks,
+ * later deadlines are re-cascaded) by their next deadline, and
+ * @ref MicroUDS_WheelRun only calls @ref MicroUDS_TimerHandler for the
+ * instances that are due. Scheduling and expiry are O(1) per instance,
+ * independent of how many instances are idle.
+ *
+ * The wheel and its instances must be driven from one thread. Frames fed
+ * from an ISR or another thread (@ref MICROUDS_RX_QUEUE_DEPTH) and
+ * requests completed elsewhere (@ref MicroUDS_CompleteRequest) wake the
+ * instance through a lock-free stack served by the next
+ * @ref MicroUDS_WheelRun.
+ *
+ * @param wheel Wheel object (caller storage, must outlive its instances).
+ * @param now_ms Current time in milliseconds, same clock as @ref MicroUDS_WheelRun.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Wheel ready.
+ * - MICROUDS_ERR_PARAM: @p wheel is NULL.
+ */
+extern MicroUDS_Sta_t MicroUDS_WheelInit(MicroUDS_Wheel_t *wheel, uint64_t now_ms);
+
+/**
+ * @brief Advance the wheel and serve every instance that is due.
+ *
+ * Replaces calling @ref MicroUDS_TimerHandler on each instance. Pass the
+ * same clock as the instances' @ref MicroUDS_Transport_t::Now (or NowNs
+ * in milliseconds), or give the instances no clock at all: they then run
+ * on the wheel's clock and @ref MicroUDS_TickHandler must not be used.
+ * In that case call this right after waking and before feeding frames, so
+ * timers started by those frames count from the current time.
+ * Empty slots are skipped, so a long sleep costs one step per occupied
+ * slot. Instances are woken with millisecond resolution; sub-millisecond
+ * STmin pacing needs direct @ref MicroUDS_TimerHandler calls.
+ *
+ * @param wheel Initialized wheel.
+ * @param now_ms Current time in milliseconds.
+ * @return size_t Number of @ref MicroUDS_TimerHandler calls made.
  */
-extern void MicroUDS_TimerHandler(void);
+extern size_t MicroUDS_WheelRun(MicroUDS_Wheel_t *wheel, uint64_t now_ms);
+
+/**
+ * @brief Time until the earliest instance on the wheel is due.
+ *
+ * @param wheel Initialized wheel.
+ * @return uint32_t Milliseconds (rounded up, 0 = call @ref MicroUDS_WheelRun now),
+ * or @ref MICROUDS_DEADLINE_NONE when no instance has a timer running.
+ */
+extern uint32_t MicroUDS_WheelNextDeadline(MicroUDS_Wheel_t *wheel);
 
 /**
  * @brief Receive callback for incoming ISO-TP frame data.
@@ -79,55 +341,269 @@ extern void MicroUDS_TimerHandler(void);
  * This function should be called by the transport layer (ISO-TP)
  * each time a complete CAN frame is received.
  *
+ * With @ref MICROUDS_RX_QUEUE_DEPTH enabled it only enqueues the frame
+ * (O(1), lock-free) and is safe to call from an ISR or a single reader
+ * thread concurrently with @ref MicroUDS_TimerHandler.
+ *
+ * @param handle Instance handle.
  * @param data Pointer to received 8-byte CAN frame data.
  */
-extern void MicroUDS_ReceiveCallback(uint8_t *data);
+extern void MicroUDS_ReceiveCallback(MicroUDS_Handle_t handle, uint8_t *data);
+
+/**
+ * @brief Receive one classic CAN or CAN FD frame of the given length.
+ *
+ * Same as @ref MicroUDS_ReceiveCallback, but for frames whose length is
+ * not 8 bytes (CAN FD, see @ref MICROUDS_CANFD_ENABLE). Escaped Single
+ * Frames (SF_DL > 7) and escaped First Frames (32-bit FF_DL) are accepted.
+ * Frames longer than the transport's @ref MicroUDS_Transport_t::MaxFrameSize are ignored.
+ *
+ * @param handle Instance handle.
+ * @param data Frame data.
+ * @param len Frame length in bytes (1–64).
+ */
+extern void MicroUDS_ReceiveFrame(MicroUDS_Handle_t handle, const uint8_t *data, size_t len);
+
+/**
+ * @brief Receive one complete UDS request (message mode).
+ *
+ * For transports that reassemble ISO-TP themselves, such as a Linux
+ * CAN_ISOTP socket or DoIP. The request is queued exactly like one
+ * reassembled from frames and served by @ref MicroUDS_TimerHandler; set
+ * @ref MicroUDS_Transport_t::TxMessage so responses leave as whole
+ * messages too. Frame-level input via @ref MicroUDS_ReceiveFrame keeps
+ * working as the fallback.
+ *
+ * Not routed through the RX queue: call it from the same context as
+ * @ref MicroUDS_TimerHandler.
+ *
+ * @param handle Instance handle.
+ * @param msg Complete request, starting with the SID.
+ * @param len Request length.
+ */
+extern void MicroUDS_ReceiveMessage(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len);
+
+/**
+ * @brief Receive one complete functionally addressed UDS request.
+ *
+ * Same as @ref MicroUDS_ReceiveMessage, but the request is served as a
+ * functional one: NRCs 0x11, 0x12, 0x31, 0x7E and 0x7F are not sent
+ * (ISO 14229-1), other responses are. See @ref MicroUDS_Reply_t::Functional
+ * for the immediate path.
+ *
+ * @param handle Instance handle.
+ * @param msg Complete request, starting with the SID.
+ * @param len Request length.
+ */
+extern void MicroUDS_ReceiveFunctional(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len);
+
+/**
+ * @brief Dispatch one complete UDS request immediately (zero copy).
+ *
+ * For requests that are already reassembled (replay tests, DoIP, kernel
+ * ISO-TP). The handler runs before this call returns and its request view
+ * points straight into @p msg: no frame parsing, no copy into the
+ * multi-frame buffer and no @ref MICROUDS_RX_BUF_SIZE limit on the request.
+ *
+ * Responses (including NRCs and 0x78 / final responses of a pending
+ * request) go to @p reply as whole messages; with a NULL @p reply or
+ * reply function they leave through the instance transport as usual.
+ * Set @ref MicroUDS_Reply_t::Functional for a functionally addressed
+ * request to drop the NRCs ISO 14229-1 suppresses for those.
+ * Call from the same context as @ref MicroUDS_TimerHandler.
+ *
+ * @param handle Instance handle.
+ * @param msg Complete request, starting with the SID. Only read during the call.
+ * @param len Request length.
+ * @param reply Where the responses go (copied; may be NULL).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Request dispatched.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR_BUSY: A response is still being sent, a request is pending
+ *   or queued requests are waiting; retry after @ref MicroUDS_TimerHandler
+ *   or fall back to @ref MicroUDS_ReceiveMessage.
+ */
+extern MicroUDS_Sta_t MicroUDS_SubmitRequest(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, const MicroUDS_Reply_t *reply);
 
 /**
  * @brief Register a table of UDS services (SID-level handlers).
  *
+ * The table is only read during the call and may live in read-only memory.
+ * Registering a SID again replaces its handlers. With heap allocation the
+ * service array is re-allocated when new SIDs are added, so register
+ * services before frames can arrive from another context.
+ * Entries with a chunk callback receive segmented requests incrementally
+ * as First / Consecutive Frames arrive (streaming receive) instead of
+ * through the multi-frame buffer; the handler then runs once at the end.
+ *
+ * @param handle Instance handle.
  * @param table Pointer to an array of service descriptors.
  * @param table_len Length of the service table.
  * @return MicroUDS_Sta_t Registration result.
  * - MICROUDS_OK: Registration successful.
  * - MICROUDS_ERR_PARAM: Invalid pointer or length.
+ * - MICROUDS_ERR_MEMORY: More than @ref MICROUDS_SERVICE_RECORDS services, or
+ *   out of heap memory. Nothing from the table is registered.
  * - MICROUDS_ERR_HASH: Failed to insert into hash table.
  */
-extern MicroUDS_Sta_t MicroUDS_RegisterService(MicroUDS_ServiceTable_t *table, size_t table_len);
+extern MicroUDS_Sta_t MicroUDS_RegisterService(MicroUDS_Handle_t handle, const MicroUDS_ServiceTable_t *table, size_t table_len);
 
 /**
  * @brief Register session handlers (SSID-level) under a specific Service ID.
  *
+ * The table is only read during the call and may live in read-only memory.
+ * Entries for sub-functions that are already registered replace their
+ * handlers in place. Adding new sub-functions re-packs the service's array;
+ * the arena cannot reclaim the old one, so in arena mode register all
+ * sub-functions of a SID in one call.
+ *
+ * @param handle Instance handle.
  * @param sid Service ID to register under.
  * @param table Pointer to a session (sub-function) table.
  * @param table_len Length of the table.
  * @return MicroUDS_Sta_t Registration result.
+ * - MICROUDS_OK: Registration successful.
+ * - MICROUDS_ERR_PARAM: Invalid arguments, SID not registered, or new
+ *   sub-functions for a SID that already has some in arena mode.
+ * - MICROUDS_ERR_MEMORY: Out of heap / arena memory.
+ */
+extern MicroUDS_Sta_t MicroUDS_RegisterSession(MicroUDS_Handle_t handle, MicroUDS_Sid_t sid, const MicroUDS_SessionTable_t *table, size_t table_len);
+
+/**
+ * @brief Check whether a service is registered.
+ *
+ * Uses the same SID lookup as request dispatch (index table or MicroHash,
+ * see @ref MICROUDS_DISPATCH_TABLE).
+ *
+ * @param handle Instance handle.
+ * @param sid Service ID.
+ * @return true if @p sid has a registered service.
  */
-extern MicroUDS_Sta_t MicroUDS_RegisterSession(MicroUDS_Sid_t sid, MicroUDS_SessionTable_t *table, size_t table_len);
+extern bool MicroUDS_ServiceRegistered(MicroUDS_Handle_t handle, MicroUDS_Sid_t sid);
+
+/**
+ * @brief Reserve @p n bytes at the end of a response under construction.
+ *
+ * The returned pointer addresses the instance transmit buffer directly,
+ * so a handler can write its payload in place (zero copy).
+ *
+ * @param rsp Response builder passed to a @ref MicroUDS_HandlerFunc_t.
+ * @param n Number of bytes to reserve.
+ * @return uint8_t* Write position, NULL if the response would exceed the buffer.
+ */
+extern uint8_t *MicroUDS_ResponseReserve(MicroUDS_Response_t *rsp, size_t n);
+
+/**
+ * @brief Append @p n bytes to a response under construction.
+ *
+ * @param rsp Response builder passed to a @ref MicroUDS_HandlerFunc_t.
+ * @param data Bytes to append.
+ * @param n Number of bytes.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Appended.
+ * - MICROUDS_ERR_PARAM: Invalid pointer.
+ * - MICROUDS_ERR_MEMORY: Response would exceed the transmit buffer.
+ */
+extern MicroUDS_Sta_t MicroUDS_ResponseAppend(MicroUDS_Response_t *rsp, const void *data, size_t n);
 
 /**
  * @brief Send a standard positive response (0x50-type).
  *
  * Typically called after a service handler completes successfully.
  *
+ * @param handle Instance handle.
  * @return MicroUDS_Sta_t Transmission result.
  */
-extern MicroUDS_Sta_t MicroUDS_PositiveResponse(void);
+extern MicroUDS_Sta_t MicroUDS_PositiveResponse(MicroUDS_Handle_t handle);
 
 /**
  * @brief Send a negative response (0x7F-type).
  *
+ * @param handle Instance handle.
  * @param code NRC (Negative Response Code) defined in ISO 14229-1.
  * @return MicroUDS_Sta_t Transmission result.
  */
-extern MicroUDS_Sta_t MicroUDS_NegativeResponse(MicroUDS_NRC_t code);
+extern MicroUDS_Sta_t MicroUDS_NegativeResponse(MicroUDS_Handle_t handle, MicroUDS_NRC_t code);
+
+/**
+ * @brief Send a complete UDS message (response) to the tester.
+ *
+ * Messages up to 7 bytes (MaxFrameSize - 2 on CAN FD) go out as one Single
+ * Frame. Longer messages are
+ * copied into the instance transmit buffer and sent as a First Frame; the
+ * Consecutive Frames are paced from @ref MicroUDS_TimerHandler according to
+ * the tester's Flow Control (BS, STmin, WAIT/OVFLW). The call never blocks.
+ *
+ * @param handle Instance handle.
+ * @param data Complete message, starting with the response SID.
+ * @param len Message length (1 – @ref MICROUDS_TX_BUF_SIZE).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Single Frame sent or segmented transmission started.
+ * - MICROUDS_ERR: A previous segmented transmission is still in progress.
+ * - MICROUDS_ERR_PARAM: Invalid pointer or length.
+ * - MICROUDS_ERR_TRANS: Transmit callback failed.
+ */
+extern MicroUDS_Sta_t MicroUDS_SendMessage(MicroUDS_Handle_t handle, const uint8_t *data, size_t len);
 
 /**
- * @brief Delete or deinitialize the UDS instance.
+ * @brief Finish a request whose handler returned NRC 0x78 (Response-Pending).
+ *
+ * A handler that cannot answer immediately returns
+ * UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING and hands the work to a
+ * worker thread or a later main-loop step. Until this function is called,
+ * @ref MicroUDS_TimerHandler keeps the tester alive with automatic 0x78
+ * responses (first after P2, then every P2*) and keeps queueing new
+ * requests without serving them. S3 is stopped while the request is
+ * pending and restarts after the final response. A request not completed
+ * within @ref MICROUDS_PENDING_TIMEOUT_MS is answered with NRC 0x10.
+ *
+ * May be called from any thread, once per pending request, also from the
+ * handler's worker before the handler has returned 0x78. The final
+ * response is sent from the next @ref MicroUDS_TimerHandler call; the
+ * instance's @ref MicroUDS_Conf_t::Notify hook is called to wake it.
+ *
+ * @param handle Instance handle.
+ * @param nrc UDS_NRC_SUCCESS for a positive response, UDS_NRC_NO for no
+ *            response, any other code for a negative response.
+ * @param data Complete positive response starting with SID + 0x40, or NULL
+ *             to send only [SID + 0x40, SSID]. May point into the handler's
+ *             response buffer (rsp->buf), which stays valid while pending.
+ * @param len Length of @p data (0 – @ref MICROUDS_TX_BUF_SIZE).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Completion recorded.
+ * - MICROUDS_ERR: No request is pending (the handler did not return 0x78,
+ *   or the request was already completed or timed out).
+ * - MICROUDS_ERR_PARAM: Invalid pointer, length or nrc (0x78).
+ */
+extern MicroUDS_Sta_t MicroUDS_CompleteRequest(MicroUDS_Handle_t handle, MicroUDS_NRC_t nrc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Deinitialize the UDS instance.
  *
  * Frees any allocated memory and resets all state machines.
+ * The instance object itself is not freed (see @ref MicroUDS_Destroy()).
+ *
+ * @param handle Instance handle.
+ */
+extern void MicroUDS_Delete(MicroUDS_Handle_t handle);
+
+/**
+ * @brief Get the user data configured in @ref MicroUDS_Conf_t.
+ *
+ * @param handle Instance handle.
+ * @return void* User data, NULL if none.
+ */
+extern void *MicroUDS_GetUserData(MicroUDS_Handle_t handle);
+
+/**
+ * @brief Get the transport the instance was created with.
+ *
+ * Gives access to the transport's addressing information and frame size.
+ *
+ * @param handle Instance handle.
+ * @return const MicroUDS_Transport_t* Instance copy of the transport, NULL if handle is NULL.
  */
-extern void MicroUDS_Delete(void);
+extern const MicroUDS_Transport_t *MicroUDS_GetTransport(MicroUDS_Handle_t handle);
 
 // /**
 //  * @brief Retrieve pointer to reassembled multi-frame data. (Deprecated, replaced by MicroUDS_ReadMultiframeInfo)
@@ -146,10 +622,11 @@ extern void MicroUDS_Delete(void);
 /**
  * @brief Get Multiframeinfo sid data data len @type MicroUDS_MultiInfo_t
  * 
+ * @param handle Instance handle.
  * @param info 
  * @return MicroUDS_Sta_t 
  */
-extern MicroUDS_Sta_t MicroUDS_ReadMultiframeInfo(MicroUDS_MultiInfo_t *info);
+extern MicroUDS_Sta_t MicroUDS_ReadMultiframeInfo(MicroUDS_Handle_t handle, MicroUDS_MultiInfo_t *info);
 
 #ifdef __cplusplus
 }
@@ -29,23 +29,65 @@ extern "C" {
             return MICROUDS_ERR_PARAM; \
     } while (0)
 
+/**
+ * @brief Counts one event in the instance's statistics block, if any.
+ *
+ * @param handle Instance handle.
+ * @param stat   @ref MicroUDS_Stat_t counter.
+ */
+#if MICROUDS_STATS_ENABLE
+#define MICROUDS_STAT_INC(handle, stat)                                                            \
+    do                                                                                             \
+    {                                                                                              \
+        if ((handle)->Stats != NULL)                                                               \
+            atomic_fetch_add_explicit(&(handle)->Stats->Counter[(stat)], 1, memory_order_relaxed); \
+    } while (0)
+#else
+#define MICROUDS_STAT_INC(handle, stat) ((void)0)
+#endif
+
+/**
+ * @brief Records one frame or event in the instance's trace ring, if any.
+ *
+ * @param handle Instance handle.
+ * @param kind   @ref MicroUDS_TraceKind_t.
+ * @param data   Frame data or event arguments.
+ * @param len    Length of @p data.
+ */
+#if MICROUDS_TRACE_ENABLE
+#define MICROUDS_TRACE(handle, kind, data, len)                   \
+    do                                                            \
+    {                                                             \
+        if ((handle)->Trace != NULL)                              \
+            MicroUDS_TraceRecord((handle), (kind), (data), (len)); \
+    } while (0)
+#else
+#define MICROUDS_TRACE(handle, kind, data, len) ((void)(data))
+#endif
+
 /**
  * @brief Safely calls the user-defined transmit function.
  * 
- * Ensures that @ref MicroUDS_Handle->Transmit is valid before use.
+ * Ensures that the transport Tx function is valid before use.
  * If the transmit function pointer is NULL or returns a non-zero
- * error code, this macro returns `MICROUDS_ERR_TRANS`.
+ * error code, this macro returns `MICROUDS_ERR_TRANS`; a failed call is
+ * counted as @ref MICROUDS_STAT_TX_ERROR, a successful one is traced.
  *
- * @param buf  Pointer to the data buffer to be sent.
- * @param len  Number of bytes to send.
+ * @param handle Instance handle.
+ * @param buf    Pointer to the data buffer to be sent.
+ * @param len    Number of bytes to send.
  */
-#define MICROUDS_SAFE_CALL_TRANSMIT(buf, len)             \
-    do                                                    \
-    {                                                     \
-        if (MicroUDS_Handle->Transmit == NULL)            \
-            return MICROUDS_ERR_TRANS;                    \
-        if (MicroUDS_Handle->Transmit((buf), (len)) != 0) \
-            return MICROUDS_ERR_TRANS;                    \
+#define MICROUDS_SAFE_CALL_TRANSMIT(handle, buf, len)                        \
+    do                                                                       \
+    {                                                                        \
+        if ((handle)->Transport.Tx == NULL)                                  \
+            return MICROUDS_ERR_TRANS;                                       \
+        if ((handle)->Transport.Tx((handle)->TransportCtx, (buf), (len)) != 0) \
+        {                                                                    \
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ERROR);               \
+            return MICROUDS_ERR_TRANS;                                       \
+        }                                                                    \
+        MICROUDS_TRACE(handle, MICROUDS_TRACE_TX, (buf), (len));             \
     } while (0)
 
 /**
@@ -55,38 +97,47 @@ extern "C" {
  */
 #define MICROUDS_RESPONSE_OFFSET 0x40
 
-/**
- * @brief Checks whether the ECU is busy before executing a new request.
- * 
- * If ECU status is @c ECU_BUSY, a "Busy Repeat Request" negative response
- * (NRC 0x21) is sent immediately, and the function returns.
- */
-#define UDS_CHECK_ECU_BUSY()                                        \
-    do                                                              \
-    {                                                               \
-        if (MicroUDS_Handle->Ecu_sta == ECU_BUSY)                   \
-        {                                                           \
-            MicroUDS_NegativeResponse(UDS_NRC_BUSY_REPEAT_REQUEST); \
-            return;                                                 \
-        }                                                           \
-    } while (0)
-
 /**
  * @brief Marks the ECU status as busy.
  */
-#define MICROUDS_ECUSETBUSY()   (MicroUDS_Handle->Ecu_sta = ECU_BUSY)
+#define MICROUDS_ECUSETBUSY(handle)   ((handle)->Ecu_sta = ECU_BUSY)
 
 /**
  * @brief Clears the ECU busy flag, marking it as free.
  */
-#define MICROUDS_ECUCLEAR()     (MicroUDS_Handle->Ecu_sta = ECU_FREE)
+#define MICROUDS_ECUCLEAR(handle)     ((handle)->Ecu_sta = ECU_FREE)
 
 /**
  * @brief Converts milliseconds to system ticks.
  * 
- * Uses the configured @ref MICROUDS_TICK_FREQ_HZ for conversion.
+ * Uses the configured @ref MICROUDS_TICK_FREQ_HZ for conversion, in 64-bit
+ * arithmetic so that tick rates below 1 kHz and up to 1 GHz stay exact.
+ */
+#define MICROUDS_MS_TICK(ms)    ((uint64_t)(ms) * MICROUDS_TICK_FREQ_HZ / 1000u)
+
+/**
+ * @brief Converts microseconds to system ticks (0 when shorter than one tick).
+ */
+#define MICROUDS_US_TICK(us)    ((uint64_t)(us) * MICROUDS_TICK_FREQ_HZ / 1000000u)
+
+/**
+ * @brief Number of distinct sub-functions per service.
+ *
+ * Bit 7 of a sub-function byte is the suppressPosRspMsgIndicationBit,
+ * so 0x01 and 0x81 select the same sub-function.
+ */
+#define MICROUDS_SSID_MAX       128
+
+/**
+ * @brief Maps a sub-function byte to its presence bitmap index (0–127).
+ */
+#define MICROUDS_SSID_KEY(ssid) ((uint8_t)((ssid) & 0x7F))
+
+/**
+ * @brief Tests / sets a bit in a 128-bit sub-function bitmap (uint32_t[4]).
  */
-#define MICROUDS_MS_TICK(ms)    ((ms) * (MICROUDS_TICK_FREQ_HZ / 1000))
+#define MICROUDS_SSID_TEST(map, key) (((map)[(key) >> 5] >> ((key) & 0x1F)) & 1u)
+#define MICROUDS_SSID_SET(map, key)  ((map)[(key) >> 5] |= (1u << ((key) & 0x1F)))
 
 /**
  * @brief Returns the number of elements in an array.
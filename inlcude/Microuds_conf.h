@@ -28,10 +28,22 @@ extern "C" {
  */
 #define MICROUDS_VERSION_STR          "0.0.1"
 
+/**
+ * @brief SID dispatch mode.
+ *
+ * 1: a dense 256-entry index table per instance, a request is dispatched
+ *    with a single indexed load (+256 bytes per instance).
+ * 0: look services up through the MicroHash table (see @ref MICROUDS_HASH_SIZE).
+ */
+#ifndef MICROUDS_DISPATCH_TABLE
+#define MICROUDS_DISPATCH_TABLE       1
+#endif
+
 /**
  * @brief Hash table size — corresponds to the number of supported UDS services.
  *
  * Each registered service occupies one hash bucket.
+ * Only used when @ref MICROUDS_DISPATCH_TABLE is 0.
  * 
  * ⚙️ Recommended: set equal or slightly higher than the number of services
  * you plan to register.
@@ -45,9 +57,75 @@ extern "C" {
  * This should match your periodic scheduler or timer callback rate.
  * 
  * Example: 1ms tick → 1000Hz.
+ *
+ * With a nanosecond transport clock (@ref MicroUDS_Transport_t::NowNs)
+ * any rate up to 1 GHz may be used, and Consecutive Frames are paced by
+ * STmin in nanoseconds, so 100–900 μs (0xF1–0xF9) are honoured at any
+ * tick rate. Without it an STmin shorter than one tick is rounded up to a
+ * whole tick (e.g. 1 ms at 1000 Hz), never down to 0.
  */
+#ifndef MICROUDS_TICK_FREQ_HZ
 #define MICROUDS_TICK_FREQ_HZ         1000
+#endif
+
+
+/**
+ * @brief Depth of the lock-free receive queue (frames), 0 = disabled.
+ *
+ * When non-zero (power of two), @ref MicroUDS_ReceiveCallback only copies the
+ * frame into a single-producer/single-consumer ring (C11 atomics) and all
+ * protocol processing happens in @ref MicroUDS_TimerHandler. The callback may
+ * then be called from a CAN ISR or a reader thread while another thread runs
+ * the timer handler. Frames arriving while the ring is full are dropped.
+ */
+#ifndef MICROUDS_RX_QUEUE_DEPTH
+#define MICROUDS_RX_QUEUE_DEPTH       0
+#endif
+
+#if (MICROUDS_RX_QUEUE_DEPTH & (MICROUDS_RX_QUEUE_DEPTH - 1)) != 0
+#error "MICROUDS_RX_QUEUE_DEPTH must be a power of two"
+#endif
+
+/**
+ * @brief Enable CAN FD framing (frames up to 64 bytes).
+ *
+ * When enabled, @ref MicroUDS_Transport_t::MaxFrameSize may select a CAN FD data
+ * length (12, 16, 20, 24, 32, 48 or 64) per instance; single frames then
+ * carry up to MaxFrameSize - 2 bytes via the SF_DL escape. When disabled every
+ * internal frame buffer stays at 8 bytes.
+ */
+#ifndef MICROUDS_CANFD_ENABLE
+#define MICROUDS_CANFD_ENABLE         0
+#endif
+
+/**
+ * @brief Depth of the per-instance pending request queue (1–255).
+ *
+ * Every complete request (single frame, or reassembled multi-frame) is
+ * queued and served in order by @ref MicroUDS_TimerHandler. When the queue
+ * is full, the new request is answered with NRC 0x21 (busy, repeat request)
+ * instead of overwriting an earlier one.
+ */
+#ifndef MICROUDS_REQ_QUEUE_DEPTH
+#define MICROUDS_REQ_QUEUE_DEPTH      4
+#endif
+
+/**
+ * @brief Default number of requests served per @ref MicroUDS_TimerHandler call.
+ *
+ * Can be overridden per instance with @ref MicroUDS_Conf_t::ReqBudget.
+ */
+#ifndef MICROUDS_REQ_BUDGET
+#define MICROUDS_REQ_BUDGET           MICROUDS_REQ_QUEUE_DEPTH
+#endif
 
+/**
+ * @brief Cache line size, used to keep the producer and consumer indexes
+ * of the receive queue apart.
+ */
+#ifndef MICROUDS_CACHE_LINE_SIZE
+#define MICROUDS_CACHE_LINE_SIZE      64
+#endif
 
 /* -------------------------------------------------------------------------- */
 /*                              Timing Parameters                             */
@@ -73,23 +151,69 @@ extern "C" {
  */
 #define MICROUDS_SERVICE_TIMEOUT_MS   5000
 
+/**
+ * @brief Timeout waiting for the tester's Flow Control frame (N_Bs).
+ *
+ * Applies after a First Frame or the last CF of a block was sent.
+ * On expiry the segmented response is abandoned.
+ *
+ * Unit: milliseconds.
+ */
+#ifndef MICROUDS_TIMEOUT_N_BS_MS
+#define MICROUDS_TIMEOUT_N_BS_MS      1000
+#endif
 
-/* -------------------------------------------------------------------------- */
-/*                           User Callback Functions                          */
-/* -------------------------------------------------------------------------- */
+/**
+ * @brief Server response time P2server.
+ *
+ * A request that is still pending (handler returned NRC 0x78) after
+ * P2 - @ref MICROUDS_P2_MARGIN_MS gets an automatic 0x78 Response-Pending.
+ *
+ * Unit: milliseconds.
+ */
+#ifndef MICROUDS_TIMEOUT_P2_MS
+#define MICROUDS_TIMEOUT_P2_MS        50
+#endif
 
 /**
- * @brief User-defined transmit callback (see @ref MicroUDS_TransmitFunc_t).
+ * @brief Enhanced server response time P2*server.
  *
- * The callback should send a CAN (or similar transport) frame.
- * 
- * Example:
- * @code
- * int MyCAN_Transmit(uint8_t *data, size_t len);
- * #define MICROUDS_TRANSMIT_CB MyCAN_Transmit
- * @endcode
+ * After the first 0x78, Response-Pending is repeated every
+ * P2* - @ref MICROUDS_P2_MARGIN_MS until the request is completed.
+ *
+ * Unit: milliseconds.
+ */
+#ifndef MICROUDS_TIMEOUT_P2_STAR_MS
+#define MICROUDS_TIMEOUT_P2_STAR_MS   5000
+#endif
+
+/**
+ * @brief Upper bound for a pending (NRC 0x78) request.
+ *
+ * A request not completed with @ref MicroUDS_CompleteRequest within this
+ * time is answered with NRC 0x10 (generalReject) and the instance goes
+ * back to serving queued requests; a later completion is rejected.
+ * 0 = wait forever.
+ *
+ * Unit: milliseconds.
+ */
+#ifndef MICROUDS_PENDING_TIMEOUT_MS
+#define MICROUDS_PENDING_TIMEOUT_MS   60000
+#endif
+
+/**
+ * @brief Safety margin subtracted from P2 / P2* so that 0x78 reaches the
+ *        tester before its own timer expires.
+ *
+ * Unit: milliseconds.
  */
-#define MICROUDS_TRANSMIT_CB          NULL
+#ifndef MICROUDS_P2_MARGIN_MS
+#define MICROUDS_P2_MARGIN_MS         10
+#endif
+
+#if MICROUDS_P2_MARGIN_MS >= MICROUDS_TIMEOUT_P2_MS
+#error "MICROUDS_P2_MARGIN_MS must be smaller than MICROUDS_TIMEOUT_P2_MS"
+#endif
 
 
 /* -------------------------------------------------------------------------- */
@@ -97,37 +221,23 @@ extern "C" {
 /* -------------------------------------------------------------------------- */
 
 /**
- * @brief Number of UDS service records available.
- * 
- * This defines how many service entries can be registered in MicroUDS.
- * It also controls memory allocation used by @ref MicroUDS_RegisterService.
+ * @brief Maximum number of UDS services per instance (1–255).
+ *
+ * With heap allocation the service array grows on demand in
+ * @ref MicroUDS_RegisterService up to this limit; in arena mode all
+ * records are reserved in @ref MicroUDS_Init (see @ref MICROUDS_ARENA_SIZE).
  *
- * ⚠️ If this value is too small, service registration may overwrite existing
- * entries or trigger memory corruption.
+ * ⚠️ Services beyond this limit are rejected with MICROUDS_ERR_MEMORY.
  */
-#define MICROUDS_SERVICE_RECORDS      2
+#ifndef MICROUDS_SERVICE_RECORDS
+#define MICROUDS_SERVICE_RECORDS      64
+#endif
 
 
 /* -------------------------------------------------------------------------- */
 /*                              Sanity Checks                                 */
 /* -------------------------------------------------------------------------- */
 
-#ifndef MICROUDS_TRANSMIT_CB
-#warning "MICROUDS_TRANSMIT_CB not defined — defaulting to NULL (no transmission)."
-#define MICROUDS_TRANSMIT_CB NULL
-#else
-/**
- * @brief Extern declaration of user-defined transmit function.
- * 
- * This function must be provided by the application layer.
- * 
- * @param data Pointer to data buffer to transmit.
- * @param len  Number of bytes to transmit.
- * @return 0 on success, non-zero on failure.
- */
-extern int MICROUDS_TRANSMIT_CB(uint8_t *data, size_t len);
-#endif
-
 /**
  * @brief ISO-TP Flow Control (FC) frame configuration
  * 
@@ -158,6 +268,92 @@ extern int MICROUDS_TRANSMIT_CB(uint8_t *data, size_t len);
 #define MICROUDS_FC_STMIN 0x00  /* Default: no delay between frames */
 #endif
 
+/**
+ * @brief Segmented (multi-frame) transmit buffer size in bytes.
+ *
+ * Upper bound of a response sent with @ref MicroUDS_SendMessage. Instances
+ * with a @ref MicroUDS_Conf_t::TxPool use the pool's block size instead.
+ * Responses above 4095 bytes are sent with the 32-bit FF_DL escape
+ * (ISO 15765-2:2016), which the tester must support.
+ */
+#ifndef MICROUDS_TX_BUF_SIZE
+#define MICROUDS_TX_BUF_SIZE 4095
+#endif
+
+/**
+ * @brief Segmented (multi-frame) receive buffer size in bytes.
+ *
+ * Default upper bound of a request reassembled from First / Consecutive
+ * Frames (@ref MicroUDS_Conf_t::RxBufSize overrides it per instance);
+ * longer requests are rejected with NRC 0x14. The buffer is allocated with
+ * the instance unless it borrows buffers from a shared
+ * @ref MicroUDS_Pool_t. Services registered with a chunk callback
+ * (@ref MicroUDS_ServiceTable_t::chunk) are streamed and need no buffer.
+ */
+#ifndef MICROUDS_RX_BUF_SIZE
+#define MICROUDS_RX_BUF_SIZE 4096
+#endif
+
+/**
+ * @brief Maximum number of frames handed to the burst transmit callback at once.
+ *
+ * Only used when @ref MicroUDS_Transport_t::TxBurst is set; sizes the
+ * frame array (on the stack of @ref MicroUDS_TimerHandler) the
+ * Consecutive Frames are segmented into.
+ */
+#ifndef MICROUDS_TX_BURST_MAX
+#define MICROUDS_TX_BURST_MAX 16
+#endif
+
+/**
+ * @brief Maximum number of consecutive FC.WAIT frames accepted (N_WFTmax).
+ *
+ * One more WAIT aborts the segmented transmission.
+ */
+#ifndef MICROUDS_TX_WFT_MAX
+#define MICROUDS_TX_WFT_MAX 10
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/*                                 Statistics                                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Compile in the statistics hooks (@ref MicroUDS_Conf_t::Stats).
+ *
+ * Each hook costs one NULL test, plus a relaxed atomic increment when
+ * the instance has a statistics block. Set to 0 to remove them.
+ */
+#ifndef MICROUDS_STATS_ENABLE
+#define MICROUDS_STATS_ENABLE 1
+#endif
+
+/**
+ * @brief Linear sub-buckets per power of two in the latency histograms, as bits.
+ *
+ * Bucket width is 1 / 2^N of its lower bound. The default 3 gives 240
+ * buckets covering 0 μs to about 71 minutes with a relative error below
+ * 12.5 %.
+ */
+#ifndef MICROUDS_STATS_SUB_BITS
+#define MICROUDS_STATS_SUB_BITS 3
+#endif
+
+#if MICROUDS_STATS_SUB_BITS < 1 || MICROUDS_STATS_SUB_BITS > 8
+#error "MICROUDS_STATS_SUB_BITS must be between 1 and 8"
+#endif
+
+/**
+ * @brief Compile in the frame trace hooks (@ref MicroUDS_Conf_t::Trace).
+ *
+ * Each hook costs one NULL test, plus one ring slot write when the
+ * instance has a trace ring. Set to 0 to remove them.
+ */
+#ifndef MICROUDS_TRACE_ENABLE
+#define MICROUDS_TRACE_ENABLE 1
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,6 +17,14 @@
 #include "stdlib.h"
 #include "Isotp.h"
 #include "MicroHash.h"
+#include <stdatomic.h>
+
+#if MICROUDS_CANFD_ENABLE
+#define MICROUDS_FRAME_MAX ISOTP_CANFD_DL  // 最大帧长度
+#else
+#define MICROUDS_FRAME_MAX ISOTP_CAN_DL    // 最大帧长度
+#endif
+#define MICROUDS_SF_MAX    (MICROUDS_FRAME_MAX > ISOTP_CAN_DL ? MICROUDS_FRAME_MAX - 2 : 7) // 单帧最大报文长度
 
 #ifdef __cplusplus
 extern "C"
@@ -32,6 +40,7 @@ typedef enum
     MICROUDS_ERR_HASH,
     MICROUDS_ERR_PARAM,
     MICROUDS_ERR_TRANS,
+    MICROUDS_ERR_BUSY,
 } MicroUDS_Sta_t;
 
 typedef enum
@@ -180,24 +189,105 @@ typedef enum
     UDS_LINK_CONTROL = 0x87,                 // 链路控制
 } MicroUDS_Sid_t;                            // 服务枚举
 
-typedef enum
-{
-    UDS_ACTIVE_NO,     // 不激活
-    UDS_ACTIVE_SIGNAL, // 单帧激活
-    UDS_ACTIVE_MULTI,  // 多帧激活
-} MicroUDS_Active_t;
-
 //====================================================
 // 函数
 //====================================================
 
 /**
  * @brief 发送函数指针类型
- * @param data 发送的数据
- * @param size 发送的大小
+ * @param user 传输层上下文 (MicroUDS_Conf_t.TransportCtx)
+ * @param data 发送的一帧数据
+ * @param size 帧长度：经典CAN为 8，CAN FD 为合法的 DLC 长度（8/12/16/20/24/32/48/64）
+ * @return 1 : 发送失败 0 : 发送成功
+ */
+typedef int (*MicroUDS_TransmitFunc_t)(void *user, uint8_t *data, size_t size);
+
+typedef struct
+{
+    uint8_t len;                      // 帧长度（8 或 CAN FD DLC 长度）
+    uint8_t data[MICROUDS_FRAME_MAX]; // 帧数据
+} MicroUDS_Frame_t; // 批量发送的一帧
+
+/**
+ * @brief 批量发送函数指针类型（可选）
+ *
+ * STmin = 0 时一次交出当前允许发送的所有连续帧，可直接对应 sendmmsg、
+ * 一次填满多个发送邮箱等
+ *
+ * @param user 传输层上下文 (MicroUDS_Conf_t.TransportCtx)
+ * @param frames 连续存放的帧
+ * @param count 帧数
+ * @return 实际发送（已接受）的帧数，0–count；小于 count 时剩余帧稍后重新交出，负数表示失败
+ */
+typedef int (*MicroUDS_TransmitBurstFunc_t)(void *user, const MicroUDS_Frame_t *frames, size_t count);
+
+/**
+ * @brief 整报文发送函数指针类型（可选，报文模式）
+ *
+ * 传输层自己完成分段与流控（如 Linux CAN_ISOTP 套接字、DoIP）时使用，
+ * 配置后所有响应都以完整报文交出，不再经过 ISO-TP 帧处理
+ *
+ * @param user 传输层上下文 (MicroUDS_Conf_t.TransportCtx)
+ * @param msg 完整的UDS报文（从响应SID开始）
+ * @param len 报文长度
  * @return 1 : 发送失败 0 : 发送成功
  */
-typedef int (*MicroUDS_TransmitFunc_t)(uint8_t *data, size_t size);
+typedef int (*MicroUDS_TransmitMessageFunc_t)(void *user, const uint8_t *msg, size_t len);
+
+/**
+ * @brief 单调时钟函数指针类型（可选）
+ *
+ * @param user 传输层上下文 (MicroUDS_Conf_t.TransportCtx)
+ * @return 当前时刻，单位毫秒，允许回绕
+ */
+typedef uint32_t (*MicroUDS_NowFunc_t)(void *user);
+
+/**
+ * @brief 64位纳秒单调时钟函数指针类型（可选，如 Linux CLOCK_MONOTONIC）
+ *
+ * @param user 传输层上下文 (MicroUDS_Conf_t.TransportCtx)
+ * @return 当前时刻，单位纳秒，不回绕
+ */
+typedef uint64_t (*MicroUDS_NowNsFunc_t)(void *user);
+
+typedef uint64_t MicroUDS_Tick_t; // 内部时基（MICROUDS_TICK_FREQ_HZ 滴答，64位不回绕）
+
+typedef enum
+{
+    MICROUDS_EVENT_RX,       // 请求就绪（或接收队列中有帧），等待处理
+    MICROUDS_EVENT_TX,       // 流控帧允许继续发送连续帧
+    MICROUDS_EVENT_COMPLETE, // 挂起的请求已完成 (MicroUDS_CompleteRequest)
+} MicroUDS_Event_t; // 实例需要 MicroUDS_TimerHandler 处理的事件
+
+/**
+ * @brief 事件通知函数指针类型（可选）
+ *
+ * 实例在 MicroUDS_TimerHandler 之外有了新工作时调用（可能在中断或其他线程中），
+ * 例如写 eventfd 唤醒 epoll；到下一次 MicroUDS_TimerHandler 处理前最多调用一次。
+ * 定时器到期不通知，等待超时取 MicroUDS_NextDeadline
+ *
+ * @param user 通知上下文 (MicroUDS_Conf_t.NotifyCtx)
+ * @param event 事件
+ */
+typedef void (*MicroUDS_NotifyFunc_t)(void *user, MicroUDS_Event_t event);
+
+typedef struct
+{
+    uint32_t Source;     // 本ECU地址：物理请求ID / DoIP逻辑地址
+    uint32_t Target;     // 响应目标：响应ID / 测试仪逻辑地址
+    uint32_t Functional; // 功能寻址地址，0 = 无
+} MicroUDS_Addressing_t; // 寻址信息（仅供查询，内核不使用）
+
+typedef struct
+{
+    MicroUDS_TransmitFunc_t Tx;               // 发送一帧（帧模式必需）
+    MicroUDS_TransmitBurstFunc_t TxBurst;     // 可选，批量发送连续帧
+    MicroUDS_TransmitMessageFunc_t TxMessage; // 可选，报文模式：整报文发送，代替 Tx
+    MicroUDS_NowFunc_t Now;                   // 可选，毫秒时钟；NULL = 使用 MicroUDS_TickHandler 计数
+    MicroUDS_NowNsFunc_t NowNs;               // 可选，纳秒时钟，优先于 Now（亚毫秒 STmin）
+    size_t MaxFrameSize;                      // 发送帧长度 TX_DL：0/8 = 经典CAN，12–64 = CAN FD (需 MICROUDS_CANFD_ENABLE)
+    MicroUDS_Addressing_t Addressing;         // 寻址信息
+} MicroUDS_Transport_t; // 传输层接口（每个实例运行时选择）
 
 /**
  * @brief 通用功能函数
@@ -207,6 +297,63 @@ typedef int (*MicroUDS_TransmitFunc_t)(uint8_t *data, size_t size);
  */
 typedef MicroUDS_NRC_t (*MicroUDS_GeneralFunc_t)(void *param);
 
+typedef struct MicroUDS_Obj MicroUDS_Obj;
+typedef MicroUDS_Obj *MicroUDS_Handle_t; // 句柄
+
+typedef struct
+{
+    uint8_t sid;         // 服务ID
+    uint8_t ssid;        // 子功能（请求只有SID时为0）
+    const uint8_t *data; // SID 之后的请求数据（第一个字节即子功能）
+    size_t len;          // data 长度
+    size_t total;        // 请求数据总长度（不含SID），流式接收时大于 len
+} MicroUDS_Request_t;    // 请求视图（只读，单帧和多帧相同）
+
+typedef struct
+{
+    MicroUDS_TransmitMessageFunc_t Func; // 响应函数，整报文交出；NULL = 经实例传输层发送
+    void *Ctx;                           // 透传给响应函数
+    bool Functional;                     // 功能寻址请求：不发送 NRC 0x11/0x12/0x31/0x7E/0x7F（ISO 14229-1）
+} MicroUDS_Reply_t; // 提交请求的响应去向 (MicroUDS_SubmitRequest)
+
+typedef struct
+{
+    uint8_t *buf; // 直接指向实例发送缓冲区，buf[0] 为 SID + 0x40
+    size_t cap;   // 缓冲区容量
+    size_t len;   // 已写入长度（包含响应SID）
+} MicroUDS_Response_t; // 响应构建器
+
+/**
+ * @brief 带请求视图和响应构建器的处理函数
+ *
+ * 返回 UDS_NRC_SUCCESS 时发送 rsp 中已写入的正响应（自动分段），
+ * 返回其他 NRC 时发送负响应，返回 UDS_NRC_NO 时不响应。
+ * 返回 UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING 时请求挂起，
+ * 由 MicroUDS_CompleteRequest 结束（req 在返回后失效，需要的数据请先拷贝）
+ *
+ * @param handle 实例句柄
+ * @param req 请求
+ * @param rsp 响应构建器，服务级为 [SID+0x40]，子功能级为 [SID+0x40, SSID]
+ * @param param 通用参数Userdata
+ */
+typedef MicroUDS_NRC_t (*MicroUDS_HandlerFunc_t)(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param);
+
+/**
+ * @brief 流式接收回调（可选，按服务注册）
+ *
+ * 多帧请求不再整体缓存：首帧和每个连续帧到达时，新数据直接交给本回调，
+ * 接收完成后再调用服务的处理函数生成响应，此时 req->data 只包含首帧中的数据，
+ * req->len < req->total。单帧请求和整报文输入不经过本回调。
+ * 接收中途失败（序号错误、N_Cs 超时、新的首帧）时不再通知，下一次 offset 为 0 的调用即新请求。
+ *
+ * @param handle 实例句柄
+ * @param chunk 本次数据：sid / ssid 来自首帧，data / len 为新到达的数据，total 为请求数据总长度
+ * @param offset 本次数据在请求数据（SID之后）中的偏移
+ * @param param 通用参数Userdata
+ * @return UDS_NRC_SUCCESS 继续接收；其他 NRC 终止接收并发送负响应（UDS_NRC_NO 时不响应）
+ */
+typedef MicroUDS_NRC_t (*MicroUDS_ChunkFunc_t)(MicroUDS_Handle_t handle, const MicroUDS_Request_t *chunk, size_t offset, void *param);
+
 //====================================================
 // 数据结构
 //====================================================
@@ -216,6 +363,8 @@ typedef struct
     MicroUDS_Sid_t sid; // 通用id
     MicroUDS_GeneralFunc_t func;
     void *param;
+    MicroUDS_HandlerFunc_t handler; // 可选，非NULL时代替 func
+    MicroUDS_ChunkFunc_t chunk;     // 可选，非NULL时多帧请求流式交付，不占用多帧缓冲区
 } MicroUDS_ServiceTable_t; // 注册服务表,用户声明此类型数组来注册sid
 
 typedef struct
@@ -223,61 +372,265 @@ typedef struct
     uint8_t ssid;
     MicroUDS_GeneralFunc_t func;
     void *param;
+    MicroUDS_HandlerFunc_t handler; // 可选，非NULL时代替 func
 } MicroUDS_SessionTable_t; // 注册会话表，用户声明此类型数组来注册ssid
 
-typedef struct MicroUDS_Session_t
+typedef struct
 {
     uint8_t ssid;
     void *param;
     MicroUDS_GeneralFunc_t func;
-    struct MicroUDS_Session_t *next; // 下一个会话 多个会话
+    MicroUDS_HandlerFunc_t handler;
 } MicroUDS_Session_t;
 
 typedef struct
 {
     uint8_t sid;
-    MicroUDS_Session_t *Session; // 会话
+    uint8_t SessionCount;        // 子功能数
+    uint8_t SessionBase[4];      // 位图每个32位字之前的子功能数
+    uint32_t SessionMap[4];      // 128位子功能位图，按 ssid & 0x7F 索引
+    MicroUDS_Session_t *Session; // 子功能，按ssid升序紧凑存放
     void *param;
     MicroUDS_GeneralFunc_t func;
+    MicroUDS_HandlerFunc_t handler;
+    MicroUDS_ChunkFunc_t chunk;  // 流式接收回调
 } Microuds_Service_t; // 服务
 
 typedef struct
 {
-    uint8_t *data;
-    size_t count;
-    size_t size;
-} MicroUDS_Record_t;
-
-typedef struct
-{
-    uint8_t buf[4096];  // 多帧数据缓冲区
-    uint16_t total_len; // FF 中传来的总长度
-    uint16_t recv_len;  // 已接收长度
+    uint8_t *buf;       // 多帧数据缓冲区（实例缓冲区、缓冲池中借用的块或 head），空闲时为 NULL
+    uint32_t total_len; // FF 中传来的总长度
+    uint32_t recv_len;  // 已接收长度
+    uint32_t head_len;  // 流式接收：缓冲区中只保存首帧数据的长度
     uint8_t next_sn;    // 下一个 CF 序号
     bool receiving;     // 是否正在接收多帧
+    bool queued;        // 已接收完成，被请求队列占用
+    Microuds_Service_t *stream; // 流式接收的服务，NULL = 整体缓存
+    uint8_t head[MICROUDS_FRAME_MAX]; // 流式接收的首帧数据
 
 } MicroUDS_MultiFrame_t;
 
 typedef struct
 {
     uint8_t sid;
-    uint16_t data_len;
+    uint32_t data_len;
     uint8_t *data;
 } MicroUDS_MultiInfo_t;
 
 typedef struct
 {
-    Isotp_SingleFrame_t SF;      // 单帧
-    Isotp_FirstFrame_t FF;       // 首帧
-    Isotp_FlowControlFrame_t FC; // 流控帧
-    Isotp_ConsecutiveFrame_t CF; // 连续帧
-} MicroUDS_Isotp_t;
+    uint8_t *blocks;                   // 块存储
+    atomic_uint_least32_t *map;        // 占用位图，1 = 已借出（末尾多余的位恒为 1）
+    size_t words;                      // 位图字数
+    size_t count;                      // 块数
+    size_t block_size;                 // 块大小（按 MICROUDS_ARENA_ALIGN 对齐）
+    atomic_uint_least32_t exhausted;   // 无空闲块导致拒绝的次数
+} MicroUDS_Pool_t; // 多帧缓冲池：接收重组或发送响应（多个实例共享，可跨线程，MicroUDS_PoolInit）
+
+#define MICROUDS_STATS_SUB     (1u << MICROUDS_STATS_SUB_BITS)                        // 每个2的幂区间内的线性子桶数
+#define MICROUDS_STATS_BUCKETS ((33u - MICROUDS_STATS_SUB_BITS) * MICROUDS_STATS_SUB) // 延迟直方图桶数，覆盖 0 – 2^32 μs
+
+typedef enum
+{
+    MICROUDS_STAT_POSITIVE,     // 发送的正响应
+    MICROUDS_STAT_PENDING,      // 挂起 (0x78) 的请求
+    MICROUDS_STAT_BUSY,         // 请求队列或多帧缓冲区被占用，回复 0x21 丢弃的请求
+    MICROUDS_STAT_SEQ_ERROR,    // 多帧序号错误或被新首帧打断
+    MICROUDS_STAT_OVERFLOW,     // 请求超过接收缓冲区，或接收/发送缓冲池已空
+    MICROUDS_STAT_N_CS_TIMEOUT, // 多帧接收超时 (N_Cs)
+    MICROUDS_STAT_S3_TIMEOUT,   // 会话超时，回到默认会话
+    MICROUDS_STAT_RX_DROPPED,   // 接收队列满丢弃的帧
+    MICROUDS_STAT_TX_ERROR,     // 传输层发送失败
+    MICROUDS_STAT_TX_ABORT,     // 分段发送中止（N_Bs 超时、流控溢出、WAIT 过多）
+    MICROUDS_STAT_COUNT,
+} MicroUDS_Stat_t; // 事件计数器
+
+typedef struct
+{
+    atomic_uint_least32_t Counter[MICROUDS_STAT_COUNT];          // 事件计数，按 MicroUDS_Stat_t 索引
+    atomic_uint_least32_t Requests[256];                         // 按SID统计分发的请求
+    atomic_uint_least32_t Nrc[256];                              // 按NRC统计发送的负响应（含 0x78）
+    atomic_uint_least32_t Latency[MICROUDS_STATS_BUCKETS];        // 请求就绪到响应发送的延迟（μs，对数线性分桶）
+    atomic_uint_least32_t PendingLatency[MICROUDS_STATS_BUCKETS]; // 同上，挂起 (0x78) 后完成的请求
+} MicroUDS_Stats_t; // 统计（调用者提供，可被多个实例共享，MicroUDS_StatsInit）
+
+typedef struct
+{
+    uint32_t Counter[MICROUDS_STAT_COUNT];
+    uint32_t Requests[256];
+    uint32_t Nrc[256];
+    uint32_t Latency[MICROUDS_STATS_BUCKETS];
+    uint32_t PendingLatency[MICROUDS_STATS_BUCKETS];
+} MicroUDS_StatsSnapshot_t; // 统计快照，字段同 MicroUDS_Stats_t (MicroUDS_StatsSnapshot)
+
+typedef enum
+{
+    MICROUDS_TRACE_RX,            // 收到的帧 (MicroUDS_ReceiveFrame)
+    MICROUDS_TRACE_TX,            // 发送成功的帧（含流控帧和批量发送）
+    MICROUDS_TRACE_FF,            // 首帧被接受，data = 总长度（4字节大端）
+    MICROUDS_TRACE_SN_ERROR,      // 连续帧序号错误，data = {期望序号, 实际序号}
+    MICROUDS_TRACE_N_CS_ABORT,    // 多帧接收超时，data = 已接收长度、总长度（各4字节大端）
+    MICROUDS_TRACE_SESSION_RESET, // S3 超时回到默认会话，data = {原SID, 原子功能}
+} MicroUDS_TraceKind_t; // 跟踪记录类型
+
+#define MICROUDS_TRACE_FD 0x01u // 记录标志：CAN FD 帧
+
+typedef struct
+{
+    atomic_uint_least32_t seq;        // 写入完成后为 序号 + 1，写入期间为 0
+    uint8_t kind;                     // MicroUDS_TraceKind_t
+    uint8_t len;                      // data 长度
+    uint8_t flags;                    // MICROUDS_TRACE_FD
+    uint32_t id;                      // CAN ID：收到的帧为 Addressing.Source，发送的帧为 Addressing.Target
+    uint64_t ts;                      // 单调时间戳 (ns)
+    uint8_t data[MICROUDS_FRAME_MAX]; // 帧数据或事件参数
+} MicroUDS_TraceRec_t; // 跟踪记录
+
+typedef struct
+{
+    MicroUDS_TraceRec_t *rec;    // 记录数组（调用者提供）
+    uint32_t mask;               // 记录数 - 1（记录数为2的幂）
+    atomic_uint_least32_t head;  // 下一个写入序号，满后覆盖最旧的记录
+    MicroUDS_NowNsFunc_t Clock;  // 可选，时间戳时钟（如周期计数器）；NULL = 实例的时钟源
+    void *ClockCtx;              // 透传给时钟函数
+} MicroUDS_Trace_t; // 跟踪环（无锁，多个实例、中断和线程可同时写入，MicroUDS_TraceInit）
+
+typedef enum
+{
+    MICROUDS_TRACE_CANDUMP, // candump -l 日志格式，事件为 '#' 注释行
+    MICROUDS_TRACE_PCAP,    // pcap，LINKTYPE_CAN_SOCKETCAN (227)，纳秒时间戳，不含事件
+} MicroUDS_TraceFormat_t; // 跟踪导出格式 (MicroUDS_TraceExport)
+
+#define MICROUDS_WHEEL_BITS   6                            // 每层槽位数的位数
+#define MICROUDS_WHEEL_SLOTS  (1u << MICROUDS_WHEEL_BITS)  // 每层槽位数
+#define MICROUDS_WHEEL_LEVELS 4                            // 层数，覆盖 2^24 个滴答
+#define MICROUDS_WHEEL_DUE    0xFFFEu                      // 节点在到期链表中
+#define MICROUDS_WHEEL_RUN    0xFFFFu                      // 节点在正在处理的链表中
+#define MICROUDS_DEADLINE_NONE UINT32_MAX                  // 没有定时任务 (MicroUDS_NextDeadline)
+
+typedef struct MicroUDS_TimerNode
+{
+    struct MicroUDS_TimerNode *next;   // 同一槽位的下一个节点
+    struct MicroUDS_TimerNode **pprev; // 指向前一个节点的 next（或槽头），NULL = 未挂入时间轮
+    uint32_t expires;                  // 到期滴答
+    uint16_t where;                    // 所在槽位：层 * MICROUDS_WHEEL_SLOTS + 槽，或 MICROUDS_WHEEL_DUE / RUN
+} MicroUDS_TimerNode_t; // 时间轮节点（嵌入实例）
+
+typedef struct
+{
+    uint32_t now;                                                            // 已处理到的滴答
+    uint64_t occupied[MICROUDS_WHEEL_LEVELS];                                // 非空槽位图
+    MicroUDS_TimerNode_t *slot[MICROUDS_WHEEL_LEVELS][MICROUDS_WHEEL_SLOTS]; // 各层槽位
+    MicroUDS_TimerNode_t *due;                                               // 已到期，下一次 MicroUDS_WheelRun 处理
+    MicroUDS_TimerNode_t *run;                                               // 正在处理的槽位
+    _Atomic(MicroUDS_Obj *) ready;                                           // 被中断或其他线程唤醒的实例（无锁栈）
+    size_t count;                                                            // 挂入的实例数
+} MicroUDS_Wheel_t; // 分层时间轮（多个实例共享，与这些实例在同一线程中使用，MicroUDS_WheelInit）
+
+typedef struct
+{
+    const MicroUDS_Transport_t *Transport; // 传输层接口（Init 时拷贝）
+    void *TransportCtx;               // 传输层上下文，透传给传输层函数
+    void *UserData;                   // 用户数据 (MicroUDS_GetUserData)
+    void *Arena;                      // 用户内存区，非NULL时实例不使用堆内存 (见 MICROUDS_ARENA_SIZE)
+    size_t ArenaSize;                 // 用户内存区大小
+    size_t ReqBudget;                 // 每次 MicroUDS_TimerHandler 最多处理的请求数，0 = MICROUDS_REQ_BUDGET
+    MicroUDS_Pool_t *RxPool;          // 共享多帧接收缓冲池，非NULL时只在重组期间借用缓冲区 (MicroUDS_PoolInit)
+    size_t RxBufSize;                 // 可接收的最大多帧请求长度，0 = MICROUDS_RX_BUF_SIZE（使用缓冲池时为块大小）
+    MicroUDS_Pool_t *TxPool;          // 共享发送缓冲池，非NULL时只在构建、挂起和分段发送响应期间借用缓冲区（可与 RxPool 相同）
+    MicroUDS_Wheel_t *Wheel;          // 共享时间轮，非NULL时由 MicroUDS_WheelRun 只调度到期的实例
+    MicroUDS_NotifyFunc_t Notify;     // 可选，有新工作时的通知（事件驱动，代替空转轮询）
+    void *NotifyCtx;                  // 透传给通知函数
+    MicroUDS_Stats_t *Stats;          // 可选，统计 (需 MICROUDS_STATS_ENABLE)
+    MicroUDS_Trace_t *Trace;          // 可选，帧跟踪环 (需 MICROUDS_TRACE_ENABLE)
+} MicroUDS_Conf_t;                    // 实例配置
 
 typedef struct
 {
-    uint32_t tick;      // 滴答
-    uint32_t lash_tick; // 上一个滴答
-    uint32_t Timeout; // 超时时间
+    uint8_t *base; // 起始地址，NULL 表示使用堆
+    size_t size;   // 总大小
+    size_t used;   // 已使用
+} MicroUDS_Arena_t; // 内存区
+
+typedef enum
+{
+    MICROUDS_TX_IDLE,    // 空闲
+    MICROUDS_TX_WAIT_FC, // 等待流控帧
+    MICROUDS_TX_SENDING, // 发送连续帧
+} MicroUDS_TxState_t;
+
+typedef struct
+{
+    uint8_t *buf;             // 发送缓冲区，使用发送缓冲池时只在构建、挂起和分段发送响应期间借用，否则为 NULL
+    size_t size;              // 缓冲区容量
+    size_t len;               // 本次发送总长度
+    size_t offset;            // 已发送长度
+    MicroUDS_Tick_t last_tick; // 上一帧（或FC）的时刻
+    uint64_t last_ns;          // 上一连续帧的时刻 (ns)，仅在有纳秒时钟时用于 STmin
+    uint8_t sn;               // 下一个 CF 序号
+    uint8_t bs;               // 测试仪 FC 的块大小，0 = 不限
+    uint8_t bs_count;         // 当前块已发送的 CF 数
+    uint8_t stmin;            // 测试仪 FC 的 STmin 原始值
+    uint8_t wft;              // 已收到的 WAIT 次数
+    MicroUDS_TxState_t state; // 状态
+} MicroUDS_Tx_t;              // 分段发送
+
+typedef struct
+{
+    uint8_t data[MICROUDS_SF_MAX]; // 单帧请求（完整拷贝）
+    uint32_t len;    // 请求长度
+    bool multi;      // 请求在多帧缓冲区中
+    bool functional; // 功能寻址请求
+    uint64_t at;     // 就绪时刻（μs，统计延迟用）
+} MicroUDS_ReqEntry_t; // 排队的请求
+
+typedef struct
+{
+    MicroUDS_ReqEntry_t entry[MICROUDS_REQ_QUEUE_DEPTH];
+    uint8_t head;  // 队首
+    uint8_t count; // 排队数
+} MicroUDS_ReqQueue_t; // 请求队列
+
+#if MICROUDS_RX_QUEUE_DEPTH
+typedef struct
+{
+    atomic_uint_least32_t head;  // 生产者（接收中断/线程）写入位置
+    uint8_t pad0[MICROUDS_CACHE_LINE_SIZE];
+    atomic_uint_least32_t tail;  // 消费者（MicroUDS_TimerHandler）读取位置
+    uint8_t pad1[MICROUDS_CACHE_LINE_SIZE];
+    atomic_uint_least32_t dropped; // 队列满丢弃的帧数
+    uint8_t frame[MICROUDS_RX_QUEUE_DEPTH][MICROUDS_FRAME_MAX]; // 原始帧
+    uint8_t len[MICROUDS_RX_QUEUE_DEPTH];                       // 帧长度
+} MicroUDS_RxQueue_t; // 单生产者单消费者无锁接收队列
+#endif
+
+typedef enum
+{
+    MICROUDS_PENDING_CLOSED,  // 没有可完成的请求，MicroUDS_CompleteRequest 被拒绝
+    MICROUDS_PENDING_OPEN,    // 处理函数运行中或请求挂起，接受 MicroUDS_CompleteRequest
+    MICROUDS_PENDING_FILLING, // MicroUDS_CompleteRequest 正在写入最终响应
+    MICROUDS_PENDING_DONE,    // 已完成，由 MicroUDS_TimerHandler 发送最终响应
+} MicroUDS_PendingState_t;    // 挂起请求的完成状态（跨线程）
+
+typedef struct
+{
+    bool active;                // 有请求等待 MicroUDS_CompleteRequest
+    uint8_t sid;                // 挂起请求的SID
+    uint8_t ssid;               // 挂起请求的子功能
+    MicroUDS_Tick_t start;      // 挂起的时刻（MICROUDS_PENDING_TIMEOUT_MS）
+    MicroUDS_Tick_t last_tick;  // 请求开始或上一次发送0x78的时刻
+    MicroUDS_Tick_t interval;   // 下一次发送0x78前的等待时间（P2，之后为P2*）
+    MicroUDS_NRC_t nrc;         // 最终结果
+    size_t len;                 // 最终正响应长度（已在发送缓冲区中）
+    MicroUDS_Reply_t reply;     // 响应去向
+    atomic_uint_least8_t state; // MicroUDS_PendingState_t
+} MicroUDS_Pending_t;           // 挂起（Response-Pending）的请求
+
+typedef struct
+{
+    MicroUDS_Tick_t tick;      // 滴答
+    MicroUDS_Tick_t lash_tick; // 上一个滴答
+    MicroUDS_Tick_t Timeout;   // 超时时间
     bool Active;        // 是否激活定时器
 } MicroUDS_N_Cs_t;      // N_Cs定时器
 
@@ -285,28 +638,135 @@ typedef struct
 // 对象
 //====================================================
 
-typedef struct
+struct MicroUDS_Obj
 {
-    volatile uint32_t Tick; // 时基
-    uint32_t Timeout;       // 超时时间
-    uint32_t last_time;
+    MicroUDS_Tick_t Tick;        // 时基（每次 MicroUDS_TimerHandler 从时钟源更新）
+    volatile uint32_t TickCount; // MicroUDS_TickHandler 计数（可在中断中递增）
+    uint32_t ClockLast;          // 上一次读取的32位时钟（TickCount / Now / 时间轮），扩展为64位
+    uint64_t ClockMs;            // Now 扩展后的毫秒数
+    MicroUDS_Tick_t Timeout;     // 超时时间
+    MicroUDS_Tick_t last_time;
+#if MICROUDS_DISPATCH_TABLE
+    uint8_t Dispatch[256];        // SID直接索引表，0 = 未注册，n = Services[n - 1]
+#else
     MicroHash_Handle_t hashTable; // 哈希表
+#endif
     volatile uint8_t sid;         // 当前sid
     volatile uint8_t ssid;        // 当前会话
-    MicroUDS_TransmitFunc_t Transmit;
-    MicroUDS_Record_t Record;         // 记录
-    MicroUDS_Isotp_t Recbuf;          // 接收帧缓冲区
+    MicroUDS_Transport_t Transport;   // 传输层接口
+    void *TransportCtx;               // 传输层上下文
+    void *UserData;                   // 用户数据
+    MicroUDS_Arena_t Arena;           // 内存区
+    size_t FrameLen;                  // 帧长度 TX_DL（8 或 CAN FD 长度）
+    MicroUDS_Pool_t *RxPool;          // 共享多帧接收缓冲池，NULL = 使用 RxBuf
+    uint8_t *RxBuf;                   // 实例独占的多帧接收缓冲区（未使用缓冲池时）
+    size_t RxBufSize;                 // 可接收的最大多帧请求长度
+    MicroUDS_Pool_t *TxPool;          // 共享发送缓冲池，NULL = 实例独占的发送缓冲区
+    Microuds_Service_t *Services;     // 服务数组（连续存储）
+    size_t ServiceCount;              // 已注册服务数
+    size_t ServiceSize;               // 服务数组容量
     MicroUDS_MultiFrame_t MultiFrame; // 多帧
-    MicroUDS_Active_t active;         // 活动
+    MicroUDS_ReqQueue_t ReqQueue;     // 请求队列
+    size_t ReqBudget;                 // 每次调用最多处理的请求数
+    MicroUDS_Tx_t Tx;                 // 多帧发送
+    MicroUDS_Pending_t Pending;       // 挂起的请求
+    MicroUDS_Reply_t Reply;           // 当前请求的响应去向，Func 为 NULL 时经传输层发送
+#if MICROUDS_RX_QUEUE_DEPTH
+    MicroUDS_RxQueue_t RxQueue;       // 接收队列
+#endif
     MicroUDS_EcuSta_t Ecu_sta;        // ecu状态
     volatile MicroUDS_N_Cs_t N_Cs;    // N_Cs监控
-} MicroUDS_Obj;
+    MicroUDS_Tick_t Deadline;         // 下一次需要处理的滴答（Armed 时有效）
+    bool Armed;                       // 有定时任务，false 时只有新帧或完成的挂起请求才需要处理
+    MicroUDS_Wheel_t *Wheel;          // 共享时间轮，NULL = 调用者自行轮询
+    MicroUDS_TimerNode_t Timer;       // 时间轮节点
+    atomic_bool Woken;                // 已在时间轮的唤醒栈中
+    MicroUDS_Obj *WakeNext;           // 唤醒栈中的下一个实例
+    MicroUDS_NotifyFunc_t Notify;     // 事件通知，NULL = 不通知
+    void *NotifyCtx;                  // 通知上下文
+    atomic_bool Notified;             // 已通知或正在 MicroUDS_TimerHandler 中，抑制重复通知
+    MicroUDS_Stats_t *Stats;          // 统计，NULL = 不统计
+    uint64_t ReqAt;                   // 当前请求就绪的时刻 (μs)
+    bool ReqTimed;                    // 当前请求尚未响应，响应时记录延迟
+    bool ReqPended;                   // 当前请求已挂起 (0x78)
+    MicroUDS_Trace_t *Trace;          // 帧跟踪环，NULL = 不跟踪
+};
 
 //====================================================
-// 句柄
+// 内存区
 //====================================================
 
-typedef MicroUDS_Obj *MicroUDS_Handle_t;
+/**
+ * @brief Alignment of every allocation taken from an instance arena.
+ */
+#define MICROUDS_ARENA_ALIGN    8u
+
+/**
+ * @brief Rounds @p x up to @ref MICROUDS_ARENA_ALIGN.
+ */
+#define MICROUDS_ALIGN(x)       (((x) + (MICROUDS_ARENA_ALIGN - 1u)) & ~((size_t)MICROUDS_ARENA_ALIGN - 1u))
+
+/**
+ * @brief Arena size needed by one instance in zero-heap mode.
+ *
+ * @param nsub Total number of sub-functions registered over all services,
+ *             each SID registered with one @ref MicroUDS_RegisterSession call.
+ *
+ * Example:
+ * @code
+ * static uint8_t arena[MICROUDS_ARENA_SIZE(8)];
+ * static MicroUDS_Obj ecu;
+ * MicroUDS_Conf_t conf = { .Transport = &can, .Arena = arena, .ArenaSize = sizeof(arena) };
+ * MicroUDS_Init(&ecu, &conf);
+ * @endcode
+ */
+#define MICROUDS_ARENA_SIZE(nsub) MICROUDS_ARENA_SIZE_RX(nsub, MICROUDS_RX_BUF_SIZE)
+
+/**
+ * @brief Arena size with an explicit receive buffer size.
+ *
+ * @param nsub See @ref MICROUDS_ARENA_SIZE.
+ * @param rx @ref MicroUDS_Conf_t::RxBufSize, or 0 when the instance
+ *           borrows its receive buffers from a @ref MicroUDS_Pool_t.
+ */
+#define MICROUDS_ARENA_SIZE_RX(nsub, rx) MICROUDS_ARENA_SIZE_BUF(nsub, rx, MICROUDS_TX_BUF_SIZE)
+
+/**
+ * @brief Arena size with explicit receive and transmit buffer sizes.
+ *
+ * @param nsub See @ref MICROUDS_ARENA_SIZE.
+ * @param rx See @ref MICROUDS_ARENA_SIZE_RX.
+ * @param tx @ref MICROUDS_TX_BUF_SIZE, or 0 when the instance borrows its
+ *           transmit buffer from a @ref MicroUDS_Conf_t::TxPool.
+ */
+#define MICROUDS_ARENA_SIZE_BUF(nsub, rx, tx)                              \
+    (MICROUDS_ARENA_ALIGN +                                                \
+     MICROUDS_ALIGN(MICROUDS_SERVICE_RECORDS * sizeof(Microuds_Service_t)) + \
+     MICROUDS_SERVICE_RECORDS * MICROUDS_ARENA_ALIGN +                     \
+     MICROUDS_ALIGN(tx) +                                                  \
+     MICROUDS_ALIGN(rx) +                                                  \
+     (nsub) * sizeof(MicroUDS_Session_t))
+
+/**
+ * @brief Memory needed by a buffer pool (see @ref MicroUDS_PoolInit).
+ *
+ * @param blocks Number of buffers, i.e. concurrent multi-frame receptions
+ *               (RxPool) or responses being built / sent (TxPool).
+ * @param block_size Size of each buffer (largest request accepted, or
+ *                   largest response sent).
+ *
+ * Example:
+ * @code
+ * static uint8_t pool_mem[MICROUDS_POOL_SIZE(64, 4096)];
+ * static MicroUDS_Pool_t pool;
+ * MicroUDS_PoolInit(&pool, pool_mem, sizeof(pool_mem), 4096);
+ * MicroUDS_Conf_t conf = { .Transport = &can, .RxPool = &pool };
+ * @endcode
+ */
+#define MICROUDS_POOL_SIZE(blocks, block_size)                                   \
+    (MICROUDS_ARENA_ALIGN +                                                      \
+     MICROUDS_ALIGN((((blocks) + 31u) / 32u) * sizeof(atomic_uint_least32_t)) + \
+     (blocks) * MICROUDS_ALIGN(block_size))
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,125 @@
+#ifndef MICROUDS_CANISOTP_H
+#define MICROUDS_CANISOTP_H
+
+/**
+ * @file Microuds_canisotp.h
+ * @author https://github.com/xfp23
+ * @brief Linux kernel ISO-TP (CAN_ISOTP, Linux 5.10+) transport for MicroUDS.
+ *
+ * The kernel segments, reassembles and handles Flow Control; MicroUDS only
+ * sees complete requests (@ref MicroUDS_SubmitRequest) and hands back whole
+ * responses (@ref MicroUDS_Transport_t::TxMessage). One wakeup per message
+ * instead of one per frame. When CAN_ISOTP is not available, fall back to the
+ * frame-level port in port/SocketCan.
+ *
+ * @version 0.1
+ * @date 2025-10-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "Microuds.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Receive buffer size: largest request accepted from the socket.
+ */
+#ifndef MICROUDS_CANISOTP_RX_SIZE
+#define MICROUDS_CANISOTP_RX_SIZE 4096
+#endif
+
+typedef struct
+{
+    const char *IfName;  // CAN 接口名，如 "vcan0"
+    uint32_t RxId;       // 物理寻址请求ID（测试仪 -> ECU）
+    uint32_t FuncId;     // 功能寻址请求ID，如 0x7DF，0 = 不接收
+    uint32_t TxId;       // 响应ID（ECU -> 测试仪）
+    bool Extended;       // 使用 29 位扩展帧ID
+    bool CanFd;          // CAN FD 链路（TX_DL = 64）
+    uint8_t Bs;          // 接收时回复的 FC 块大小
+    uint8_t STmin;       // 接收时回复的 FC STmin
+} MicroUDS_CanIsotpConf_t; // CAN_ISOTP 配置
+
+typedef struct
+{
+    int Fd;                 // 物理寻址 ISO-TP 套接字（收发）
+    int FuncFd;             // 功能寻址 ISO-TP 套接字（只收），-1 = 未使用
+    int EpollFd;            // epoll 实例
+    int WakeFd;             // eventfd，实例的事件通知在此唤醒 epoll
+    MicroUDS_Handle_t Uds;  // 绑定的 MicroUDS 实例
+    uint64_t RxMessages;    // 接收报文数
+    uint64_t TxMessages;    // 发送报文数
+    uint64_t TxErrors;      // 发送失败次数
+    MicroUDS_Transport_t Transport; // 传输层接口（Open 时填写）
+    uint8_t Rx[MICROUDS_CANISOTP_RX_SIZE]; // 接收缓冲区
+} MicroUDS_CanIsotp_t; // CAN_ISOTP 端口
+
+/**
+ * @brief Open the kernel ISO-TP sockets.
+ *
+ * Creates the physical socket (RxId/TxId) and, if FuncId is set, a
+ * receive-only functional socket, applies FC/padding/link-layer options
+ * and registers both, plus a wake-up eventfd, with a private epoll instance.
+ *
+ * @param port Port object (caller storage).
+ * @param conf Port configuration.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Sockets ready.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR: A socket call failed, e.g. CAN_ISOTP is not available (see errno).
+ */
+extern MicroUDS_Sta_t MicroUDS_CanIsotp_Open(MicroUDS_CanIsotp_t *port, const MicroUDS_CanIsotpConf_t *conf);
+
+/**
+ * @brief Fill the transport fields of an instance configuration.
+ *
+ * Points Transport / TransportCtx at this port so every response is
+ * written to the socket as one message and CLOCK_MONOTONIC drives the
+ * instance timers, and Notify / NotifyCtx at the port's eventfd. Call
+ * before @ref MicroUDS_Create, then @ref MicroUDS_CanIsotp_Bind with the
+ * created handle.
+ *
+ * @param port Opened port.
+ * @param conf Instance configuration to fill.
+ */
+extern void MicroUDS_CanIsotp_Attach(MicroUDS_CanIsotp_t *port, MicroUDS_Conf_t *conf);
+
+/**
+ * @brief Bind the instance that receives this port's requests.
+ *
+ * @param port Opened port.
+ * @param handle MicroUDS instance created with an attached configuration.
+ */
+extern void MicroUDS_CanIsotp_Bind(MicroUDS_CanIsotp_t *port, MicroUDS_Handle_t handle);
+
+/**
+ * @brief Wait for requests and queue them in the bound instance.
+ *
+ * Call from the same thread as @ref MicroUDS_TimerHandler. The wait also
+ * ends when the bound instance notifies new work (e.g. a request
+ * completed on another thread) and never lasts past the instance's
+ * @ref MicroUDS_NextDeadline.
+ *
+ * @param port Opened and bound port.
+ * @param timeout_ms epoll timeout (0 = poll, -1 = wait for traffic or the next deadline).
+ * @return int Number of requests received, or -1 on error (see errno).
+ */
+extern int MicroUDS_CanIsotp_Poll(MicroUDS_CanIsotp_t *port, int timeout_ms);
+
+/**
+ * @brief Close the sockets and the epoll instance.
+ *
+ * @param port Port object.
+ */
+extern void MicroUDS_CanIsotp_Close(MicroUDS_CanIsotp_t *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,296 @@
+#include "Microuds_canisotp.h"
+#include "Microuds_com.h"
+#include <errno.h>
+#include <linux/can.h>
+#include <linux/can/isotp.h>
+#include <net/if.h>
+#include <stddef.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief 创建并绑定一个 ISO-TP 套接字
+ *
+ * @param conf 端口配置
+ * @param rx_id 接收ID
+ * @return int 套接字，失败返回 -1
+ */
+static int CanIsotp_Socket(const MicroUDS_CanIsotpConf_t *conf, uint32_t rx_id)
+{
+    canid_t eff = conf->Extended ? CAN_EFF_FLAG : 0;
+    int fd = socket(PF_CAN, SOCK_DGRAM | SOCK_CLOEXEC, CAN_ISOTP);
+    if (fd < 0)
+        return -1;
+
+    /* 发送填充与仓库其他部分一致：0x00 */
+    struct can_isotp_options opts = {
+        .flags = CAN_ISOTP_TX_PADDING,
+        .txpad_content = 0x00,
+    };
+    struct can_isotp_fc_options fc = {
+        .bs = conf->Bs,
+        .stmin = conf->STmin,
+        .wftmax = 0,
+    };
+
+    if (setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &opts, sizeof(opts)) < 0 ||
+        setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_RECV_FC, &fc, sizeof(fc)) < 0)
+        goto fail;
+
+    if (conf->CanFd)
+    {
+        struct can_isotp_ll_options ll = {
+            .mtu = CANFD_MTU,
+            .tx_dl = CANFD_MAX_DLEN,
+            .tx_flags = CANFD_BRS,
+        };
+        if (setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_LL_OPTS, &ll, sizeof(ll)) < 0)
+            goto fail;
+    }
+
+    struct ifreq ifr = {0};
+    strncpy(ifr.ifr_name, conf->IfName, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+        goto fail;
+
+    struct sockaddr_can addr = {
+        .can_family = AF_CAN,
+        .can_ifindex = ifr.ifr_ifindex,
+    };
+    addr.can_addr.tp.rx_id = rx_id | eff;
+    addr.can_addr.tp.tx_id = conf->TxId | eff;
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        goto fail;
+
+    return fd;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+static int CanIsotp_TransmitMessage(void *user, const uint8_t *msg, size_t len)
+{
+    MicroUDS_CanIsotp_t *port = (MicroUDS_CanIsotp_t *)user;
+
+    /* 内核完成分段和流控；write 返回时报文已交给内核 */
+    if (write(port->Fd, msg, len) != (ssize_t)len)
+    {
+        port->TxErrors++;
+        return 1;
+    }
+
+    port->TxMessages++;
+    return 0;
+}
+
+static uint64_t CanIsotp_Now(void *user)
+{
+    struct timespec ts;
+
+    (void)user;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 实例的事件通知：写 eventfd 唤醒 MicroUDS_CanIsotp_Poll（可在其他线程中调用）
+ */
+static void CanIsotp_Notify(void *user, MicroUDS_Event_t event)
+{
+    MicroUDS_CanIsotp_t *port = (MicroUDS_CanIsotp_t *)user;
+    uint64_t one = 1;
+
+    (void)event;
+    ssize_t ret = write(port->WakeFd, &one, sizeof(one));
+    (void)ret; // 计数器已满时 epoll 仍然可读
+}
+
+/**
+ * @brief 等待超时不超过实例的下一个截止时刻
+ */
+static int CanIsotp_Timeout(MicroUDS_CanIsotp_t *port, int timeout_ms)
+{
+    uint32_t next = MicroUDS_NextDeadline(port->Uds);
+
+    if (next == MICROUDS_DEADLINE_NONE || (timeout_ms >= 0 && (uint32_t)timeout_ms <= next))
+        return timeout_ms;
+
+    return next > INT32_MAX ? INT32_MAX : (int)next;
+}
+
+/**
+ * @brief 读空一个套接字中的所有报文，功能寻址套接字 (FuncFd) 的报文按功能寻址请求处理
+ *
+ * @return int 报文数，出错返回 -1
+ */
+static int CanIsotp_Drain(MicroUDS_CanIsotp_t *port, int fd)
+{
+    int count = 0;
+
+    for (;;)
+    {
+        ssize_t n = recv(fd, port->Rx, sizeof(port->Rx), MSG_DONTWAIT);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return count;
+            if (errno == EILSEQ || errno == ETIMEDOUT || errno == EBADMSG || errno == ECOMM)
+                continue; // 内核报告的 ISO-TP 协议错误（序号错误、N_Cr 超时等），丢弃该报文
+            return -1;
+        }
+
+        if (n == 0)
+            continue;
+
+        /* 直接在接收缓冲区上分发，实例忙时排队；功能寻址套接字的请求由内核抑制相应的NRC */
+        const MicroUDS_Reply_t reply = {.Functional = fd == port->FuncFd};
+        if (MicroUDS_SubmitRequest(port->Uds, port->Rx, (size_t)n, &reply) == MICROUDS_ERR_BUSY)
+        {
+            if (reply.Functional)
+                MicroUDS_ReceiveFunctional(port->Uds, port->Rx, (size_t)n);
+            else
+                MicroUDS_ReceiveMessage(port->Uds, port->Rx, (size_t)n);
+        }
+        port->RxMessages++;
+        count++;
+    }
+}
+
+MicroUDS_Sta_t MicroUDS_CanIsotp_Open(MicroUDS_CanIsotp_t *port, const MicroUDS_CanIsotpConf_t *conf)
+{
+    MICROUDS_CHECKPTR(port);
+    MICROUDS_CHECKPTR(conf);
+
+    if (conf->IfName == NULL || conf->RxId == 0)
+        return MICROUDS_ERR_PARAM;
+
+    memset(port, 0, offsetof(MicroUDS_CanIsotp_t, Rx));
+    port->Fd = -1;
+    port->FuncFd = -1;
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+
+    port->Transport.TxMessage = CanIsotp_TransmitMessage;
+    port->Transport.NowNs = CanIsotp_Now;
+    port->Transport.MaxFrameSize = conf->CanFd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    port->Transport.Addressing.Source = conf->RxId;
+    port->Transport.Addressing.Target = conf->TxId;
+    port->Transport.Addressing.Functional = conf->FuncId;
+
+    port->Fd = CanIsotp_Socket(conf, conf->RxId);
+    if (port->Fd < 0)
+        goto fail;
+
+    if (conf->FuncId != 0)
+    {
+        port->FuncFd = CanIsotp_Socket(conf, conf->FuncId); // 功能寻址只接收单帧请求，响应走物理通道
+        if (port->FuncFd < 0)
+            goto fail;
+    }
+
+    port->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (port->EpollFd < 0)
+        goto fail;
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = port->Fd};
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->Fd, &ev) < 0)
+        goto fail;
+
+    if (port->FuncFd >= 0)
+    {
+        ev.data.fd = port->FuncFd;
+        if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->FuncFd, &ev) < 0)
+            goto fail;
+    }
+
+    port->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (port->WakeFd < 0)
+        goto fail;
+
+    ev.data.fd = port->WakeFd;
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->WakeFd, &ev) < 0)
+        goto fail;
+
+    return MICROUDS_OK;
+
+fail:
+    MicroUDS_CanIsotp_Close(port);
+    return MICROUDS_ERR;
+}
+
+void MicroUDS_CanIsotp_Attach(MicroUDS_CanIsotp_t *port, MicroUDS_Conf_t *conf)
+{
+    if (port == NULL || conf == NULL)
+        return;
+
+    conf->Transport = &port->Transport;
+    conf->TransportCtx = port;
+    conf->Notify = CanIsotp_Notify;
+    conf->NotifyCtx = port;
+}
+
+void MicroUDS_CanIsotp_Bind(MicroUDS_CanIsotp_t *port, MicroUDS_Handle_t handle)
+{
+    if (port != NULL)
+        port->Uds = handle;
+}
+
+int MicroUDS_CanIsotp_Poll(MicroUDS_CanIsotp_t *port, int timeout_ms)
+{
+    if (port == NULL || port->Fd < 0 || port->Uds == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct epoll_event ev[3];
+    int ready = epoll_wait(port->EpollFd, ev, 3, CanIsotp_Timeout(port, timeout_ms));
+    if (ready <= 0)
+        return ready < 0 && errno == EINTR ? 0 : ready;
+
+    int total = 0;
+
+    for (int i = 0; i < ready; i++)
+    {
+        if (ev[i].data.fd == port->WakeFd)
+        {
+            uint64_t count;
+            ssize_t ret = read(port->WakeFd, &count, sizeof(count)); // 清除通知，调用者随后调用 MicroUDS_TimerHandler
+            (void)ret;
+            continue;
+        }
+
+        int n = CanIsotp_Drain(port, ev[i].data.fd);
+        if (n < 0)
+            return -1;
+        total += n;
+    }
+
+    return total;
+}
+
+void MicroUDS_CanIsotp_Close(MicroUDS_CanIsotp_t *port)
+{
+    if (port == NULL)
+        return;
+
+    if (port->EpollFd >= 0)
+        close(port->EpollFd);
+    if (port->WakeFd >= 0)
+        close(port->WakeFd);
+    if (port->FuncFd >= 0)
+        close(port->FuncFd);
+    if (port->Fd >= 0)
+        close(port->Fd);
+
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+    port->FuncFd = -1;
+    port->Fd = -1;
+}
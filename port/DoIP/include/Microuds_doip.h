@@ -0,0 +1,172 @@
+#ifndef MICROUDS_DOIP_H
+#define MICROUDS_DOIP_H
+
+/**
+ * @file Microuds_doip.h
+ * @author https://github.com/xfp23
+ * @brief DoIP (ISO 13400-2) server transport for MicroUDS.
+ *
+ * One DoIP entity on non-blocking sockets driven by epoll:
+ * - UDP 13400: vehicle announcement after start-up, vehicle identification
+ *   requests (plain / by EID / by VIN), entity status and power mode.
+ * - TCP 13400: one tester connection, routing activation, alive check and
+ *   diagnostic messages (0x8001) acknowledged with 0x8002 / 0x8003.
+ *
+ * Diagnostic messages are dispatched whole from the receive buffer
+ * (@ref MicroUDS_SubmitRequest, queued with @ref MicroUDS_ReceiveMessage
+ * while the instance is busy) and responses leave whole through the
+ * port's @ref MicroUDS_Transport_t::TxMessage; there is no ISO-TP framing.
+ * Messages to the functional address are passed on as functional requests
+ * (@ref MicroUDS_Reply_t::Functional), so the core drops the NRCs
+ * ISO 14229-1 suppresses for them.
+ * Everything runs on localhost for testing.
+ *
+ * @version 0.1
+ * @date 2025-10-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "Microuds.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief UDP / TCP port of a DoIP entity.
+ */
+#define MICROUDS_DOIP_PORT 13400
+
+/**
+ * @brief Largest diagnostic message payload accepted on TCP (SA + TA + UDS data).
+ *
+ * Reported as "max data size" in the entity status response. Longer
+ * messages are rejected with a generic header NACK (message too large).
+ * Requests are dispatched in place (@ref MicroUDS_SubmitRequest), so this
+ * is not bound by the instance's multi-frame buffer while it is idle.
+ */
+#ifndef MICROUDS_DOIP_MAX_DATA
+#define MICROUDS_DOIP_MAX_DATA (4u + 65536u)
+#endif
+
+/**
+ * @brief TCP transmit buffer size (acknowledges + responses not yet written).
+ */
+#ifndef MICROUDS_DOIP_TX_SIZE
+#define MICROUDS_DOIP_TX_SIZE (2u * (12u + MICROUDS_TX_BUF_SIZE))
+#endif
+
+typedef struct
+{
+    const char *BindAddr;       // 监听地址，NULL = 全部接口
+    const char *AnnounceAddr;   // 车辆声明目标地址，NULL = 255.255.255.255
+    uint16_t Port;              // UDP / TCP 端口，0 = 13400
+    uint16_t LogicalAddr;       // 本实体逻辑地址
+    uint16_t FuncAddr;          // 功能寻址逻辑地址，0 = 0xE400
+    const char *Vin;            // 17 位 VIN，NULL = 未配置 (0xFF 填充)
+    uint8_t Eid[6];             // 实体标识（一般为 MAC 地址）
+    uint8_t Gid[6];             // 组标识
+    uint8_t AnnounceCount;      // 启动后发送的车辆声明次数，0 = 3
+    uint16_t AnnounceIntervalMs; // 车辆声明间隔，0 = 500 ms
+} MicroUDS_DoIPConf_t; // DoIP 配置
+
+typedef struct
+{
+    int UdpFd;                  // UDP 套接字（声明、车辆识别）
+    int ListenFd;               // TCP 监听套接字
+    int ClientFd;               // 测试仪 TCP 连接，-1 = 无
+    int EpollFd;                // epoll 实例
+    int WakeFd;                 // eventfd，实例的事件通知在此唤醒 epoll
+    MicroUDS_Handle_t Uds;      // 绑定的 MicroUDS 实例
+    MicroUDS_Transport_t Transport; // 传输层接口（Open 时填写）
+    uint16_t LogicalAddr;       // 本实体逻辑地址
+    uint16_t FuncAddr;          // 功能寻址逻辑地址
+    uint16_t TesterAddr;        // 已激活路由的测试仪地址
+    bool Active;                // 路由已激活
+    bool TxWait;                // 发送缓冲区未写完，等待 EPOLLOUT
+    uint8_t Vin[17];            // VIN
+    uint8_t Eid[6];             // EID
+    uint8_t Gid[6];             // GID
+    uint8_t AnnounceLeft;       // 剩余车辆声明次数
+    uint16_t AnnounceIntervalMs; // 车辆声明间隔
+    uint64_t AnnounceAt;        // 下一次车辆声明时刻 (ms)
+    uint64_t ClientAt;          // 连接建立 / 最近一次收到数据的时刻 (ms)
+    uint32_t AnnounceIp;        // 车辆声明目标地址（网络字节序）
+    uint16_t UdpPort;           // 车辆声明目标端口（网络字节序）
+    size_t RxLen;               // 当前 TCP 报文已接收长度（含报文头）
+    size_t RxSkip;              // 需丢弃的超长负载字节数
+    size_t TxLen;               // 发送缓冲区中的字节数
+    uint64_t RxMessages;        // 交给实例的诊断报文数
+    uint64_t TxMessages;        // 发送的诊断响应数
+    uint64_t TxErrors;          // 发送失败次数（连接断开、发送缓冲区满）
+    uint8_t *Rx;                // TCP 接收缓冲区（报文头 + 负载）
+    uint8_t *Tx;                // TCP 发送缓冲区
+} MicroUDS_DoIP_t; // DoIP 端口
+
+/**
+ * @brief Open the UDP and TCP sockets.
+ *
+ * Binds UDP and TCP to the configured port, starts listening and
+ * schedules the first vehicle announcement for the next
+ * @ref MicroUDS_DoIP_Poll call.
+ *
+ * @param port Port object (caller storage).
+ * @param conf Port configuration.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Sockets ready.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR_MEMORY: Buffers could not be allocated.
+ * - MICROUDS_ERR: A socket call failed (see errno).
+ */
+extern MicroUDS_Sta_t MicroUDS_DoIP_Open(MicroUDS_DoIP_t *port, const MicroUDS_DoIPConf_t *conf);
+
+/**
+ * @brief Fill the transport fields of an instance configuration.
+ *
+ * Points Transport / TransportCtx at this port (message mode,
+ * CLOCK_MONOTONIC clock) and Notify / NotifyCtx at the port's eventfd.
+ * Call before @ref MicroUDS_Create, then @ref MicroUDS_DoIP_Bind with the
+ * created handle.
+ *
+ * @param port Opened port.
+ * @param conf Instance configuration to fill.
+ */
+extern void MicroUDS_DoIP_Attach(MicroUDS_DoIP_t *port, MicroUDS_Conf_t *conf);
+
+/**
+ * @brief Bind the instance that receives this port's diagnostic messages.
+ *
+ * @param port Opened port.
+ * @param handle MicroUDS instance created with an attached configuration.
+ */
+extern void MicroUDS_DoIP_Bind(MicroUDS_DoIP_t *port, MicroUDS_Handle_t handle);
+
+/**
+ * @brief Serve UDP / TCP traffic and the DoIP timers.
+ *
+ * Call from the same thread as @ref MicroUDS_TimerHandler. The wait also
+ * ends when the bound instance notifies new work (e.g. a request
+ * completed on another thread) and never lasts past the next vehicle
+ * announcement, TCP inactivity timeout or @ref MicroUDS_NextDeadline.
+ *
+ * @param port Opened and bound port.
+ * @param timeout_ms epoll timeout (0 = poll, -1 = wait for traffic or the next deadline).
+ * @return int Number of diagnostic messages handed to the instance, or -1 on error (see errno).
+ */
+extern int MicroUDS_DoIP_Poll(MicroUDS_DoIP_t *port, int timeout_ms);
+
+/**
+ * @brief Close all sockets and free the buffers.
+ *
+ * @param port Port object.
+ */
+extern void MicroUDS_DoIP_Close(MicroUDS_DoIP_t *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,867 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // accept4
+#endif
+
+#include "Microuds_doip.h"
+#include "Microuds_com.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DOIP_VERSION 0x02    // ISO 13400-2:2012
+#define DOIP_HEADER_LEN 8    // 协议版本、取反版本、负载类型(2)、负载长度(4)
+#define DOIP_UDP_MAX 512     // UDP 报文缓冲区
+
+#define DOIP_INITIAL_INACTIVITY_MS 2000u    // T_TCP_Initial_Inactivity：连接后未激活路由
+#define DOIP_GENERAL_INACTIVITY_MS 300000u  // T_TCP_General_Inactivity：连接空闲
+
+typedef enum
+{
+    DOIP_GENERIC_NACK = 0x0000,          // 通用报文头否定应答
+    DOIP_VEHICLE_ID_REQ = 0x0001,        // 车辆识别请求
+    DOIP_VEHICLE_ID_REQ_EID = 0x0002,    // 按 EID 车辆识别请求
+    DOIP_VEHICLE_ID_REQ_VIN = 0x0003,    // 按 VIN 车辆识别请求
+    DOIP_VEHICLE_ANNOUNCE = 0x0004,      // 车辆声明 / 车辆识别响应
+    DOIP_ROUTING_ACT_REQ = 0x0005,       // 路由激活请求
+    DOIP_ROUTING_ACT_RSP = 0x0006,       // 路由激活响应
+    DOIP_ALIVE_CHECK_REQ = 0x0007,       // 在线检查请求
+    DOIP_ALIVE_CHECK_RSP = 0x0008,       // 在线检查响应
+    DOIP_ENTITY_STATUS_REQ = 0x4001,     // 实体状态请求
+    DOIP_ENTITY_STATUS_RSP = 0x4002,     // 实体状态响应
+    DOIP_POWER_MODE_REQ = 0x4003,        // 电源模式请求
+    DOIP_POWER_MODE_RSP = 0x4004,        // 电源模式响应
+    DOIP_DIAG_MESSAGE = 0x8001,          // 诊断报文
+    DOIP_DIAG_ACK = 0x8002,              // 诊断报文肯定应答
+    DOIP_DIAG_NACK = 0x8003,             // 诊断报文否定应答
+} DoIP_PayloadType_t;
+
+typedef enum
+{
+    DOIP_NACK_PATTERN = 0x00,     // 报文头格式错误
+    DOIP_NACK_TYPE = 0x01,        // 未知负载类型
+    DOIP_NACK_TOO_LARGE = 0x02,   // 报文过长
+    DOIP_NACK_LENGTH = 0x04,      // 负载长度错误
+} DoIP_Nack_t; // 通用报文头否定应答码
+
+typedef enum
+{
+    DOIP_DIAG_ACK_OK = 0x00,        // 已接收
+    DOIP_DIAG_NACK_SA = 0x02,       // 源地址无效（未激活路由）
+    DOIP_DIAG_NACK_TA = 0x03,       // 目标地址未知
+} DoIP_DiagAck_t; // 诊断报文应答码
+
+typedef enum
+{
+    DOIP_ROUTING_SUCCESS = 0x10,       // 路由激活成功
+    DOIP_ROUTING_SA_DIFFERENT = 0x02,  // 本连接已用其他源地址激活
+    DOIP_ROUTING_TYPE = 0x06,          // 不支持的激活类型
+} DoIP_Routing_t; // 路由激活响应码
+
+static uint64_t DoIP_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static uint64_t DoIP_Clock(void *user)
+{
+    struct timespec ts;
+
+    (void)user;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void DoIP_Put16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)(value >> 8);
+    dst[1] = (uint8_t)value;
+}
+
+static void DoIP_Put32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >> 8);
+    dst[3] = (uint8_t)value;
+}
+
+static uint16_t DoIP_Get16(const uint8_t *src)
+{
+    return (uint16_t)((src[0] << 8) | src[1]);
+}
+
+static uint32_t DoIP_Get32(const uint8_t *src)
+{
+    return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+/**
+ * @brief 写入通用报文头
+ */
+static void DoIP_Header(uint8_t *dst, uint16_t type, uint32_t len)
+{
+    dst[0] = DOIP_VERSION;
+    dst[1] = (uint8_t)~DOIP_VERSION;
+    DoIP_Put16(dst + 2, type);
+    DoIP_Put32(dst + 4, len);
+}
+
+/**
+ * @brief 检查报文头的协议版本
+ *
+ * @param udp UDP 上的车辆识别请求还允许默认版本 0xFF
+ */
+static bool DoIP_HeaderValid(const uint8_t *hdr, bool udp)
+{
+    if ((uint8_t)(hdr[0] ^ hdr[1]) != 0xFF)
+        return false;
+
+    return (hdr[0] >= 0x01 && hdr[0] <= 0x03) || (udp && hdr[0] == 0xFF);
+}
+
+/**
+ * @brief 车辆声明 / 车辆识别响应
+ *
+ * @return size_t 报文总长度
+ */
+static size_t DoIP_BuildAnnounce(const MicroUDS_DoIP_t *port, uint8_t *dst)
+{
+    uint8_t *p = dst + DOIP_HEADER_LEN;
+
+    memcpy(p, port->Vin, 17);
+    DoIP_Put16(p + 17, port->LogicalAddr);
+    memcpy(p + 19, port->Eid, 6);
+    memcpy(p + 25, port->Gid, 6);
+    p[31] = 0x00; // 无需进一步操作
+    p[32] = 0x00; // VIN/GID 已同步
+
+    DoIP_Header(dst, DOIP_VEHICLE_ANNOUNCE, 33);
+    return DOIP_HEADER_LEN + 33;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    TCP                                     */
+/* -------------------------------------------------------------------------- */
+
+static void DoIP_CloseClient(MicroUDS_DoIP_t *port)
+{
+    if (port->ClientFd >= 0)
+        close(port->ClientFd); // 关闭后自动从 epoll 移除
+
+    port->ClientFd = -1;
+    port->Active = false;
+    port->TxWait = false;
+    port->RxLen = 0;
+    port->RxSkip = 0;
+    port->TxLen = 0;
+}
+
+/**
+ * @brief 尽量写出发送缓冲区，写不完时等待 EPOLLOUT
+ */
+static void DoIP_Flush(MicroUDS_DoIP_t *port)
+{
+    size_t sent = 0;
+
+    while (sent < port->TxLen)
+    {
+        ssize_t n = send(port->ClientFd, port->Tx + sent, port->TxLen - sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                port->TxErrors++;
+                DoIP_CloseClient(port);
+                return;
+            }
+            break;
+        }
+        sent += (size_t)n;
+    }
+
+    if (sent > 0)
+    {
+        memmove(port->Tx, port->Tx + sent, port->TxLen - sent);
+        port->TxLen -= sent;
+    }
+
+    bool wait = port->TxLen > 0;
+    if (wait != port->TxWait)
+    {
+        struct epoll_event ev = {.events = EPOLLIN | (wait ? EPOLLOUT : 0), .data.fd = port->ClientFd};
+        epoll_ctl(port->EpollFd, EPOLL_CTL_MOD, port->ClientFd, &ev);
+        port->TxWait = wait;
+    }
+}
+
+/**
+ * @brief 组一条 DoIP 报文放入发送缓冲区并尝试写出
+ *
+ * @param pre 负载前缀（地址等），可为 NULL
+ * @param data 负载数据，可为 NULL
+ * @return true 已放入发送缓冲区
+ */
+static bool DoIP_Queue(MicroUDS_DoIP_t *port, uint16_t type, const uint8_t *pre, size_t pre_len, const uint8_t *data, size_t len)
+{
+    size_t total = DOIP_HEADER_LEN + pre_len + len;
+
+    if (port->ClientFd < 0 || total > MICROUDS_DOIP_TX_SIZE - port->TxLen)
+    {
+        port->TxErrors++;
+        return false;
+    }
+
+    uint8_t *dst = port->Tx + port->TxLen;
+    DoIP_Header(dst, type, (uint32_t)(pre_len + len));
+    if (pre_len)
+        memcpy(dst + DOIP_HEADER_LEN, pre, pre_len);
+    if (len)
+        memcpy(dst + DOIP_HEADER_LEN + pre_len, data, len);
+    port->TxLen += total;
+
+    if (!port->TxWait)
+        DoIP_Flush(port);
+    return true;
+}
+
+static void DoIP_GenericNack(MicroUDS_DoIP_t *port, DoIP_Nack_t code)
+{
+    uint8_t nack = (uint8_t)code;
+    DoIP_Queue(port, DOIP_GENERIC_NACK, &nack, 1, NULL, 0);
+}
+
+static void DoIP_DiagAck(MicroUDS_DoIP_t *port, uint16_t type, uint16_t source, uint16_t target, uint8_t code)
+{
+    uint8_t ack[5];
+
+    DoIP_Put16(ack, source);
+    DoIP_Put16(ack + 2, target);
+    ack[4] = code;
+    DoIP_Queue(port, type, ack, sizeof(ack), NULL, 0);
+}
+
+static void DoIP_RoutingActivation(MicroUDS_DoIP_t *port, const uint8_t *payload, size_t len)
+{
+    if (len != 7 && len != 11) // 可选 OEM 字段 4 字节
+    {
+        DoIP_GenericNack(port, DOIP_NACK_LENGTH);
+        return;
+    }
+
+    uint16_t tester = DoIP_Get16(payload);
+    uint8_t type = payload[2];
+    uint8_t code = DOIP_ROUTING_SUCCESS;
+
+    if (type != 0x00 && type != 0x01) // 只支持默认和 WWH-OBD 激活
+        code = DOIP_ROUTING_TYPE;
+    else if (port->Active && tester != port->TesterAddr)
+        code = DOIP_ROUTING_SA_DIFFERENT;
+
+    uint8_t rsp[9] = {0};
+    DoIP_Put16(rsp, tester);
+    DoIP_Put16(rsp + 2, port->LogicalAddr);
+    rsp[4] = code;
+
+    if (code == DOIP_ROUTING_SUCCESS)
+    {
+        port->TesterAddr = tester;
+        port->Active = true;
+    }
+
+    DoIP_Queue(port, DOIP_ROUTING_ACT_RSP, rsp, sizeof(rsp), NULL, 0);
+}
+
+/**
+ * @brief 诊断报文：应答后整报文交给实例
+ *
+ * @return true 已交给实例
+ */
+static bool DoIP_DiagMessage(MicroUDS_DoIP_t *port, const uint8_t *payload, size_t len)
+{
+    if (len < 5) // SA + TA + 至少一个字节
+    {
+        DoIP_GenericNack(port, DOIP_NACK_LENGTH);
+        return false;
+    }
+
+    uint16_t source = DoIP_Get16(payload);
+    uint16_t target = DoIP_Get16(payload + 2);
+
+    if (!port->Active || source != port->TesterAddr)
+    {
+        DoIP_DiagAck(port, DOIP_DIAG_NACK, target, source, DOIP_DIAG_NACK_SA);
+        return false;
+    }
+
+    if (target != port->LogicalAddr && target != port->FuncAddr)
+    {
+        DoIP_DiagAck(port, DOIP_DIAG_NACK, target, source, DOIP_DIAG_NACK_TA);
+        return false;
+    }
+
+    DoIP_DiagAck(port, DOIP_DIAG_ACK, target, source, DOIP_DIAG_ACK_OK);
+
+    /* 直接在接收缓冲区上分发，实例忙时排队；功能寻址请求由内核抑制相应的NRC */
+    const MicroUDS_Reply_t reply = {.Functional = target == port->FuncAddr && target != port->LogicalAddr};
+    if (MicroUDS_SubmitRequest(port->Uds, payload + 4, len - 4, &reply) == MICROUDS_ERR_BUSY)
+    {
+        if (reply.Functional)
+            MicroUDS_ReceiveFunctional(port->Uds, payload + 4, len - 4);
+        else
+            MicroUDS_ReceiveMessage(port->Uds, payload + 4, len - 4);
+    }
+    port->RxMessages++;
+    return true;
+}
+
+/**
+ * @brief 处理一条完整的 TCP 报文
+ *
+ * @return int 交给实例的诊断报文数
+ */
+static int DoIP_TcpMessage(MicroUDS_DoIP_t *port)
+{
+    uint16_t type = DoIP_Get16(port->Rx + 2);
+    const uint8_t *payload = port->Rx + DOIP_HEADER_LEN;
+    size_t len = port->RxLen - DOIP_HEADER_LEN;
+
+    switch (type)
+    {
+    case DOIP_ROUTING_ACT_REQ:
+        DoIP_RoutingActivation(port, payload, len);
+        break;
+
+    case DOIP_ALIVE_CHECK_REQ:
+    {
+        uint8_t rsp[2];
+        DoIP_Put16(rsp, port->LogicalAddr);
+        DoIP_Queue(port, DOIP_ALIVE_CHECK_RSP, rsp, sizeof(rsp), NULL, 0);
+        break;
+    }
+
+    case DOIP_ALIVE_CHECK_RSP:
+        break; // 只刷新空闲定时器
+
+    case DOIP_DIAG_MESSAGE:
+        return DoIP_DiagMessage(port, payload, len) ? 1 : 0;
+
+    default:
+        DoIP_GenericNack(port, DOIP_NACK_TYPE);
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 读空测试仪连接：按报文头中的负载长度拆分报文
+ *
+ * @return int 交给实例的诊断报文数
+ */
+static int DoIP_TcpRead(MicroUDS_DoIP_t *port)
+{
+    int count = 0;
+
+    while (port->ClientFd >= 0)
+    {
+        size_t want;
+        uint8_t *dst;
+
+        if (port->RxSkip > 0) // 丢弃超长报文的负载
+        {
+            dst = port->Rx;
+            want = port->RxSkip < DOIP_HEADER_LEN + MICROUDS_DOIP_MAX_DATA ? port->RxSkip : DOIP_HEADER_LEN + MICROUDS_DOIP_MAX_DATA;
+        }
+        else
+        {
+            size_t need = port->RxLen < DOIP_HEADER_LEN ? DOIP_HEADER_LEN : DOIP_HEADER_LEN + DoIP_Get32(port->Rx + 4);
+            dst = port->Rx + port->RxLen;
+            want = need - port->RxLen;
+        }
+
+        ssize_t n = recv(port->ClientFd, dst, want, 0);
+        if (n == 0)
+        {
+            DoIP_CloseClient(port); // 测试仪断开
+            break;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                DoIP_CloseClient(port);
+            break;
+        }
+
+        port->ClientAt = DoIP_Now();
+
+        if (port->RxSkip > 0)
+        {
+            port->RxSkip -= (size_t)n;
+            continue;
+        }
+
+        port->RxLen += (size_t)n;
+
+        if (port->RxLen == DOIP_HEADER_LEN)
+        {
+            if (!DoIP_HeaderValid(port->Rx, false))
+            {
+                DoIP_GenericNack(port, DOIP_NACK_PATTERN);
+                DoIP_Flush(port);
+                DoIP_CloseClient(port); // 格式错误：关闭连接
+                break;
+            }
+
+            uint32_t len = DoIP_Get32(port->Rx + 4);
+            if (len > MICROUDS_DOIP_MAX_DATA)
+            {
+                DoIP_GenericNack(port, DOIP_NACK_TOO_LARGE);
+                port->RxSkip = len;
+                port->RxLen = 0;
+                continue;
+            }
+        }
+
+        if (port->RxLen >= DOIP_HEADER_LEN && port->RxLen == DOIP_HEADER_LEN + DoIP_Get32(port->Rx + 4))
+        {
+            count += DoIP_TcpMessage(port);
+            port->RxLen = 0;
+        }
+    }
+
+    return count;
+}
+
+static void DoIP_Accept(MicroUDS_DoIP_t *port)
+{
+    for (;;)
+    {
+        int fd = accept4(port->ListenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        if (port->ClientFd >= 0) // 只支持一个测试仪连接
+        {
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // 应答和响应立即发出
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+        if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        port->ClientFd = fd;
+        port->ClientAt = DoIP_Now();
+        port->Active = false;
+        port->TxWait = false;
+        port->RxLen = 0;
+        port->RxSkip = 0;
+        port->TxLen = 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    UDP                                     */
+/* -------------------------------------------------------------------------- */
+
+static void DoIP_UdpReply(MicroUDS_DoIP_t *port, const struct sockaddr_in *to, uint8_t *msg, size_t len)
+{
+    sendto(port->UdpFd, msg, len, 0, (const struct sockaddr *)to, sizeof(*to));
+}
+
+static void DoIP_UdpMessage(MicroUDS_DoIP_t *port, const uint8_t *msg, size_t len, const struct sockaddr_in *from)
+{
+    uint8_t rsp[DOIP_HEADER_LEN + 33];
+
+    if (len < DOIP_HEADER_LEN || !DoIP_HeaderValid(msg, true))
+    {
+        DoIP_Header(rsp, DOIP_GENERIC_NACK, 1);
+        rsp[DOIP_HEADER_LEN] = DOIP_NACK_PATTERN;
+        DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 1);
+        return;
+    }
+
+    uint16_t type = DoIP_Get16(msg + 2);
+    uint32_t plen = DoIP_Get32(msg + 4);
+    const uint8_t *payload = msg + DOIP_HEADER_LEN;
+    bool match;
+
+    if (plen != len - DOIP_HEADER_LEN)
+    {
+        DoIP_Header(rsp, DOIP_GENERIC_NACK, 1);
+        rsp[DOIP_HEADER_LEN] = DOIP_NACK_LENGTH;
+        DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 1);
+        return;
+    }
+
+    switch (type)
+    {
+    case DOIP_VEHICLE_ID_REQ:
+    case DOIP_VEHICLE_ID_REQ_EID:
+    case DOIP_VEHICLE_ID_REQ_VIN:
+        if ((type == DOIP_VEHICLE_ID_REQ && plen != 0) || (type == DOIP_VEHICLE_ID_REQ_EID && plen != 6) ||
+            (type == DOIP_VEHICLE_ID_REQ_VIN && plen != 17))
+        {
+            DoIP_Header(rsp, DOIP_GENERIC_NACK, 1);
+            rsp[DOIP_HEADER_LEN] = DOIP_NACK_LENGTH;
+            DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 1);
+            return;
+        }
+
+        match = type == DOIP_VEHICLE_ID_REQ || (type == DOIP_VEHICLE_ID_REQ_EID && memcmp(payload, port->Eid, 6) == 0) ||
+                (type == DOIP_VEHICLE_ID_REQ_VIN && memcmp(payload, port->Vin, 17) == 0);
+        if (match) // 不匹配时不响应
+            DoIP_UdpReply(port, from, rsp, DoIP_BuildAnnounce(port, rsp));
+        break;
+
+    case DOIP_ENTITY_STATUS_REQ:
+        DoIP_Header(rsp, DOIP_ENTITY_STATUS_RSP, 7);
+        rsp[DOIP_HEADER_LEN] = 0x01;     // DoIP 节点
+        rsp[DOIP_HEADER_LEN + 1] = 1;    // 最大 TCP 连接数
+        rsp[DOIP_HEADER_LEN + 2] = port->ClientFd >= 0 ? 1 : 0;
+        DoIP_Put32(rsp + DOIP_HEADER_LEN + 3, MICROUDS_DOIP_MAX_DATA);
+        DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 7);
+        break;
+
+    case DOIP_POWER_MODE_REQ:
+        DoIP_Header(rsp, DOIP_POWER_MODE_RSP, 1);
+        rsp[DOIP_HEADER_LEN] = 0x01; // 可以诊断
+        DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 1);
+        break;
+
+    case DOIP_GENERIC_NACK:
+    case DOIP_VEHICLE_ANNOUNCE:
+    case DOIP_ENTITY_STATUS_RSP:
+    case DOIP_POWER_MODE_RSP:
+        break; // 其他实体（或本端口回环）的响应：忽略，避免互相应答
+
+    default:
+        DoIP_Header(rsp, DOIP_GENERIC_NACK, 1);
+        rsp[DOIP_HEADER_LEN] = DOIP_NACK_TYPE;
+        DoIP_UdpReply(port, from, rsp, DOIP_HEADER_LEN + 1);
+        break;
+    }
+}
+
+static void DoIP_UdpRead(MicroUDS_DoIP_t *port)
+{
+    uint8_t msg[DOIP_UDP_MAX];
+
+    for (;;)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(port->UdpFd, msg, sizeof(msg), 0, (struct sockaddr *)&from, &from_len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        DoIP_UdpMessage(port, msg, (size_t)n, &from);
+    }
+}
+
+static void DoIP_Timers(MicroUDS_DoIP_t *port)
+{
+    uint64_t now = DoIP_Now();
+
+    if (port->AnnounceLeft > 0 && now >= port->AnnounceAt)
+    {
+        uint8_t msg[DOIP_HEADER_LEN + 33];
+        struct sockaddr_in to = {
+            .sin_family = AF_INET,
+            .sin_port = port->UdpPort,
+            .sin_addr.s_addr = port->AnnounceIp,
+        };
+
+        DoIP_UdpReply(port, &to, msg, DoIP_BuildAnnounce(port, msg));
+        port->AnnounceLeft--;
+        port->AnnounceAt = now + port->AnnounceIntervalMs;
+    }
+
+    if (port->ClientFd >= 0)
+    {
+        uint64_t idle = now - port->ClientAt;
+        if ((!port->Active && idle >= DOIP_INITIAL_INACTIVITY_MS) || idle >= DOIP_GENERAL_INACTIVITY_MS)
+            DoIP_CloseClient(port);
+    }
+}
+
+/**
+ * @brief 等待超时：不超过车辆声明、TCP 非活动超时和实例的下一个截止时刻
+ */
+static int DoIP_Timeout(MicroUDS_DoIP_t *port, int timeout_ms)
+{
+    uint64_t now = DoIP_Now();
+    uint64_t wait = MicroUDS_NextDeadline(port->Uds);
+
+    if (port->AnnounceLeft > 0)
+    {
+        uint64_t left = port->AnnounceAt > now ? port->AnnounceAt - now : 0;
+        if (left < wait)
+            wait = left;
+    }
+
+    if (port->ClientFd >= 0)
+    {
+        uint64_t at = port->ClientAt + (port->Active ? DOIP_GENERAL_INACTIVITY_MS : DOIP_INITIAL_INACTIVITY_MS);
+        uint64_t left = at > now ? at - now : 0;
+        if (left < wait)
+            wait = left;
+    }
+
+    if (wait >= MICROUDS_DEADLINE_NONE || (timeout_ms >= 0 && (uint64_t)timeout_ms <= wait))
+        return timeout_ms;
+
+    return wait > INT32_MAX ? INT32_MAX : (int)wait;
+}
+
+/**
+ * @brief 实例的事件通知：写 eventfd 唤醒 MicroUDS_DoIP_Poll（可在其他线程中调用）
+ */
+static void DoIP_Notify(void *user, MicroUDS_Event_t event)
+{
+    MicroUDS_DoIP_t *port = (MicroUDS_DoIP_t *)user;
+    uint64_t one = 1;
+
+    (void)event;
+    ssize_t ret = write(port->WakeFd, &one, sizeof(one));
+    (void)ret; // 计数器已满时 epoll 仍然可读
+}
+
+static int DoIP_TransmitMessage(void *user, const uint8_t *msg, size_t len)
+{
+    MicroUDS_DoIP_t *port = (MicroUDS_DoIP_t *)user;
+    uint8_t addr[4];
+
+    if (!port->Active)
+    {
+        port->TxErrors++;
+        return 1;
+    }
+
+    DoIP_Put16(addr, port->LogicalAddr);
+    DoIP_Put16(addr + 2, port->TesterAddr);
+    if (!DoIP_Queue(port, DOIP_DIAG_MESSAGE, addr, sizeof(addr), msg, len))
+        return 1;
+
+    port->TxMessages++;
+    return 0;
+}
+
+/**
+ * @brief 创建并绑定一个非阻塞套接字
+ */
+static int DoIP_Socket(int type, const struct sockaddr_in *addr)
+{
+    int one = 1;
+    int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (type == SOCK_DGRAM)
+        setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one)); // 车辆声明广播
+
+    if (bind(fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+MicroUDS_Sta_t MicroUDS_DoIP_Open(MicroUDS_DoIP_t *port, const MicroUDS_DoIPConf_t *conf)
+{
+    MICROUDS_CHECKPTR(port);
+    MICROUDS_CHECKPTR(conf);
+
+    uint16_t portnum = conf->Port ? conf->Port : MICROUDS_DOIP_PORT;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(portnum),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    struct in_addr announce = {.s_addr = htonl(INADDR_BROADCAST)};
+
+    if ((conf->BindAddr != NULL && inet_pton(AF_INET, conf->BindAddr, &addr.sin_addr) != 1) ||
+        (conf->AnnounceAddr != NULL && inet_pton(AF_INET, conf->AnnounceAddr, &announce) != 1) ||
+        (conf->Vin != NULL && strlen(conf->Vin) != 17))
+        return MICROUDS_ERR_PARAM;
+
+    memset(port, 0, sizeof(MicroUDS_DoIP_t));
+    port->UdpFd = -1;
+    port->ListenFd = -1;
+    port->ClientFd = -1;
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+
+    port->LogicalAddr = conf->LogicalAddr;
+    port->FuncAddr = conf->FuncAddr ? conf->FuncAddr : 0xE400;
+    if (conf->Vin != NULL)
+        memcpy(port->Vin, conf->Vin, 17);
+    else
+        memset(port->Vin, 0xFF, 17);
+    memcpy(port->Eid, conf->Eid, 6);
+    memcpy(port->Gid, conf->Gid, 6);
+    port->AnnounceLeft = conf->AnnounceCount ? conf->AnnounceCount : 3;
+    port->AnnounceIntervalMs = conf->AnnounceIntervalMs ? conf->AnnounceIntervalMs : 500;
+    port->AnnounceAt = DoIP_Now();
+    port->AnnounceIp = announce.s_addr;
+    port->UdpPort = htons(portnum);
+
+    port->Transport.TxMessage = DoIP_TransmitMessage;
+    port->Transport.NowNs = DoIP_Clock;
+    port->Transport.Addressing.Source = port->LogicalAddr;
+    port->Transport.Addressing.Functional = port->FuncAddr;
+
+    port->Rx = (uint8_t *)malloc(DOIP_HEADER_LEN + MICROUDS_DOIP_MAX_DATA);
+    port->Tx = (uint8_t *)malloc(MICROUDS_DOIP_TX_SIZE);
+    if (port->Rx == NULL || port->Tx == NULL)
+    {
+        MicroUDS_DoIP_Close(port);
+        return MICROUDS_ERR_MEMORY;
+    }
+
+    port->UdpFd = DoIP_Socket(SOCK_DGRAM, &addr);
+    port->ListenFd = DoIP_Socket(SOCK_STREAM, &addr);
+    if (port->UdpFd < 0 || port->ListenFd < 0 || listen(port->ListenFd, 4) < 0)
+        goto fail;
+
+    port->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (port->EpollFd < 0)
+        goto fail;
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = port->UdpFd};
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->UdpFd, &ev) < 0)
+        goto fail;
+
+    ev.data.fd = port->ListenFd;
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->ListenFd, &ev) < 0)
+        goto fail;
+
+    port->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (port->WakeFd < 0)
+        goto fail;
+
+    ev.data.fd = port->WakeFd;
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->WakeFd, &ev) < 0)
+        goto fail;
+
+    return MICROUDS_OK;
+
+fail:
+    MicroUDS_DoIP_Close(port);
+    return MICROUDS_ERR;
+}
+
+void MicroUDS_DoIP_Attach(MicroUDS_DoIP_t *port, MicroUDS_Conf_t *conf)
+{
+    if (port == NULL || conf == NULL)
+        return;
+
+    conf->Transport = &port->Transport;
+    conf->TransportCtx = port;
+    conf->Notify = DoIP_Notify;
+    conf->NotifyCtx = port;
+}
+
+void MicroUDS_DoIP_Bind(MicroUDS_DoIP_t *port, MicroUDS_Handle_t handle)
+{
+    if (port != NULL)
+        port->Uds = handle;
+}
+
+int MicroUDS_DoIP_Poll(MicroUDS_DoIP_t *port, int timeout_ms)
+{
+    if (port == NULL || port->EpollFd < 0 || port->Uds == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct epoll_event ev[4];
+    int ready = epoll_wait(port->EpollFd, ev, 4, DoIP_Timeout(port, timeout_ms));
+    if (ready < 0)
+    {
+        if (errno != EINTR)
+            return -1;
+        ready = 0;
+    }
+
+    int total = 0;
+
+    for (int i = 0; i < ready; i++)
+    {
+        int fd = ev[i].data.fd;
+
+        if (fd == port->WakeFd)
+        {
+            uint64_t count;
+            ssize_t ret = read(port->WakeFd, &count, sizeof(count)); // 清除通知，调用者随后调用 MicroUDS_TimerHandler
+            (void)ret;
+        }
+        else if (fd == port->UdpFd)
+            DoIP_UdpRead(port);
+        else if (fd == port->ListenFd)
+            DoIP_Accept(port);
+        else if (fd == port->ClientFd)
+        {
+            if (ev[i].events & EPOLLOUT)
+                DoIP_Flush(port);
+            if (port->ClientFd >= 0 && (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                total += DoIP_TcpRead(port);
+        }
+    }
+
+    DoIP_Timers(port);
+    return total;
+}
+
+void MicroUDS_DoIP_Close(MicroUDS_DoIP_t *port)
+{
+    if (port == NULL)
+        return;
+
+    DoIP_CloseClient(port);
+
+    if (port->EpollFd >= 0)
+        close(port->EpollFd);
+    if (port->WakeFd >= 0)
+        close(port->WakeFd);
+    if (port->ListenFd >= 0)
+        close(port->ListenFd);
+    if (port->UdpFd >= 0)
+        close(port->UdpFd);
+
+    free(port->Rx);
+    free(port->Tx);
+
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+    port->ListenFd = -1;
+    port->UdpFd = -1;
+    port->Rx = NULL;
+    port->Tx = NULL;
+}
@@ -0,0 +1,115 @@
+#ifndef MICROUDS_LOOPBACK_H
+#define MICROUDS_LOOPBACK_H
+
+/**
+ * @file Microuds_loopback.h
+ * @author https://github.com/xfp23
+ * @brief In-memory loopback transport for MicroUDS.
+ *
+ * Plays the tester side of the link inside the same process: requests are
+ * segmented (or handed over whole in message mode) straight into the
+ * instance, responses are reassembled from the transmitted frames, and a
+ * manual clock replaces @ref MicroUDS_TickHandler. No hardware or OS
+ * dependency, so the same services can be exercised on a PC, in CI or on
+ * the target before the real bus driver exists.
+ *
+ * @version 0.1
+ * @date 2025-10-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "Microuds.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Response buffer size: largest response the loopback reassembles.
+ */
+#ifndef MICROUDS_LOOPBACK_RSP_SIZE
+#define MICROUDS_LOOPBACK_RSP_SIZE MICROUDS_TX_BUF_SIZE
+#endif
+
+typedef struct
+{
+    bool Message;    // 报文模式（不分帧，同内核 ISO-TP / DoIP）
+    size_t FrameLen; // 帧模式的帧长度，0 = 8
+} MicroUDS_LoopbackConf_t; // 回环配置
+
+typedef struct
+{
+    MicroUDS_Handle_t Uds;          // 绑定的 MicroUDS 实例
+    MicroUDS_Transport_t Transport; // 传输层接口（Init 时填写）
+    uint32_t Now;                   // 手动时钟（毫秒）
+    bool FcDue;                     // 收到响应首帧，需要回复流控帧
+    bool Done;                      // 已收到一条完整响应
+    uint8_t NextSn;                 // 下一个 CF 序号
+    size_t Total;                   // 响应总长度
+    size_t Len;                     // 已接收长度
+    uint64_t TxFrames;              // 实例发出的帧数（报文模式为报文数）
+    uint8_t Rsp[MICROUDS_LOOPBACK_RSP_SIZE]; // 响应缓冲区
+} MicroUDS_Loopback_t; // 回环端口
+
+/**
+ * @brief Initialize the loopback port.
+ *
+ * @param port Port object (caller storage).
+ * @param conf Port configuration (NULL = classic CAN frame mode).
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Port ready.
+ * - MICROUDS_ERR_PARAM: Invalid frame length.
+ */
+extern MicroUDS_Sta_t MicroUDS_Loopback_Init(MicroUDS_Loopback_t *port, const MicroUDS_LoopbackConf_t *conf);
+
+/**
+ * @brief Fill the transport fields of an instance configuration.
+ *
+ * Points Transport / TransportCtx at this port; the instance clock is
+ * @ref MicroUDS_Loopback_t::Now. Call before @ref MicroUDS_Create, then
+ * @ref MicroUDS_Loopback_Bind with the created handle.
+ *
+ * @param port Initialized port.
+ * @param conf Instance configuration to fill.
+ */
+extern void MicroUDS_Loopback_Attach(MicroUDS_Loopback_t *port, MicroUDS_Conf_t *conf);
+
+/**
+ * @brief Bind the instance under test.
+ *
+ * @param port Initialized port.
+ * @param handle MicroUDS instance created with an attached configuration.
+ */
+extern void MicroUDS_Loopback_Bind(MicroUDS_Loopback_t *port, MicroUDS_Handle_t handle);
+
+/**
+ * @brief Advance the clock, calling @ref MicroUDS_TimerHandler every millisecond.
+ *
+ * @param port Bound port.
+ * @param ms Milliseconds to advance.
+ */
+extern void MicroUDS_Loopback_Advance(MicroUDS_Loopback_t *port, uint32_t ms);
+
+/**
+ * @brief Send one request and wait for its final response.
+ *
+ * Answers the instance's First Frame with a Flow Control frame (BS = 0,
+ * STmin = 0) and skips Response-Pending (0x7F xx 0x78) responses. The
+ * response is left in @ref MicroUDS_Loopback_t::Rsp.
+ *
+ * @param port Bound port.
+ * @param req Request, starting with the SID.
+ * @param len Request length.
+ * @param timeout_ms Simulated time to wait for the response.
+ * @return int Response length, or -1 on timeout / invalid arguments.
+ */
+extern int MicroUDS_Loopback_Transact(MicroUDS_Loopback_t *port, const uint8_t *req, size_t len, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
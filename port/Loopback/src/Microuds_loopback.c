@@ -0,0 +1,220 @@
+#include "Microuds_loopback.h"
+#include "Microuds_com.h"
+#include "Isotp.h"
+
+/**
+ * @brief 开始接收一条新响应
+ */
+static void Loopback_Reset(MicroUDS_Loopback_t *port)
+{
+    port->FcDue = false;
+    port->Done = false;
+    port->NextSn = 1;
+    port->Total = 0;
+    port->Len = 0;
+}
+
+static uint32_t Loopback_Now(void *user)
+{
+    return ((MicroUDS_Loopback_t *)user)->Now;
+}
+
+/**
+ * @brief 帧模式：在发送回调中直接重组响应
+ *
+ * 首帧只记录需要回复流控，流控帧在 MicroUDS_TimerHandler 返回后再输入，避免重入
+ */
+static int Loopback_Transmit(void *user, uint8_t *data, size_t size)
+{
+    MicroUDS_Loopback_t *port = (MicroUDS_Loopback_t *)user;
+    Isotp_Payload_t payload;
+
+    port->TxFrames++;
+
+    switch (data[0] & 0xF0)
+    {
+    case 0x00: // 单帧
+        if (Isotp_UnpackSingleFrameEx(&payload, data, size) != ISOTP_OK || payload.Size > sizeof(port->Rsp))
+            return 1;
+        memcpy(port->Rsp, payload.Payload, payload.Size);
+        port->Len = payload.Size;
+        port->Total = payload.Size;
+        port->Done = true;
+        break;
+
+    case 0x10: // 首帧
+        if (Isotp_UnpackFirstFrameEx(&payload, data, size) != ISOTP_OK || payload.Total > sizeof(port->Rsp))
+            return 1;
+        memcpy(port->Rsp, payload.Payload, payload.Size);
+        port->Len = payload.Size;
+        port->Total = payload.Total;
+        port->NextSn = 1;
+        port->FcDue = true;
+        break;
+
+    case 0x20: // 连续帧
+    {
+        if (port->Total == 0 || port->Done || (data[0] & 0x0F) != port->NextSn)
+            return 1;
+
+        size_t n = size - 1;
+        if (n > port->Total - port->Len)
+            n = port->Total - port->Len; // 最后一帧的填充
+        memcpy(port->Rsp + port->Len, data + 1, n);
+        port->Len += n;
+        port->NextSn = (port->NextSn + 1) & 0x0F;
+        if (port->Len == port->Total)
+            port->Done = true;
+        break;
+    }
+
+    default: // 实例对请求首帧回复的流控帧：请求已整体输入，忽略
+        break;
+    }
+
+    return 0;
+}
+
+static int Loopback_TransmitMessage(void *user, const uint8_t *msg, size_t len)
+{
+    MicroUDS_Loopback_t *port = (MicroUDS_Loopback_t *)user;
+
+    port->TxFrames++;
+    if (len > sizeof(port->Rsp))
+        return 1;
+
+    memcpy(port->Rsp, msg, len);
+    port->Len = len;
+    port->Total = len;
+    port->Done = true;
+    return 0;
+}
+
+/**
+ * @brief 作为测试仪输入一条请求
+ *
+ * 帧模式按实例帧长度分段后逐帧输入（首帧后不等待流控，实例按 BS = 0 接收），
+ * 每帧之后调用一次 MicroUDS_TimerHandler，不推进时钟
+ */
+static MicroUDS_Sta_t Loopback_Request(MicroUDS_Loopback_t *port, const uint8_t *req, size_t len)
+{
+    uint8_t frame[MICROUDS_FRAME_MAX];
+    size_t frame_len = port->Transport.MaxFrameSize;
+    size_t n;
+
+    if (port->Transport.TxMessage != NULL)
+    {
+        MicroUDS_ReceiveMessage(port->Uds, req, len);
+        return MICROUDS_OK;
+    }
+
+    if (len <= Isotp_SingleFrameMax(frame_len))
+    {
+        if (Isotp_PackSingleFrameEx(frame, frame_len, req, len, &n) != ISOTP_OK)
+            return MICROUDS_ERR_PARAM;
+        MicroUDS_ReceiveFrame(port->Uds, frame, n);
+        return MICROUDS_OK;
+    }
+
+    size_t offset;
+    if (Isotp_PackFirstFrameEx(frame, frame_len, req, len, &offset) != ISOTP_OK)
+        return MICROUDS_ERR_PARAM;
+    MicroUDS_ReceiveFrame(port->Uds, frame, frame_len);
+
+    for (uint8_t sn = 1; offset < len; sn = (sn + 1) & 0x0F)
+    {
+        size_t consumed;
+        if (Isotp_PackConsecutiveFrameEx(frame, frame_len, req + offset, len - offset, sn, &consumed, &n) != ISOTP_OK)
+            return MICROUDS_ERR_PARAM;
+        MicroUDS_ReceiveFrame(port->Uds, frame, n);
+        MicroUDS_TimerHandler(port->Uds); // 启用 RX 队列时逐帧取出，避免长请求溢出队列
+        offset += consumed;
+    }
+
+    return MICROUDS_OK;
+}
+
+MicroUDS_Sta_t MicroUDS_Loopback_Init(MicroUDS_Loopback_t *port, const MicroUDS_LoopbackConf_t *conf)
+{
+    MICROUDS_CHECKPTR(port);
+
+    size_t frame_len = (conf != NULL && conf->FrameLen != 0) ? conf->FrameLen : ISOTP_CAN_DL;
+    if (frame_len > MICROUDS_FRAME_MAX || Isotp_FrameLength(frame_len) != frame_len)
+        return MICROUDS_ERR_PARAM;
+
+    memset(port, 0, offsetof(MicroUDS_Loopback_t, Rsp));
+    Loopback_Reset(port);
+
+    if (conf != NULL && conf->Message)
+        port->Transport.TxMessage = Loopback_TransmitMessage;
+    else
+        port->Transport.Tx = Loopback_Transmit;
+    port->Transport.Now = Loopback_Now;
+    port->Transport.MaxFrameSize = frame_len;
+
+    return MICROUDS_OK;
+}
+
+void MicroUDS_Loopback_Attach(MicroUDS_Loopback_t *port, MicroUDS_Conf_t *conf)
+{
+    if (port == NULL || conf == NULL)
+        return;
+
+    conf->Transport = &port->Transport;
+    conf->TransportCtx = port;
+}
+
+void MicroUDS_Loopback_Bind(MicroUDS_Loopback_t *port, MicroUDS_Handle_t handle)
+{
+    if (port != NULL)
+        port->Uds = handle;
+}
+
+void MicroUDS_Loopback_Advance(MicroUDS_Loopback_t *port, uint32_t ms)
+{
+    if (port == NULL || port->Uds == NULL)
+        return;
+
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        port->Now++;
+        MicroUDS_TimerHandler(port->Uds);
+    }
+}
+
+int MicroUDS_Loopback_Transact(MicroUDS_Loopback_t *port, const uint8_t *req, size_t len, uint32_t timeout_ms)
+{
+    static const uint8_t fc[ISOTP_CAN_DL] = {0x30, 0x00, 0x00}; // CTS，BS = 0，STmin = 0
+
+    if (port == NULL || port->Uds == NULL || req == NULL || len == 0)
+        return -1;
+
+    Loopback_Reset(port);
+    if (Loopback_Request(port, req, len) != MICROUDS_OK)
+        return -1;
+
+    for (uint32_t elapsed = 0; elapsed <= timeout_ms;)
+    {
+        MicroUDS_TimerHandler(port->Uds);
+
+        if (port->FcDue)
+        {
+            port->FcDue = false;
+            MicroUDS_ReceiveFrame(port->Uds, fc, sizeof(fc));
+            continue; // 流控在下一次 MicroUDS_TimerHandler 中处理，不推进时钟
+        }
+
+        if (port->Done)
+        {
+            if (port->Len >= 3 && port->Rsp[0] == 0x7F && port->Rsp[2] == UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING)
+                Loopback_Reset(port); // 0x78：继续等待最终响应
+            else
+                return (int)port->Len;
+        }
+
+        port->Now++;
+        elapsed++;
+    }
+
+    return -1;
+}
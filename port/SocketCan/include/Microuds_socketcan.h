@@ -0,0 +1,140 @@
+#ifndef MICROUDS_SOCKETCAN_H
+#define MICROUDS_SOCKETCAN_H
+
+/**
+ * @file Microuds_socketcan.h
+ * @author https://github.com/xfp23
+ * @brief Linux SocketCAN (CAN_RAW) transport for MicroUDS.
+ *
+ * Non-blocking CAN_RAW socket driven by epoll. Received frames are read in
+ * batches with recvmmsg() and fed to @ref MicroUDS_ReceiveFrame; responses go
+ * out through the port's @ref MicroUDS_Transport_t, Consecutive Frame bursts through
+ * one sendmmsg() call. The kernel filters on the physical and functional
+ * request IDs, so only diagnostic traffic wakes the process.
+ *
+ * Quick test on a virtual bus:
+ * @code
+ * sudo modprobe vcan
+ * sudo ip link add dev vcan0 type vcan && sudo ip link set vcan0 up
+ * @endcode
+ *
+ * @version 0.1
+ * @date 2025-10-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "Microuds.h"
+#include <linux/can.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Maximum number of frames read by one recvmmsg() / written by one sendmmsg().
+ */
+#ifndef MICROUDS_SOCKETCAN_BATCH
+#define MICROUDS_SOCKETCAN_BATCH 32
+#endif
+
+typedef struct
+{
+    const char *IfName;  // CAN 接口名，如 "vcan0"
+    uint32_t RxId;       // 物理寻址请求ID（测试仪 -> ECU）
+    uint32_t FuncId;     // 功能寻址请求ID，如 0x7DF，0 = 不接收
+    uint32_t TxId;       // 响应ID（ECU -> 测试仪）
+    bool Extended;       // 使用 29 位扩展帧ID
+    bool CanFd;          // 打开 CAN FD 帧收发 (CAN_RAW_FD_FRAMES)
+    bool HwTimestamp;    // 请求硬件接收时间戳，不支持时使用软件时间戳
+} MicroUDS_SocketCanConf_t; // SocketCAN 配置
+
+typedef struct
+{
+    int Fd;                        // CAN_RAW 套接字
+    int EpollFd;                   // epoll 实例
+    int WakeFd;                    // eventfd，实例的事件通知在此唤醒 epoll
+    MicroUDS_Handle_t Uds;         // 绑定的 MicroUDS 实例
+    canid_t TxId;                  // 响应ID（含 CAN_EFF_FLAG）
+    canid_t FuncId;                // 功能寻址请求ID（含 CAN_EFF_FLAG），0 = 不接收
+    bool CanFd;                    // CAN FD 模式
+    struct timespec LastRx;        // 最近一帧的接收时间戳（硬件优先）
+    uint64_t RxFrames;             // 接收帧数
+    uint64_t TxFrames;             // 发送帧数
+    uint64_t TxErrors;             // 发送失败次数（含 EAGAIN）
+    struct MicroUDS_SocketCanIo *Io; // recvmmsg / sendmmsg 批量缓冲区
+    MicroUDS_Transport_t Transport;  // 传输层接口（Open 时填写）
+} MicroUDS_SocketCan_t; // SocketCAN 端口
+
+/**
+ * @brief Open and configure a CAN_RAW socket.
+ *
+ * Binds to the interface, installs kernel filters for RxId / FuncId,
+ * enables CAN FD frames and RX timestamps if requested, and registers
+ * the socket and a wake-up eventfd with a private epoll instance.
+ *
+ * @param port Port object (caller storage).
+ * @param conf Port configuration.
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: Socket ready.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR_MEMORY: Batch buffers could not be allocated.
+ * - MICROUDS_ERR: A socket call failed (see errno).
+ */
+extern MicroUDS_Sta_t MicroUDS_SocketCan_Open(MicroUDS_SocketCan_t *port, const MicroUDS_SocketCanConf_t *conf);
+
+/**
+ * @brief Fill the transport fields of an instance configuration.
+ *
+ * Points Transport / TransportCtx at this port: frame and burst transmit,
+ * CLOCK_MONOTONIC in nanoseconds as the instance clock (no
+ * @ref MicroUDS_TickHandler needed; sub-millisecond STmin with a tick
+ * rate of 10 kHz or more) and MaxFrameSize 64 in CAN FD mode. Notify /
+ * NotifyCtx are pointed at the port's eventfd. Call before
+ * @ref MicroUDS_Create, then @ref MicroUDS_SocketCan_Bind with the created handle.
+ *
+ * @param port Opened port.
+ * @param conf Instance configuration to fill.
+ */
+extern void MicroUDS_SocketCan_Attach(MicroUDS_SocketCan_t *port, MicroUDS_Conf_t *conf);
+
+/**
+ * @brief Bind the instance that receives this port's frames.
+ *
+ * @param port Opened port.
+ * @param handle MicroUDS instance created with an attached configuration.
+ */
+extern void MicroUDS_SocketCan_Bind(MicroUDS_SocketCan_t *port, MicroUDS_Handle_t handle);
+
+/**
+ * @brief Wait for frames and feed them to the bound instance.
+ *
+ * Blocks in epoll_wait() for at most @p timeout_ms, then drains the socket
+ * with recvmmsg() in batches of @ref MICROUDS_SOCKETCAN_BATCH.
+ *
+ * The wait also ends when the bound instance notifies new work (e.g. a
+ * request completed on another thread) and never lasts past the
+ * instance's @ref MicroUDS_NextDeadline, so a loop of this call with -1
+ * followed by @ref MicroUDS_TimerHandler sleeps while the ECU is idle.
+ *
+ * @param port Opened and bound port.
+ * @param timeout_ms epoll timeout (0 = poll, -1 = wait for traffic or the next deadline).
+ * @return int Number of frames processed, or -1 on error (see errno).
+ */
+extern int MicroUDS_SocketCan_Poll(MicroUDS_SocketCan_t *port, int timeout_ms);
+
+/**
+ * @brief Close the socket and the epoll instance and free the batch buffers.
+ *
+ * @param port Port object.
+ */
+extern void MicroUDS_SocketCan_Close(MicroUDS_SocketCan_t *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
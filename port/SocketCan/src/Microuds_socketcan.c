@@ -0,0 +1,375 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // recvmmsg / sendmmsg
+#endif
+#include "Microuds_socketcan.h"
+#include "Microuds_com.h"
+#include <errno.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct MicroUDS_SocketCanIo
+{
+    struct canfd_frame RxFrame[MICROUDS_SOCKETCAN_BATCH];
+    struct iovec RxIov[MICROUDS_SOCKETCAN_BATCH];
+    struct mmsghdr RxMsg[MICROUDS_SOCKETCAN_BATCH];
+    uint8_t RxCtrl[MICROUDS_SOCKETCAN_BATCH][CMSG_SPACE(3 * sizeof(struct timespec))];
+
+    struct canfd_frame TxFrame[MICROUDS_SOCKETCAN_BATCH];
+    struct iovec TxIov[MICROUDS_SOCKETCAN_BATCH];
+    struct mmsghdr TxMsg[MICROUDS_SOCKETCAN_BATCH];
+};
+
+/**
+ * @brief 把一帧放入内核帧结构
+ *
+ * @param port 端口
+ * @param frame 目标帧
+ * @param data 帧数据
+ * @param size 帧长度
+ */
+static void SocketCan_Fill(MicroUDS_SocketCan_t *port, struct canfd_frame *frame, const uint8_t *data, size_t size)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->can_id = port->TxId;
+    frame->len = (uint8_t)size;
+    if (size > CAN_MAX_DLEN)
+        frame->flags = CANFD_BRS; // 数据段加速
+    memcpy(frame->data, data, size);
+}
+
+/**
+ * @brief 帧在套接字上占用的长度：经典帧用 struct can_frame，FD 帧用 struct canfd_frame
+ */
+static size_t SocketCan_MTU(size_t size)
+{
+    return size > CAN_MAX_DLEN ? CANFD_MTU : CAN_MTU;
+}
+
+static int SocketCan_Transmit(void *user, uint8_t *data, size_t size)
+{
+    MicroUDS_SocketCan_t *port = (MicroUDS_SocketCan_t *)user;
+    struct canfd_frame frame;
+
+    SocketCan_Fill(port, &frame, data, size);
+
+    if (write(port->Fd, &frame, SocketCan_MTU(size)) < 0)
+    {
+        port->TxErrors++;
+        return 1;
+    }
+
+    port->TxFrames++;
+    return 0;
+}
+
+static uint64_t SocketCan_Now(void *user)
+{
+    struct timespec ts;
+
+    (void)user;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 实例的事件通知：写 eventfd 唤醒 MicroUDS_SocketCan_Poll（可在其他线程中调用）
+ */
+static void SocketCan_Notify(void *user, MicroUDS_Event_t event)
+{
+    MicroUDS_SocketCan_t *port = (MicroUDS_SocketCan_t *)user;
+    uint64_t one = 1;
+
+    (void)event;
+    ssize_t ret = write(port->WakeFd, &one, sizeof(one));
+    (void)ret; // 计数器已满时 epoll 仍然可读
+}
+
+/**
+ * @brief 等待超时不超过实例的下一个截止时刻
+ */
+static int SocketCan_Timeout(MicroUDS_SocketCan_t *port, int timeout_ms)
+{
+    uint32_t next = MicroUDS_NextDeadline(port->Uds);
+
+    if (next == MICROUDS_DEADLINE_NONE || (timeout_ms >= 0 && (uint32_t)timeout_ms <= next))
+        return timeout_ms;
+
+    return next > INT32_MAX ? INT32_MAX : (int)next;
+}
+
+static int SocketCan_TransmitBurst(void *user, const MicroUDS_Frame_t *frames, size_t count)
+{
+    MicroUDS_SocketCan_t *port = (MicroUDS_SocketCan_t *)user;
+
+    if (count > MICROUDS_SOCKETCAN_BATCH)
+        count = MICROUDS_SOCKETCAN_BATCH;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SocketCan_Fill(port, &port->Io->TxFrame[i], frames[i].data, frames[i].len);
+        port->Io->TxIov[i].iov_len = SocketCan_MTU(frames[i].len);
+    }
+
+    int sent = sendmmsg(port->Fd, port->Io->TxMsg, (unsigned int)count, MSG_DONTWAIT);
+    if (sent < 0)
+    {
+        port->TxErrors++;
+        return errno == EAGAIN || errno == ENOBUFS ? 0 : -1; // 发送队列满，稍后重试
+    }
+
+    port->TxFrames += (uint64_t)sent;
+    return sent;
+}
+
+/**
+ * @brief 从控制消息中取接收时间戳（硬件优先，其次软件）
+ */
+static void SocketCan_Timestamp(MicroUDS_SocketCan_t *port, struct msghdr *msg)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING)
+            continue;
+
+        const struct timespec *ts = (const struct timespec *)CMSG_DATA(cmsg); // [0] 软件, [2] 原始硬件
+        port->LastRx = (ts[2].tv_sec != 0 || ts[2].tv_nsec != 0) ? ts[2] : ts[0];
+    }
+}
+
+/**
+ * @brief 功能寻址帧：只接受单帧，按功能寻址请求交给实例（抑制 0x11/0x12/0x31 等NRC）
+ *
+ * @param port 端口
+ * @param frame 收到的帧
+ */
+static void SocketCan_ReceiveFunctional(MicroUDS_SocketCan_t *port, const struct canfd_frame *frame)
+{
+    Isotp_Payload_t payload;
+
+    if (Isotp_UnpackSingleFrameEx(&payload, frame->data, frame->len) != ISOTP_OK)
+        return; // 功能寻址不支持分段传输，首帧 / 连续帧 / 流控帧被忽略
+
+    MicroUDS_ReceiveFunctional(port->Uds, payload.Payload, payload.Size);
+}
+
+MicroUDS_Sta_t MicroUDS_SocketCan_Open(MicroUDS_SocketCan_t *port, const MicroUDS_SocketCanConf_t *conf)
+{
+    MICROUDS_CHECKPTR(port);
+    MICROUDS_CHECKPTR(conf);
+
+    if (conf->IfName == NULL || conf->RxId == 0)
+        return MICROUDS_ERR_PARAM;
+
+    memset(port, 0, sizeof(MicroUDS_SocketCan_t));
+    port->Fd = -1;
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+    port->CanFd = conf->CanFd;
+
+    canid_t eff = conf->Extended ? CAN_EFF_FLAG : 0;
+    canid_t mask = conf->Extended ? (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK) : (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK);
+    port->TxId = conf->TxId | eff;
+    port->FuncId = (conf->FuncId != 0 && conf->FuncId != conf->RxId) ? (conf->FuncId | eff) : 0;
+
+    port->Transport.Tx = SocketCan_Transmit;
+    port->Transport.TxBurst = SocketCan_TransmitBurst;
+    port->Transport.NowNs = SocketCan_Now;
+    port->Transport.MaxFrameSize = conf->CanFd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    port->Transport.Addressing.Source = conf->RxId;
+    port->Transport.Addressing.Target = conf->TxId;
+    port->Transport.Addressing.Functional = conf->FuncId;
+
+    port->Io = (struct MicroUDS_SocketCanIo *)calloc(1, sizeof(struct MicroUDS_SocketCanIo));
+    if (port->Io == NULL)
+        return MICROUDS_ERR_MEMORY;
+
+    port->Fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (port->Fd < 0)
+        goto fail;
+
+    /* 内核过滤：只接收物理 / 功能寻址的请求 */
+    struct can_filter filter[2] = {
+        {.can_id = conf->RxId | eff, .can_mask = mask},
+        {.can_id = conf->FuncId | eff, .can_mask = mask},
+    };
+    socklen_t nfilter = conf->FuncId ? 2 : 1;
+    if (setsockopt(port->Fd, SOL_CAN_RAW, CAN_RAW_FILTER, filter, nfilter * sizeof(struct can_filter)) < 0)
+        goto fail;
+
+    int off = 0;
+    setsockopt(port->Fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &off, sizeof(off));
+
+    if (conf->CanFd)
+    {
+        int on = 1;
+        if (setsockopt(port->Fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &on, sizeof(on)) < 0)
+            goto fail;
+    }
+
+    /* 接收时间戳：硬件不可用时内核仍提供软件时间戳 */
+    int ts = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (conf->HwTimestamp)
+        ts |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(port->Fd, SOL_SOCKET, SO_TIMESTAMPING, &ts, sizeof(ts)) < 0 && conf->HwTimestamp)
+    {
+        ts = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        setsockopt(port->Fd, SOL_SOCKET, SO_TIMESTAMPING, &ts, sizeof(ts));
+    }
+
+    struct ifreq ifr = {0};
+    strncpy(ifr.ifr_name, conf->IfName, IFNAMSIZ - 1);
+    if (ioctl(port->Fd, SIOCGIFINDEX, &ifr) < 0)
+        goto fail;
+
+    struct sockaddr_can addr = {
+        .can_family = AF_CAN,
+        .can_ifindex = ifr.ifr_ifindex,
+    };
+    if (bind(port->Fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        goto fail;
+
+    port->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (port->EpollFd < 0)
+        goto fail;
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = port->Fd};
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->Fd, &ev) < 0)
+        goto fail;
+
+    port->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (port->WakeFd < 0)
+        goto fail;
+
+    ev.data.fd = port->WakeFd;
+    if (epoll_ctl(port->EpollFd, EPOLL_CTL_ADD, port->WakeFd, &ev) < 0)
+        goto fail;
+
+    /* recvmmsg / sendmmsg 的消息数组只需建立一次 */
+    for (size_t i = 0; i < MICROUDS_SOCKETCAN_BATCH; i++)
+    {
+        port->Io->RxIov[i].iov_base = &port->Io->RxFrame[i];
+        port->Io->RxIov[i].iov_len = sizeof(struct canfd_frame);
+        port->Io->RxMsg[i].msg_hdr.msg_iov = &port->Io->RxIov[i];
+        port->Io->RxMsg[i].msg_hdr.msg_iovlen = 1;
+
+        port->Io->TxIov[i].iov_base = &port->Io->TxFrame[i];
+        port->Io->TxMsg[i].msg_hdr.msg_iov = &port->Io->TxIov[i];
+        port->Io->TxMsg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    return MICROUDS_OK;
+
+fail:
+    MicroUDS_SocketCan_Close(port);
+    return MICROUDS_ERR;
+}
+
+void MicroUDS_SocketCan_Attach(MicroUDS_SocketCan_t *port, MicroUDS_Conf_t *conf)
+{
+    if (port == NULL || conf == NULL)
+        return;
+
+    conf->Transport = &port->Transport;
+    conf->TransportCtx = port;
+    conf->Notify = SocketCan_Notify;
+    conf->NotifyCtx = port;
+}
+
+void MicroUDS_SocketCan_Bind(MicroUDS_SocketCan_t *port, MicroUDS_Handle_t handle)
+{
+    if (port != NULL)
+        port->Uds = handle;
+}
+
+int MicroUDS_SocketCan_Poll(MicroUDS_SocketCan_t *port, int timeout_ms)
+{
+    if (port == NULL || port->Fd < 0 || port->Uds == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct epoll_event ev[2];
+    int ready = epoll_wait(port->EpollFd, ev, 2, SocketCan_Timeout(port, timeout_ms));
+    if (ready <= 0)
+        return ready < 0 && errno == EINTR ? 0 : ready;
+
+    bool rx = false;
+    for (int i = 0; i < ready; i++)
+    {
+        if (ev[i].data.fd == port->WakeFd)
+        {
+            uint64_t count;
+            ssize_t ret = read(port->WakeFd, &count, sizeof(count)); // 清除通知，调用者随后调用 MicroUDS_TimerHandler
+            (void)ret;
+        }
+        else
+        {
+            rx = true;
+        }
+    }
+
+    if (!rx)
+        return 0;
+
+    int total = 0;
+
+    for (;;)
+    {
+        for (size_t i = 0; i < MICROUDS_SOCKETCAN_BATCH; i++)
+        {
+            port->Io->RxMsg[i].msg_hdr.msg_control = port->Io->RxCtrl[i];
+            port->Io->RxMsg[i].msg_hdr.msg_controllen = sizeof(port->Io->RxCtrl[i]);
+        }
+
+        int n = recvmmsg(port->Fd, port->Io->RxMsg, MICROUDS_SOCKETCAN_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0)
+            return errno == EAGAIN ? total : -1; // 已读空
+
+        for (int i = 0; i < n; i++)
+        {
+            struct canfd_frame *frame = &port->Io->RxFrame[i];
+
+            if (frame->can_id & CAN_ERR_FLAG)
+                continue;
+
+            SocketCan_Timestamp(port, &port->Io->RxMsg[i].msg_hdr);
+            if (port->FuncId != 0 && frame->can_id == port->FuncId)
+                SocketCan_ReceiveFunctional(port, frame);
+            else
+                MicroUDS_ReceiveFrame(port->Uds, frame->data, frame->len);
+        }
+
+        port->RxFrames += (uint64_t)n;
+        total += n;
+
+        if (n < MICROUDS_SOCKETCAN_BATCH)
+            return total;
+    }
+}
+
+void MicroUDS_SocketCan_Close(MicroUDS_SocketCan_t *port)
+{
+    if (port == NULL)
+        return;
+
+    if (port->EpollFd >= 0)
+        close(port->EpollFd);
+    if (port->WakeFd >= 0)
+        close(port->WakeFd);
+    if (port->Fd >= 0)
+        close(port->Fd);
+
+    free(port->Io);
+
+    port->EpollFd = -1;
+    port->WakeFd = -1;
+    port->Fd = -1;
+    port->Io = NULL;
+}
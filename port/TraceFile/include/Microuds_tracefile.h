@@ -0,0 +1,49 @@
+#ifndef MICROUDS_TRACEFILE_H
+#define MICROUDS_TRACEFILE_H
+
+/**
+ * @file Microuds_tracefile.h
+ * @author https://github.com/xfp23
+ * @brief Dump a MicroUDS frame trace ring to a file (POSIX).
+ *
+ * The file is sized for the worst case, memory-mapped, and filled in
+ * place by @ref MicroUDS_TraceExport. It is then truncated to the bytes
+ * actually written. No intermediate buffer or stdio is involved, so a
+ * large ring can be dumped from a signal-driven maintenance thread while
+ * the instances keep running.
+ *
+ * @version 0.1
+ * @date 2025-10-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "Microuds.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Write the ring to @p path in candump log or pcap format.
+ *
+ * An existing file is replaced.
+ *
+ * @param trace Initialized ring.
+ * @param path Output file.
+ * @param fmt Output format.
+ * @param ifname Interface name for candump lines (NULL = "can0").
+ * @return MicroUDS_Sta_t
+ * - MICROUDS_OK: File written.
+ * - MICROUDS_ERR_PARAM: Invalid arguments.
+ * - MICROUDS_ERR: A file or mmap call failed (see errno).
+ */
+extern MicroUDS_Sta_t MicroUDS_TraceFile_Dump(MicroUDS_Trace_t *trace, const char *path, MicroUDS_TraceFormat_t fmt, const char *ifname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#include "Microuds_tracefile.h"
+#include "Microuds_com.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MicroUDS_Sta_t MicroUDS_TraceFile_Dump(MicroUDS_Trace_t *trace, const char *path, MicroUDS_TraceFormat_t fmt, const char *ifname)
+{
+    MICROUDS_CHECKPTR(trace);
+    MICROUDS_CHECKPTR(path);
+
+    size_t cap = MicroUDS_TraceExport(trace, fmt, ifname, NULL, 0); // 最坏情况的大小
+    if (cap == 0)
+        return MICROUDS_ERR_PARAM;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return MICROUDS_ERR;
+
+    if (ftruncate(fd, (off_t)cap) != 0)
+    {
+        close(fd);
+        return MICROUDS_ERR;
+    }
+
+    uint8_t *map = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return MICROUDS_ERR;
+    }
+
+    size_t len = MicroUDS_TraceExport(trace, fmt, ifname, map, cap); // 直接写入文件映射
+    munmap(map, cap);
+
+    MicroUDS_Sta_t ret = ftruncate(fd, (off_t)len) == 0 ? MICROUDS_OK : MICROUDS_ERR; // 去掉未使用的部分
+    close(fd);
+
+    return ret;
+}
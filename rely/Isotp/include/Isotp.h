@@ -23,10 +23,11 @@ extern "C"
 {
 #endif
 
-/**
- * @brief Global ISO-TP protocol handle.
+/*
+ * All functions are stateless: frames are built and parsed directly in the
+ * caller's buffers, so they are re-entrant and safe to call concurrently
+ * from several threads or protocol instances.
  */
-extern Isotp_Handle_t const Isotp_Handle;
 
 /**
  * @brief Pack an ISO-TP Single Frame (SF) into a CAN frame buffer.
@@ -146,6 +147,184 @@ extern Isotp_Sta_t Isotp_PackConsecutiveFrame(uint8_t *Dst, uint8_t *Src, size_t
  */
 extern Isotp_Sta_t Isotp_UnPackConsecutiveFrame(Isotp_ConsecutiveFrame_t *Dst, uint8_t *Src);
 
+/*------------------------------------------
+  Frame-length aware API (classic CAN and CAN FD)
+
+  frame_len is the channel's TX_DL: 8 for classic CAN, or one of the
+  CAN FD data lengths 12, 16, 20, 24, 32, 48, 64. With frame_len > 8:
+  - a Single Frame longer than 7 bytes uses the SF_DL escape
+    (byte 0 = 0x00, byte 1 = SF_DL, up to frame_len - 2 bytes);
+  - a message longer than 4095 bytes uses the FF_DL escape
+    (bytes 0-1 = 0x10 0x00, bytes 2-5 = 32-bit length, big endian).
+  The FF_DL escape is also used on classic CAN when the length needs it.
+-------------------------------------------*/
+
+/**
+ * @brief Round a payload length up to the next valid CAN FD data length.
+ *
+ * @param len Number of used bytes (0–64).
+ * @return size_t 8, 12, 16, 20, 24, 32, 48 or 64 (never less than 8).
+ */
+extern size_t Isotp_FrameLength(size_t len);
+
+/**
+ * @brief Largest message that fits into one Single Frame.
+ *
+ * @param frame_len Channel frame length (TX_DL).
+ * @return size_t 7 for classic CAN, frame_len - 2 for CAN FD.
+ */
+extern size_t Isotp_SingleFrameMax(size_t frame_len);
+
+/**
+ * @brief Pack a Single Frame for a channel with the given frame length.
+ *
+ * @param Dst       Destination frame buffer (at least frame_len bytes).
+ * @param frame_len Channel frame length (TX_DL).
+ * @param Src       Message.
+ * @param size      Message length (1 – @ref Isotp_SingleFrameMax).
+ * @param out_len   Receives the number of bytes to transmit (DLC-rounded).
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame packed successfully.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers or frame length.
+ *         - ISOTP_ERR_LENGTH: Message does not fit.
+ */
+extern Isotp_Sta_t Isotp_PackSingleFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *out_len);
+
+/**
+ * @brief Pack a First Frame for a channel with the given frame length.
+ *
+ * Always fills the whole frame (frame_len bytes).
+ *
+ * @param Dst       Destination frame buffer (frame_len bytes).
+ * @param frame_len Channel frame length (TX_DL).
+ * @param Src       Complete message.
+ * @param size      Total message length (> @ref Isotp_SingleFrameMax).
+ * @param consumed  Receives the number of message bytes carried by the FF.
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame packed successfully.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers or frame length.
+ *         - ISOTP_ERR_LENGTH: Message fits a Single Frame or exceeds 32 bits.
+ */
+extern Isotp_Sta_t Isotp_PackFirstFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *consumed);
+
+/**
+ * @brief Pack a Consecutive Frame for a channel with the given frame length.
+ *
+ * Carries up to frame_len - 1 bytes; a shorter last frame is DLC-rounded.
+ *
+ * @param Dst       Destination frame buffer (frame_len bytes).
+ * @param frame_len Channel frame length (TX_DL).
+ * @param Src       Remaining message data.
+ * @param size      Remaining length (≥ 1), at most frame_len - 1 bytes are used.
+ * @param SN        Sequence number (0–15).
+ * @param consumed  Receives the number of message bytes carried.
+ * @param out_len   Receives the number of bytes to transmit.
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame packed successfully.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers, frame length or SN.
+ *         - ISOTP_ERR_LENGTH: size is 0.
+ */
+extern Isotp_Sta_t Isotp_PackConsecutiveFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, uint8_t SN,
+                                                size_t *consumed, size_t *out_len);
+
+/**
+ * @brief Parse a received Single Frame of any length.
+ *
+ * @param Dst Parsed payload (points into @p Src).
+ * @param Src Raw frame.
+ * @param len Received frame length (1–64).
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame parsed.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers.
+ *         - ISOTP_ERR_TYPE:   Not a Single Frame.
+ *         - ISOTP_ERR_LENGTH: SF_DL is 0 or larger than the frame.
+ */
+extern Isotp_Sta_t Isotp_UnpackSingleFrameEx(Isotp_Payload_t *Dst, const uint8_t *Src, size_t len);
+
+/**
+ * @brief Parse a received First Frame of any length (12-bit or escaped 32-bit FF_DL).
+ *
+ * @param Dst Parsed payload (points into @p Src), Total = FF_DL.
+ * @param Src Raw frame.
+ * @param len Received frame length (8–64).
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame parsed.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers.
+ *         - ISOTP_ERR_TYPE:   Not a First Frame.
+ *         - ISOTP_ERR_LENGTH: Frame too short or FF_DL invalid.
+ */
+extern Isotp_Sta_t Isotp_UnpackFirstFrameEx(Isotp_Payload_t *Dst, const uint8_t *Src, size_t len);
+
+/**
+ * @brief Parse a received Flow Control frame of any length (at least 3 bytes).
+ *
+ * @param Dst Flow Control structure (unused bytes are zero).
+ * @param Src Raw frame.
+ * @param len Received frame length.
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frame parsed.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers.
+ *         - ISOTP_ERR_TYPE:   Not a Flow Control frame.
+ *         - ISOTP_ERR_LENGTH: Frame shorter than 3 bytes.
+ */
+extern Isotp_Sta_t Isotp_UnpackFlowControlFrameEx(Isotp_FlowControlFrame_t *Dst, const uint8_t *Src, size_t len);
+
+/*------------------------------------------
+  Batch segmentation
+
+  Turns a message into ready-to-send frames in one pass, written into a
+  caller-supplied contiguous array. With Stride / Length pointing into an
+  array of driver frame structures (e.g. struct can_frame or canfd_frame),
+  the result can go straight to DMA, sendmmsg() or a vectored transmit.
+-------------------------------------------*/
+
+/**
+ * @brief Number of frames needed to send a message.
+ *
+ * @param frame_len Channel frame length (TX_DL).
+ * @param size      Message length.
+ * @return size_t 1 for a Single Frame, otherwise FF + CFs; 0 on invalid input.
+ */
+extern size_t Isotp_SegmentCount(size_t frame_len, size_t size);
+
+/**
+ * @brief Segment a whole message (SF, or FF followed by all CFs).
+ *
+ * Sequence numbers start at 1 after the FF and wrap at 15.
+ *
+ * @param Dst       Output frame array, at least @ref Isotp_SegmentCount frames.
+ * @param frame_len Channel frame length (TX_DL).
+ * @param Src       Message.
+ * @param size      Message length.
+ * @param count     Receives the number of frames written.
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         All frames written.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers, frame length or stride.
+ *         - ISOTP_ERR_LENGTH: Array too small or invalid message length.
+ */
+extern Isotp_Sta_t Isotp_SegmentMessage(const Isotp_FrameArray_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *count);
+
+/**
+ * @brief Segment the next run of Consecutive Frames.
+ *
+ * Fills at most Dst->Count frames (e.g. one Flow Control block, or the free
+ * part of a ring) from the remaining data; call again to continue.
+ *
+ * @param Dst       Output frame array.
+ * @param frame_len Channel frame length (TX_DL).
+ * @param Src       Remaining message data.
+ * @param size      Remaining length (≥ 1).
+ * @param SN        Sequence number of the first CF (0–15).
+ * @param consumed  Receives the number of message bytes carried.
+ * @param count     Receives the number of frames written.
+ * @return Isotp_Sta_t
+ *         - ISOTP_OK:         Frames written.
+ *         - ISOTP_ERR_PARAM:  Invalid pointers, frame length, stride or SN.
+ *         - ISOTP_ERR_LENGTH: size is 0.
+ */
+extern Isotp_Sta_t Isotp_SegmentConsecutive(const Isotp_FrameArray_t *Dst, size_t frame_len, const uint8_t *Src, size_t size,
+                                            uint8_t SN, size_t *consumed, size_t *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,10 @@ typedef enum
     ISOTP_ERR_FRAME, // 帧错误
 } Isotp_Sta_t;
 
+#define ISOTP_CAN_DL          8u    // 经典CAN帧长度
+#define ISOTP_CANFD_DL        64u   // CAN FD 最大帧长度
+#define ISOTP_FF_DL_12BIT_MAX 0xFFFu // 12位 FF_DL 能表示的最大长度，超过时使用32位转义
+
 typedef enum
 {
     FRAME_SINGLE = 0x00,      // 单帧 
@@ -126,15 +130,27 @@ typedef union
 } Isotp_ConsecutiveFrame_t;
 
 
+/*------------------------------------------
+  ISO-TP 帧解析结果（任意帧长度，CAN / CAN FD）
+-------------------------------------------*/
+typedef struct
+{
+    const uint8_t *Payload; // 帧内数据起始（指向原始帧）
+    size_t Size;            // 帧内数据长度
+    uint32_t Total;         // 报文总长度（SF = Size，FF = FF_DL）
+} Isotp_Payload_t;
+
+/*------------------------------------------
+  批量分段输出：连续存放的帧数组
+-------------------------------------------*/
 typedef struct
 {
-    Isotp_SingleFrame_t SF;      // 单帧
-    Isotp_FirstFrame_t FF;       // 首帧
-    Isotp_FlowControlFrame_t FC; // 流控帧
-    Isotp_ConsecutiveFrame_t CF; // 连续帧
-} Isotp_Obj;
+    uint8_t *Frames; // 第一帧数据起始地址
+    uint8_t *Length; // 可选，第一帧长度字节的地址（NULL 不输出），与 Frames 同样按 Stride 递增
+    size_t Stride;   // 相邻两帧的地址间隔，至少为帧长度（如 sizeof(struct can_frame)）
+    size_t Count;    // 数组容量（帧数）
+} Isotp_FrameArray_t;
 
-typedef Isotp_Obj *Isotp_Handle_t;
 
 #ifdef __cplusplus
 }
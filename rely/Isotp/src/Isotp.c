@@ -1,7 +1,9 @@
 #include "Isotp.h"
 
-static Isotp_Obj Isotp = {0};
-Isotp_Handle_t const Isotp_Handle = &Isotp;
+/*
+ * 所有函数直接在调用者的缓冲区中构建/解析帧，不使用任何共享状态，
+ * 可在多个线程、多个实例中同时调用
+ */
 
 Isotp_Sta_t Isotp_PackSingleFrame(uint8_t *Dst, const uint8_t *Src, size_t size)
 {
@@ -11,12 +13,9 @@ Isotp_Sta_t Isotp_PackSingleFrame(uint8_t *Dst, const uint8_t *Src, size_t size)
     if (size == 0 || size > 7)
         return ISOTP_ERR_LENGTH;
 
-    memset(Isotp_Handle->SF.data, 0, sizeof(Isotp_Handle->SF.data));
-
-    Isotp_Handle->SF.byte.PCIType = FRAME_SINGLE;
-    Isotp_Handle->SF.byte.PCI_DL = (uint8_t)(size & 0x0F);
-    memcpy(Isotp_Handle->SF.byte.Payload, Src, size);
-    memcpy(Dst, Isotp_Handle->SF.data, 8);
+    Dst[0] = (uint8_t)((FRAME_SINGLE << 4) | size);
+    memcpy(Dst + 1, Src, size);
+    memset(Dst + 1 + size, 0, 7 - size);
 
     return ISOTP_OK;
 }
@@ -26,20 +25,20 @@ Isotp_Sta_t Isotp_UnpackSingleFrame(Isotp_SingleFrame_t *Dst, const uint8_t *Src
     if (!Dst || !Src)
         return ISOTP_ERR_PARAM;
 
-    memcpy(Dst->data, Src, 8);
-
-    if (Dst->byte.PCIType != FRAME_SINGLE)
+    if ((Src[0] >> 4) != FRAME_SINGLE)
     {
         memset(Dst->data, 0, 8);
         return ISOTP_ERR_TYPE;
     }
 
-    if (Dst->byte.PCI_DL > 7)
+    if ((Src[0] & 0x0F) > 7)
     {
         memset(Dst->data, 0, 8);
         return ISOTP_ERR_LENGTH;
     }
 
+    memcpy(Dst->data, Src, 8);
+
     return ISOTP_OK;
 }
 
@@ -51,14 +50,9 @@ Isotp_Sta_t Isotp_PackFirstFrame(uint8_t *Dst, const uint8_t *Src, size_t size)
     if (size <= 7 || size > 0xFFF) // FF 只用于 >7 字节的情况
         return ISOTP_ERR_LENGTH;
 
-    memset(Isotp_Handle->FF.data, 0, sizeof(Isotp_Handle->FF.data));
-
-    Isotp_Handle->FF.byte.PCIType = FRAME_FIRST;
-    Isotp_Handle->FF.byte.FF_DL_H = (size >> 8) & 0x0F;
-    Isotp_Handle->FF.byte.FF_DL_L = size & 0xFF;
-
-    memcpy(Isotp_Handle->FF.byte.Payload, Src, 6);
-    memcpy(Dst, Isotp_Handle->FF.data, 8);
+    Dst[0] = (uint8_t)((FRAME_FIRST << 4) | ((size >> 8) & 0x0F));
+    Dst[1] = (uint8_t)(size & 0xFF);
+    memcpy(Dst + 2, Src, 6);
 
     return ISOTP_OK;
 }
@@ -68,14 +62,14 @@ Isotp_Sta_t Isotp_UnpackFirstFrame(Isotp_FirstFrame_t *Dst, const uint8_t *Src)
     if (Dst == NULL || Src == NULL)
         return ISOTP_ERR_PARAM;
 
-    memcpy(Dst->data, Src, 8);
-
-    if (Dst->byte.PCIType != FRAME_FIRST)
+    if ((Src[0] >> 4) != FRAME_FIRST)
     {
         memset(Dst->data, 0, 8);
         return ISOTP_ERR_TYPE;
     }
 
+    memcpy(Dst->data, Src, 8);
+
     return ISOTP_OK;
 }
 
@@ -84,14 +78,10 @@ Isotp_Sta_t Isotp_PackFlowControlFrame(uint8_t *Dst, uint8_t bs, uint8_t STmin,
     if (Dst == NULL)
         return ISOTP_ERR_PARAM;
 
-    memset(Isotp_Handle->FC.data, 0, 8);
-
-    Isotp_Handle->FC.data[0] = (FRAME_FLOWCONTROL << 4) | (fs & 0x0F);
-
-    Isotp_Handle->FC.data[1] = bs;      // Block Size
-    Isotp_Handle->FC.data[2] = STmin;   // Separation Time
-    
-    memcpy(Dst, Isotp_Handle->FC.data, 8);
+    Dst[0] = (uint8_t)((FRAME_FLOWCONTROL << 4) | (fs & 0x0F));
+    Dst[1] = bs;      // Block Size
+    Dst[2] = STmin;   // Separation Time
+    memset(Dst + 3, 0, 5);
 
     return ISOTP_OK;
 }
@@ -99,16 +89,17 @@ Isotp_Sta_t Isotp_PackFlowControlFrame(uint8_t *Dst, uint8_t bs, uint8_t STmin,
 
 Isotp_Sta_t Isotp_UnpackFlowControlFrame(Isotp_FlowControlFrame_t *Dst, uint8_t *Src)
 {
-    if (Dst == NULL)
+    if (Dst == NULL || Src == NULL)
         return ISOTP_ERR_PARAM;
 
-    memcpy(Dst->data, Src, 8);
-    if (Dst->byte.PCIType != FRAME_FLOWCONTROL)
+    if ((Src[0] >> 4) != FRAME_FLOWCONTROL)
     {
         memset(Dst->data, 0, 8);
         return ISOTP_ERR_TYPE;
     }
 
+    memcpy(Dst->data, Src, 8);
+
     return ISOTP_OK;
 }
 
@@ -122,14 +113,11 @@ Isotp_Sta_t Isotp_PackConsecutiveFrame(uint8_t *Dst, uint8_t *Src, size_t size,
 
     if (SN > 0x0F)
         return ISOTP_ERR_PARAM;
-        
-    memset(Isotp_Handle->CF.data, 0, 8);
 
-    Isotp_Handle->CF.byte.PCIType = FRAME_CONSECUTIVE;
-    Isotp_Handle->CF.byte.SN = SN;
-    memcpy(Isotp_Handle->CF.byte.Payload, Src, size);
+    Dst[0] = (uint8_t)((FRAME_CONSECUTIVE << 4) | SN);
+    memcpy(Dst + 1, Src, size);
+    memset(Dst + 1 + size, 0, 7 - size);
 
-    memcpy(Dst, Isotp_Handle->CF.data, 8);
     return ISOTP_OK;
 }
 
@@ -138,19 +126,317 @@ Isotp_Sta_t Isotp_UnPackConsecutiveFrame(Isotp_ConsecutiveFrame_t *Dst, uint8_t
     if (Dst == NULL || Src == NULL)
         return ISOTP_ERR_PARAM;
 
-    memcpy(Dst->data, Src, 8);
-
-    if (Dst->byte.PCIType != FRAME_CONSECUTIVE)
+    if ((Src[0] >> 4) != FRAME_CONSECUTIVE)
     {
         memset(Dst->data, 0, 8);
         return ISOTP_ERR_TYPE;
     }
 
-    if (Dst->byte.SN > 0x0F)
+    memcpy(Dst->data, Src, 8); // SN 为4位，不会超过 0x0F
+
+    return ISOTP_OK;
+}
+
+/*------------------------------------------
+  任意帧长度（CAN / CAN FD）
+-------------------------------------------*/
+
+/**
+ * @brief 帧长度是否为合法的 TX_DL（8 或 CAN FD 的 12–64）
+ */
+static bool Isotp_ValidFrameLength(size_t frame_len)
+{
+    return frame_len >= ISOTP_CAN_DL && frame_len <= ISOTP_CANFD_DL && Isotp_FrameLength(frame_len) == frame_len;
+}
+
+size_t Isotp_FrameLength(size_t len)
+{
+    static const uint8_t dl[] = {8, 12, 16, 20, 24, 32, 48, 64};
+
+    for (size_t i = 0; i < sizeof(dl); i++)
     {
-        memset(Dst->data, 0, 8);
-        return ISOTP_ERR_FRAME;
+        if (len <= dl[i])
+            return dl[i];
+    }
+
+    return ISOTP_CANFD_DL;
+}
+
+size_t Isotp_SingleFrameMax(size_t frame_len)
+{
+    return frame_len > ISOTP_CAN_DL ? frame_len - 2 : 7;
+}
+
+Isotp_Sta_t Isotp_PackSingleFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *out_len)
+{
+    if (Dst == NULL || Src == NULL || out_len == NULL || !Isotp_ValidFrameLength(frame_len))
+        return ISOTP_ERR_PARAM;
+
+    if (size == 0 || size > Isotp_SingleFrameMax(frame_len))
+        return ISOTP_ERR_LENGTH;
+
+    size_t pci = 1;
+
+    if (size <= 7) // 经典格式，CAN FD 上同样有效
+    {
+        Dst[0] = (uint8_t)((FRAME_SINGLE << 4) | size);
+    }
+    else // SF_DL 转义
+    {
+        Dst[0] = FRAME_SINGLE << 4;
+        Dst[1] = (uint8_t)size;
+        pci = 2;
+    }
+
+    size_t total = Isotp_FrameLength(pci + size);
+
+    memcpy(Dst + pci, Src, size);
+    memset(Dst + pci + size, 0, total - pci - size);
+    *out_len = total;
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_PackFirstFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *consumed)
+{
+    if (Dst == NULL || Src == NULL || consumed == NULL || !Isotp_ValidFrameLength(frame_len))
+        return ISOTP_ERR_PARAM;
+
+    if (size <= Isotp_SingleFrameMax(frame_len) || (uint64_t)size > UINT32_MAX)
+        return ISOTP_ERR_LENGTH;
+
+    size_t pci;
+
+    if (size <= ISOTP_FF_DL_12BIT_MAX)
+    {
+        Dst[0] = (uint8_t)((FRAME_FIRST << 4) | ((size >> 8) & 0x0F));
+        Dst[1] = (uint8_t)(size & 0xFF);
+        pci = 2;
+    }
+    else // FF_DL 转义：12位为0，后接32位长度（大端）
+    {
+        Dst[0] = FRAME_FIRST << 4;
+        Dst[1] = 0;
+        Dst[2] = (uint8_t)(size >> 24);
+        Dst[3] = (uint8_t)(size >> 16);
+        Dst[4] = (uint8_t)(size >> 8);
+        Dst[5] = (uint8_t)size;
+        pci = 6;
     }
 
+    *consumed = frame_len - pci;
+    memcpy(Dst + pci, Src, *consumed);
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_PackConsecutiveFrameEx(uint8_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, uint8_t SN,
+                                         size_t *consumed, size_t *out_len)
+{
+    if (Dst == NULL || Src == NULL || consumed == NULL || out_len == NULL || SN > 0x0F || !Isotp_ValidFrameLength(frame_len))
+        return ISOTP_ERR_PARAM;
+
+    if (size == 0)
+        return ISOTP_ERR_LENGTH;
+
+    size_t copy = size < frame_len - 1 ? size : frame_len - 1;
+    size_t total = Isotp_FrameLength(copy + 1); // 最后一帧可以按DLC缩短
+
+    Dst[0] = (uint8_t)((FRAME_CONSECUTIVE << 4) | SN);
+    memcpy(Dst + 1, Src, copy);
+    memset(Dst + 1 + copy, 0, total - 1 - copy);
+
+    *consumed = copy;
+    *out_len = total;
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_UnpackSingleFrameEx(Isotp_Payload_t *Dst, const uint8_t *Src, size_t len)
+{
+    if (Dst == NULL || Src == NULL || len == 0)
+        return ISOTP_ERR_PARAM;
+
+    if ((Src[0] >> 4) != FRAME_SINGLE)
+        return ISOTP_ERR_TYPE;
+
+    size_t pci = 1;
+    size_t size = Src[0] & 0x0F;
+
+    if (size == 0 && len > ISOTP_CAN_DL) // SF_DL 转义
+    {
+        size = Src[1];
+        pci = 2;
+        if (size <= 7)
+            return ISOTP_ERR_LENGTH; // 转义只用于超过7字节的单帧
+    }
+
+    if (size == 0 || (pci == 1 && size > 7) || pci + size > len)
+        return ISOTP_ERR_LENGTH;
+
+    Dst->Payload = Src + pci;
+    Dst->Size = size;
+    Dst->Total = (uint32_t)size;
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_UnpackFirstFrameEx(Isotp_Payload_t *Dst, const uint8_t *Src, size_t len)
+{
+    if (Dst == NULL || Src == NULL)
+        return ISOTP_ERR_PARAM;
+
+    if (len < ISOTP_CAN_DL)
+        return ISOTP_ERR_LENGTH;
+
+    if ((Src[0] >> 4) != FRAME_FIRST)
+        return ISOTP_ERR_TYPE;
+
+    size_t pci = 2;
+    uint32_t total = ((uint32_t)(Src[0] & 0x0F) << 8) | Src[1];
+
+    if (total == 0) // FF_DL 转义
+    {
+        total = ((uint32_t)Src[2] << 24) | ((uint32_t)Src[3] << 16) | ((uint32_t)Src[4] << 8) | Src[5];
+        pci = 6;
+        if (total <= ISOTP_FF_DL_12BIT_MAX)
+            return ISOTP_ERR_LENGTH;
+    }
+
+    if (total <= len - pci)
+        return ISOTP_ERR_LENGTH; // 能装进本帧的报文不应使用首帧
+
+    Dst->Payload = Src + pci;
+    Dst->Size = len - pci;
+    Dst->Total = total;
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_UnpackFlowControlFrameEx(Isotp_FlowControlFrame_t *Dst, const uint8_t *Src, size_t len)
+{
+    if (Dst == NULL || Src == NULL)
+        return ISOTP_ERR_PARAM;
+
+    if (len < 3)
+        return ISOTP_ERR_LENGTH;
+
+    if ((Src[0] >> 4) != FRAME_FLOWCONTROL)
+        return ISOTP_ERR_TYPE;
+
+    memset(Dst->data, 0, sizeof(Dst->data));
+    memcpy(Dst->data, Src, len < sizeof(Dst->data) ? len : sizeof(Dst->data));
+
+    return ISOTP_OK;
+}
+
+/*------------------------------------------
+  批量分段
+-------------------------------------------*/
+
+/**
+ * @brief 检查输出帧数组
+ */
+static bool Isotp_ValidFrameArray(const Isotp_FrameArray_t *Dst, size_t frame_len)
+{
+    return Dst != NULL && Dst->Frames != NULL && Dst->Stride >= frame_len;
+}
+
+size_t Isotp_SegmentCount(size_t frame_len, size_t size)
+{
+    if (!Isotp_ValidFrameLength(frame_len) || size == 0 || (uint64_t)size > UINT32_MAX)
+        return 0;
+
+    if (size <= Isotp_SingleFrameMax(frame_len))
+        return 1;
+
+    size_t ff = frame_len - (size <= ISOTP_FF_DL_12BIT_MAX ? 2 : 6);
+    size_t cf = frame_len - 1;
+
+    return 1 + (size - ff + cf - 1) / cf;
+}
+
+Isotp_Sta_t Isotp_SegmentConsecutive(const Isotp_FrameArray_t *Dst, size_t frame_len, const uint8_t *Src, size_t size,
+                                     uint8_t SN, size_t *consumed, size_t *count)
+{
+    if (Src == NULL || consumed == NULL || count == NULL || SN > 0x0F || !Isotp_ValidFrameLength(frame_len) ||
+        !Isotp_ValidFrameArray(Dst, frame_len))
+        return ISOTP_ERR_PARAM;
+
+    if (size == 0)
+        return ISOTP_ERR_LENGTH;
+
+    size_t offset = 0;
+    size_t n = 0;
+    uint8_t *frame = Dst->Frames;
+    uint8_t *length = Dst->Length;
+
+    while (offset < size && n < Dst->Count)
+    {
+        size_t copy, total;
+
+        Isotp_PackConsecutiveFrameEx(frame, frame_len, Src + offset, size - offset, SN, &copy, &total);
+        if (length)
+        {
+            *length = (uint8_t)total;
+            length += Dst->Stride;
+        }
+
+        offset += copy;
+        SN = (uint8_t)((SN + 1) & 0x0F);
+        frame += Dst->Stride;
+        n++;
+    }
+
+    *consumed = offset;
+    *count = n;
+
+    return ISOTP_OK;
+}
+
+Isotp_Sta_t Isotp_SegmentMessage(const Isotp_FrameArray_t *Dst, size_t frame_len, const uint8_t *Src, size_t size, size_t *count)
+{
+    if (Src == NULL || count == NULL || !Isotp_ValidFrameLength(frame_len) || !Isotp_ValidFrameArray(Dst, frame_len))
+        return ISOTP_ERR_PARAM;
+
+    size_t need = Isotp_SegmentCount(frame_len, size);
+    if (need == 0 || need > Dst->Count)
+        return ISOTP_ERR_LENGTH;
+
+    size_t first;
+
+    if (need == 1)
+    {
+        Isotp_Sta_t ret = Isotp_PackSingleFrameEx(Dst->Frames, frame_len, Src, size, &first);
+        if (ret == ISOTP_OK)
+        {
+            if (Dst->Length)
+                *Dst->Length = (uint8_t)first;
+            *count = 1;
+        }
+        return ret;
+    }
+
+    Isotp_Sta_t ret = Isotp_PackFirstFrameEx(Dst->Frames, frame_len, Src, size, &first);
+    if (ret != ISOTP_OK)
+        return ret;
+
+    if (Dst->Length)
+        *Dst->Length = (uint8_t)frame_len;
+
+    Isotp_FrameArray_t cfs = {
+        .Frames = Dst->Frames + Dst->Stride,
+        .Length = Dst->Length ? Dst->Length + Dst->Stride : NULL,
+        .Stride = Dst->Stride,
+        .Count = Dst->Count - 1,
+    };
+    size_t consumed, n;
+
+    ret = Isotp_SegmentConsecutive(&cfs, frame_len, Src + first, size - first, 1, &consumed, &n);
+    if (ret != ISOTP_OK)
+        return ret;
+
+    *count = n + 1;
+
     return ISOTP_OK;
 }
@@ -14,88 +14,1651 @@
 #include "stdlib.h"
 #include "string.h"
 
-static MicroUDS_Obj MicroUDS = {0};
-MicroUDS_Handle_t const MicroUDS_Handle = &MicroUDS;
+static void MicroUDS_ClearRecv(MicroUDS_Handle_t handle);
+static uint8_t *MicroUDS_TxBuffer(MicroUDS_Handle_t handle);
+static void MicroUDS_TxRelease(MicroUDS_Handle_t handle);
+static void MicroUDS_ReqPush(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, bool multi, bool functional);
+static MicroUDS_Sta_t MicroUDS_SendNRC(MicroUDS_Handle_t handle, uint8_t sid, MicroUDS_NRC_t code);
+static MicroUDS_Sta_t MicroUDS_SendSingleFrame(MicroUDS_Handle_t handle, const uint8_t *data, size_t len);
+static bool MicroUDS_SendWhole(MicroUDS_Handle_t handle, const uint8_t *data, size_t len, MicroUDS_Sta_t *ret);
+static void MicroUDS_PendingStart(MicroUDS_Handle_t handle);
+static void MicroUDS_PendingFinish(MicroUDS_Handle_t handle, MicroUDS_NRC_t nrc, size_t len);
+static MicroUDS_Tick_t MicroUDS_StminTick(uint8_t stmin);
+static uint64_t MicroUDS_StminNs(uint8_t stmin);
+static MicroUDS_Tick_t MicroUDS_StminDeadline(MicroUDS_Handle_t handle);
+static void MicroUDS_TimerProcess(MicroUDS_Handle_t handle);
+static void MicroUDS_UpdateClock(MicroUDS_Handle_t handle);
+static bool MicroUDS_Due(MicroUDS_Handle_t handle);
+#if MICROUDS_TRACE_ENABLE
+static void MicroUDS_TraceRecord(MicroUDS_Handle_t handle, MicroUDS_TraceKind_t kind, const uint8_t *data, size_t len);
+#endif
+#if MICROUDS_RX_QUEUE_DEPTH
+static void MicroUDS_RxQueueDrain(MicroUDS_Handle_t handle);
+#endif
 
-static void MicroUDS_ClearRecv(void);
+/**
+ * @brief 给一个响应
+ *
+ * @param handle 实例句柄
+ * @param code NRC码
+ */
+static inline void MicroUDS_Response(MicroUDS_Handle_t handle, MicroUDS_NRC_t code);
+
+/**
+ * @brief 分配清零的内部内存
+ *
+ * 配置了 Arena 时从用户内存区顺序分配（不使用堆），否则使用 calloc
+ *
+ * @param handle 实例句柄
+ * @param size 字节数
+ * @return void* 失败返回NULL
+ */
+static void *MicroUDS_Alloc(MicroUDS_Handle_t handle, size_t size)
+{
+    if (handle->Arena.base == NULL)
+        return calloc(1, size);
+
+    size = MICROUDS_ALIGN(size);
+    if (size > handle->Arena.size - handle->Arena.used)
+        return NULL;
+
+    void *ptr = handle->Arena.base + handle->Arena.used;
+    handle->Arena.used += size;
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/**
+ * @brief 释放 MicroUDS_Alloc 分配的内存，Arena 模式下不做任何事
+ *
+ * @param handle 实例句柄
+ * @param ptr
+ */
+static void MicroUDS_Free(MicroUDS_Handle_t handle, void *ptr)
+{
+    if (handle->Arena.base == NULL)
+        free(ptr);
+}
+
+/**
+ * @brief 根据SID查找服务
+ *
+ * 直接索引模式下为一次表查找，否则走哈希表
+ *
+ * @param handle 实例句柄
+ * @param sid 服务ID
+ * @return Microuds_Service_t* 未注册返回NULL
+ */
+static inline Microuds_Service_t *MicroUDS_FindService(MicroUDS_Handle_t handle, uint8_t sid)
+{
+#if MICROUDS_DISPATCH_TABLE
+    uint8_t index = handle->Dispatch[sid];
+    return index ? &handle->Services[index - 1] : NULL;
+#else
+    uintptr_t index = (uintptr_t)MicroHash_Find(&handle->hashTable, (MicroHash_key_t)sid); // 哈希表保存序号，数组增长后仍然有效
+    return index ? &handle->Services[index - 1] : NULL;
+#endif
+}
+
+/**
+ * @brief 32位置位计数
+ *
+ * @param x
+ * @return uint8_t
+ */
+static inline uint8_t MicroUDS_PopCount(uint32_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint8_t)__builtin_popcount(x);
+#else
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (uint8_t)((x * 0x01010101u) >> 24);
+#endif
+}
+
+/**
+ * @brief 最低置位的位置
+ *
+ * @param x 非0
+ * @return uint8_t
+ */
+static inline uint8_t MicroUDS_Ctz(uint32_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint8_t)__builtin_ctz(x);
+#else
+    return MicroUDS_PopCount((x & (0u - x)) - 1u);
+#endif
+}
+
+/**
+ * @brief 最高置位的位置
+ *
+ * @param x 非0
+ * @return uint8_t
+ */
+static inline uint8_t MicroUDS_Log2(uint32_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint8_t)(31 - __builtin_clz(x));
+#else
+    uint8_t n = 0;
+    while (x >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+/**
+ * @brief 从缓冲池借用一个块（无锁，可被多个线程上的实例同时调用）
+ *
+ * @param pool 缓冲池
+ * @return uint8_t* 无空闲块返回NULL
+ */
+static uint8_t *MicroUDS_PoolAcquire(MicroUDS_Pool_t *pool)
+{
+    for (size_t w = 0; w < pool->words; w++)
+    {
+        uint_least32_t map = atomic_load_explicit(&pool->map[w], memory_order_relaxed);
+
+        while ((uint32_t)map != 0xFFFFFFFFu)
+        {
+            uint8_t bit = MicroUDS_Ctz(~(uint32_t)map);
+            if (atomic_compare_exchange_weak_explicit(&pool->map[w], &map, map | ((uint_least32_t)1 << bit),
+                                                      memory_order_acquire, memory_order_relaxed))
+                return pool->blocks + (w * 32u + bit) * pool->block_size;
+        }
+    }
+
+    atomic_fetch_add_explicit(&pool->exhausted, 1, memory_order_relaxed);
+    return NULL;
+}
+
+/**
+ * @brief 归还借用的块
+ *
+ * @param pool 缓冲池
+ * @param block MicroUDS_PoolAcquire 返回的块
+ */
+static void MicroUDS_PoolRelease(MicroUDS_Pool_t *pool, uint8_t *block)
+{
+    size_t index = (size_t)(block - pool->blocks) / pool->block_size;
+
+    atomic_fetch_and_explicit(&pool->map[index / 32u], ~((uint_least32_t)1 << (index % 32u)), memory_order_release);
+}
+
+/**
+ * @brief 64位最低置位的位置
+ *
+ * @param x 非0
+ * @return uint8_t
+ */
+static inline uint8_t MicroUDS_Ctz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint8_t)__builtin_ctzll(x);
+#else
+    uint32_t lo = (uint32_t)x;
+    return lo != 0 ? MicroUDS_Ctz(lo) : (uint8_t)(32u + MicroUDS_Ctz((uint32_t)(x >> 32)));
+#endif
+}
+
+#define MICROUDS_WHEEL_MASK ((uint32_t)MICROUDS_WHEEL_SLOTS - 1u)
+#define MICROUDS_WHEEL_SPAN (1u << (MICROUDS_WHEEL_BITS * MICROUDS_WHEEL_LEVELS)) // 时间轮覆盖的滴答数
+
+/**
+ * @brief 按到期时间把节点挂入时间轮
+ *
+ * 已到期的节点挂入到期链表；超出时间轮范围的节点先放在最高层，级联时重新计算
+ *
+ * @param wheel 时间轮
+ * @param node 未挂入的节点
+ */
+static void MicroUDS_WheelLink(MicroUDS_Wheel_t *wheel, MicroUDS_TimerNode_t *node)
+{
+    MicroUDS_TimerNode_t **head;
+    uint32_t delta = node->expires - wheel->now;
+
+    if ((int32_t)delta <= 0)
+    {
+        head = &wheel->due;
+        node->where = MICROUDS_WHEEL_DUE;
+    }
+    else
+    {
+        uint32_t expires = node->expires;
+        if (delta > MICROUDS_WHEEL_SPAN)
+        {
+            delta = MICROUDS_WHEEL_SPAN;
+            expires = wheel->now + delta;
+        }
+
+        /* 第 level 层覆盖 delta <= 64^(level+1)：delta 恰为边界时落在当前槽位，正好在下一圈到达，
+           级联（now = t - 1）时也不会落回刚取下的槽位 */
+        uint32_t level = 0;
+        while (delta > (1u << (MICROUDS_WHEEL_BITS * (level + 1u))))
+            level++;
+
+        uint32_t index = (expires >> (MICROUDS_WHEEL_BITS * level)) & MICROUDS_WHEEL_MASK;
+        head = &wheel->slot[level][index];
+        wheel->occupied[level] |= (uint64_t)1 << index;
+        node->where = (uint16_t)(level * MICROUDS_WHEEL_SLOTS + index);
+    }
+
+    node->next = *head;
+    if (*head != NULL)
+        (*head)->pprev = &node->next;
+    *head = node;
+    node->pprev = head;
+    wheel->count++;
+}
+
+/**
+ * @brief 从时间轮中摘下节点（未挂入时不做任何事）
+ *
+ * @param wheel 时间轮
+ * @param node 节点
+ */
+static void MicroUDS_WheelUnlink(MicroUDS_Wheel_t *wheel, MicroUDS_TimerNode_t *node)
+{
+    if (node->pprev == NULL)
+        return;
+
+    *node->pprev = node->next;
+    if (node->next != NULL)
+        node->next->pprev = node->pprev;
+
+    if (node->where < MICROUDS_WHEEL_LEVELS * MICROUDS_WHEEL_SLOTS)
+    {
+        uint32_t level = node->where / MICROUDS_WHEEL_SLOTS;
+        uint32_t index = node->where % MICROUDS_WHEEL_SLOTS;
+        if (wheel->slot[level][index] == NULL)
+            wheel->occupied[level] &= ~((uint64_t)1 << index);
+    }
+
+    node->next = NULL;
+    node->pprev = NULL;
+    wheel->count--;
+}
+
+/**
+ * @brief 取下整个槽位，节点标记为未挂入
+ *
+ * @param wheel 时间轮
+ * @param level 层
+ * @param index 槽
+ * @return MicroUDS_TimerNode_t* 节点链表
+ */
+static MicroUDS_TimerNode_t *MicroUDS_WheelTake(MicroUDS_Wheel_t *wheel, uint32_t level, uint32_t index)
+{
+    MicroUDS_TimerNode_t *list = wheel->slot[level][index];
+
+    wheel->slot[level][index] = NULL;
+    wheel->occupied[level] &= ~((uint64_t)1 << index);
+
+    for (MicroUDS_TimerNode_t *node = list; node != NULL; node = node->next)
+    {
+        node->pprev = NULL;
+        wheel->count--;
+    }
+
+    return list;
+}
+
+/**
+ * @brief 级联：滴答 t 跨过低层一圈时，把高层对应槽位中的节点重新分配到低层
+ *
+ * @param wheel 时间轮（now = t - 1）
+ * @param t 即将处理的滴答，低 MICROUDS_WHEEL_BITS 位为0
+ */
+static void MicroUDS_WheelCascade(MicroUDS_Wheel_t *wheel, uint32_t t)
+{
+    uint32_t top = 1;
+    while (top + 1u < MICROUDS_WHEEL_LEVELS && ((t >> (MICROUDS_WHEEL_BITS * top)) & MICROUDS_WHEEL_MASK) == 0)
+        top++;
+
+    for (uint32_t level = top; level >= 1u; level--)
+    {
+        uint32_t index = (t >> (MICROUDS_WHEEL_BITS * level)) & MICROUDS_WHEEL_MASK;
+        MicroUDS_TimerNode_t *node = MicroUDS_WheelTake(wheel, level, index);
+
+        while (node != NULL)
+        {
+            MicroUDS_TimerNode_t *next = node->next;
+            MicroUDS_WheelLink(wheel, node);
+            node = next;
+        }
+    }
+}
+
+/**
+ * @brief 时间轮节点所属的实例
+ */
+static inline MicroUDS_Handle_t MicroUDS_WheelOwner(MicroUDS_TimerNode_t *node)
+{
+    return (MicroUDS_Handle_t)(void *)((uint8_t *)node - offsetof(MicroUDS_Obj, Timer));
+}
+
+/**
+ * @brief 对链表中的每个实例调用 MicroUDS_TimerHandler，处理时实例重新挂入时间轮
+ *
+ * 链表先整体移到 run，再逐个摘下处理：处理一个实例时（如回环发送）另一个实例
+ * 可能被移动，链表始终保持一致
+ *
+ * @param wheel 时间轮
+ * @param head 槽头或到期链表
+ * @param level 层，到期链表时忽略
+ * @param index 槽，到期链表时忽略
+ * @return size_t 调用次数
+ */
+static size_t MicroUDS_WheelExpire(MicroUDS_Wheel_t *wheel, MicroUDS_TimerNode_t **head, uint32_t level, uint32_t index)
+{
+    size_t n = 0;
+
+    wheel->run = *head;
+    *head = NULL;
+    if (head != &wheel->due)
+        wheel->occupied[level] &= ~((uint64_t)1 << index);
+
+    if (wheel->run != NULL)
+        wheel->run->pprev = &wheel->run;
+    for (MicroUDS_TimerNode_t *node = wheel->run; node != NULL; node = node->next)
+        node->where = MICROUDS_WHEEL_RUN;
+
+    while (wheel->run != NULL)
+    {
+        MicroUDS_TimerNode_t *node = wheel->run;
+        MicroUDS_WheelUnlink(wheel, node);
+        MicroUDS_TimerHandler(MicroUDS_WheelOwner(node));
+        n++;
+    }
+
+    return n;
+}
+
+/**
+ * @brief 滴答 at 与 now 之间的距离（已过期为0），取较小者
+ */
+static inline void MicroUDS_Earliest(MicroUDS_Tick_t now, MicroUDS_Tick_t at, MicroUDS_Tick_t *best)
+{
+    MicroUDS_Tick_t d = at > now ? at - now : 0;
+
+    if (d < *best)
+        *best = d;
+}
+
+/**
+ * @brief 计算实例下一次需要处理的时刻：S3、N_Cr、N_Bs、STmin、P2/P2* 以及待处理的请求
+ *
+ * @param handle 实例句柄
+ * @param deadline 到期滴答
+ * @return true 有定时任务
+ */
+static bool MicroUDS_Deadline(MicroUDS_Handle_t handle, MicroUDS_Tick_t *deadline)
+{
+    MicroUDS_Tick_t now = handle->Tick;
+    MicroUDS_Tick_t best = UINT64_MAX;
+
+#if MICROUDS_RX_QUEUE_DEPTH
+    if (atomic_load_explicit(&handle->RxQueue.head, memory_order_relaxed) !=
+        atomic_load_explicit(&handle->RxQueue.tail, memory_order_relaxed))
+        best = 0; // 有待处理的帧
+#endif
+
+    if (handle->Pending.active)
+    {
+        if (atomic_load_explicit(&handle->Pending.state, memory_order_relaxed) == MICROUDS_PENDING_DONE)
+            best = 0; // 最终响应待发送
+        else
+            MicroUDS_Earliest(now, handle->Pending.last_tick + handle->Pending.interval, &best); // P2 / P2*
+#if MICROUDS_PENDING_TIMEOUT_MS
+        MicroUDS_Earliest(now, handle->Pending.start + MICROUDS_MS_TICK(MICROUDS_PENDING_TIMEOUT_MS), &best);
+#endif
+    }
+    else if (handle->ReqQueue.count != 0 && handle->Tx.state == MICROUDS_TX_IDLE)
+    {
+        best = 0; // 排队的请求
+    }
+
+    if (handle->Tx.state == MICROUDS_TX_WAIT_FC)
+        MicroUDS_Earliest(now, handle->Tx.last_tick + MICROUDS_MS_TICK(MICROUDS_TIMEOUT_N_BS_MS), &best); // N_Bs
+    else if (handle->Tx.state == MICROUDS_TX_SENDING)
+        MicroUDS_Earliest(now, handle->Tx.stmin == 0 ? now : MicroUDS_StminDeadline(handle), &best); // STmin
+
+    if (handle->N_Cs.Active)
+        MicroUDS_Earliest(now, handle->N_Cs.lash_tick + handle->N_Cs.Timeout, &best); // N_Cr
+
+    if (!handle->Pending.active && (handle->sid != UDS_DIAGNOSTIC_SESSION_CONTROL || handle->ssid != UDS_SESSION_DEFAULT))
+        MicroUDS_Earliest(now, handle->last_time + handle->Timeout, &best); // S3（挂起期间停止）
+
+    if (best == UINT64_MAX)
+        return false;
+
+    *deadline = now + best;
+    return true;
+}
+
+/**
+ * @brief 处理结束后重新计算截止时刻，并在时间轮中移动实例
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_Reschedule(MicroUDS_Handle_t handle)
+{
+    handle->Armed = MicroUDS_Deadline(handle, &handle->Deadline);
+
+    if (handle->Wheel == NULL)
+        return;
+
+    MicroUDS_WheelUnlink(handle->Wheel, &handle->Timer);
+    if (handle->Armed)
+    {
+        /* 时间轮使用自己的32位时钟：按距离换算，超出范围的在级联时重新计算 */
+        MicroUDS_Tick_t delta = handle->Deadline - handle->Tick;
+        handle->Timer.expires = handle->Wheel->now + (delta < MICROUDS_WHEEL_SPAN ? (uint32_t)delta : MICROUDS_WHEEL_SPAN);
+        MicroUDS_WheelLink(handle->Wheel, &handle->Timer);
+    }
+}
+
+/**
+ * @brief 从中断或其他线程唤醒时间轮上的实例（无锁，可重入）
+ *
+ * 实例压入时间轮的唤醒栈，由下一次 MicroUDS_WheelRun 处理
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_WheelWake(MicroUDS_Handle_t handle)
+{
+    MicroUDS_Wheel_t *wheel = handle->Wheel;
+
+    if (atomic_exchange_explicit(&handle->Woken, true, memory_order_acq_rel))
+        return; // 已经在栈中
+
+    MicroUDS_Obj *head = atomic_load_explicit(&wheel->ready, memory_order_relaxed);
+    do
+    {
+        handle->WakeNext = head;
+    } while (!atomic_compare_exchange_weak_explicit(&wheel->ready, &head, handle, memory_order_release, memory_order_relaxed));
+}
+
+/**
+ * @brief 状态在 MicroUDS_TimerHandler 之外发生变化（收到帧、发送报文），下一次调用立即处理
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_Kick(MicroUDS_Handle_t handle)
+{
+    handle->Deadline = handle->Tick;
+    handle->Armed = true;
+
+    if (handle->Wheel == NULL)
+        return;
+
+    MicroUDS_WheelUnlink(handle->Wheel, &handle->Timer);
+    handle->Timer.expires = handle->Wheel->now;
+    MicroUDS_WheelLink(handle->Wheel, &handle->Timer);
+}
+
+/**
+ * @brief 通知应用实例有新工作（可在中断或其他线程中调用）
+ *
+ * 已通知且尚未被 MicroUDS_TimerHandler 处理，或正在 MicroUDS_TimerHandler 中时不再通知
+ *
+ * @param handle 实例句柄
+ * @param event 事件
+ */
+static void MicroUDS_Notify(MicroUDS_Handle_t handle, MicroUDS_Event_t event)
+{
+    if (handle->Notify == NULL)
+        return;
+
+    /* 顺序一致：与 MicroUDS_NotifyRearm 配对，先发布的数据要么在那里被看到，要么在这里通知 */
+    if (atomic_exchange_explicit(&handle->Notified, true, memory_order_seq_cst))
+        return;
+
+    handle->Notify(handle->NotifyCtx, event);
+}
+
+/**
+ * @brief MicroUDS_TimerHandler 处理结束，重新允许通知
+ *
+ * 处理期间被抑制的事件（其他线程入队的帧、完成的请求）或尚未处理完的请求在这里补发通知
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_NotifyRearm(MicroUDS_Handle_t handle)
+{
+    atomic_store_explicit(&handle->Notified, false, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (handle->Pending.active && atomic_load_explicit(&handle->Pending.state, memory_order_acquire) == MICROUDS_PENDING_DONE)
+        MicroUDS_Notify(handle, MICROUDS_EVENT_COMPLETE);
+    else if (MicroUDS_Due(handle))
+        MicroUDS_Notify(handle, handle->Tx.state == MICROUDS_TX_SENDING ? MICROUDS_EVENT_TX : MICROUDS_EVENT_RX);
+}
+
+/**
+ * @brief 当前时刻（ns）：有纳秒时钟时直接读取，否则由时基换算
+ *
+ * @param handle 实例句柄
+ * @return uint64_t
+ */
+static inline uint64_t MicroUDS_ClockNs(MicroUDS_Handle_t handle)
+{
+    if (handle->Transport.NowNs != NULL)
+        return handle->Transport.NowNs(handle->TransportCtx);
+
+    return handle->Tick / MICROUDS_TICK_FREQ_HZ * 1000000000u + handle->Tick % MICROUDS_TICK_FREQ_HZ * 1000000000u / MICROUDS_TICK_FREQ_HZ;
+}
+
+/**
+ * @brief 统计用的时刻 (μs)
+ *
+ * @param handle 实例句柄
+ * @return uint64_t 未统计时为0
+ */
+static uint64_t MicroUDS_StatsNow(MicroUDS_Handle_t handle)
+{
+#if MICROUDS_STATS_ENABLE
+    if (handle->Stats == NULL)
+        return 0;
+
+    return MicroUDS_ClockNs(handle) / 1000u;
+#else
+    (void)handle;
+    return 0;
+#endif
+}
+
+/**
+ * @brief 延迟所在的直方图桶
+ *
+ * 小于 MICROUDS_STATS_SUB 的值各占一桶，之后每个2的幂区间等分为 MICROUDS_STATS_SUB 桶
+ *
+ * @param us 延迟 (μs)，超过32位按最大值计
+ * @return size_t
+ */
+static inline size_t MicroUDS_StatsBucket(uint64_t us)
+{
+    uint32_t v = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+
+    if (v < MICROUDS_STATS_SUB)
+        return v;
+
+    uint8_t e = MicroUDS_Log2(v);
+    return (size_t)(e - MICROUDS_STATS_SUB_BITS + 1u) * MICROUDS_STATS_SUB + ((v >> (e - MICROUDS_STATS_SUB_BITS)) & (MICROUDS_STATS_SUB - 1u));
+}
+
+/**
+ * @brief 统计一次请求分发，开始计时
+ *
+ * @param handle 实例句柄
+ * @param sid 请求SID
+ */
+static void MicroUDS_StatsRequest(MicroUDS_Handle_t handle, uint8_t sid)
+{
+#if MICROUDS_STATS_ENABLE
+    if (handle->Stats == NULL)
+        return;
+
+    atomic_fetch_add_explicit(&handle->Stats->Requests[sid], 1, memory_order_relaxed);
+    handle->ReqTimed = true;
+    handle->ReqPended = false;
+#else
+    (void)handle;
+    (void)sid;
+#endif
+}
+
+/**
+ * @brief 统计一条发送的响应：负响应按NRC计数，其余计为正响应
+ *
+ * @param handle 实例句柄
+ * @param data 响应报文
+ * @param len 报文长度
+ */
+static void MicroUDS_StatsTx(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
+{
+#if MICROUDS_STATS_ENABLE
+    if (handle->Stats == NULL)
+        return;
+
+    if (len >= 3 && data[0] == 0x7F)
+        atomic_fetch_add_explicit(&handle->Stats->Nrc[data[2]], 1, memory_order_relaxed);
+    else
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_POSITIVE);
+#else
+    (void)handle;
+    (void)data;
+    (void)len;
+#endif
+}
+
+/**
+ * @brief 当前请求的响应（0x78 除外）开始发送：记录从请求就绪到此刻的延迟
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_StatsAnswer(MicroUDS_Handle_t handle)
+{
+#if MICROUDS_STATS_ENABLE
+    if (handle->Stats == NULL || !handle->ReqTimed)
+        return;
+
+    handle->ReqTimed = false; // 每个请求只记录第一条响应
+
+    uint64_t now = MicroUDS_StatsNow(handle);
+    atomic_uint_least32_t *hist = handle->ReqPended ? handle->Stats->PendingLatency : handle->Stats->Latency;
+    atomic_fetch_add_explicit(&hist[MicroUDS_StatsBucket(now > handle->ReqAt ? now - handle->ReqAt : 0)], 1, memory_order_relaxed);
+#else
+    (void)handle;
+#endif
+}
+
+/**
+ * @brief 写入一条跟踪记录（无锁，可在中断中调用）
+ *
+ * 领取序号后先把记录标记为写入中，写完再发布序号；导出时跳过写入中或已被覆盖的记录
+ *
+ * @param handle 实例句柄
+ * @param kind 记录类型
+ * @param data 帧数据或事件参数
+ * @param len 数据长度，超过 MICROUDS_FRAME_MAX 时截断
+ */
+#if MICROUDS_TRACE_ENABLE
+static void MicroUDS_TraceRecord(MicroUDS_Handle_t handle, MicroUDS_TraceKind_t kind, const uint8_t *data, size_t len)
+{
+    MicroUDS_Trace_t *trace = handle->Trace;
+    uint32_t seq = atomic_fetch_add_explicit(&trace->head, 1, memory_order_relaxed);
+    MicroUDS_TraceRec_t *rec = &trace->rec[seq & trace->mask];
+
+    atomic_store_explicit(&rec->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // 先标记写入中，再改写内容
+
+    if (len > sizeof(rec->data))
+        len = sizeof(rec->data);
+
+    rec->kind = (uint8_t)kind;
+    rec->len = (uint8_t)len;
+    rec->flags = handle->FrameLen > ISOTP_CAN_DL ? MICROUDS_TRACE_FD : 0u;
+    rec->id = kind == MICROUDS_TRACE_TX ? handle->Transport.Addressing.Target : handle->Transport.Addressing.Source;
+    rec->ts = trace->Clock != NULL ? trace->Clock(trace->ClockCtx) : MicroUDS_ClockNs(handle);
+    memcpy(rec->data, data, len);
+
+    atomic_store_explicit(&rec->seq, seq + 1u, memory_order_release); // 发布
+}
+#endif
+
+/**
+ * @brief 32位大端写入
+ */
+static inline void MicroUDS_PutBe32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief 子功能在紧凑数组中的位置（位图中排在 key 之前的子功能个数）
+ *
+ * @param svc 服务
+ * @param key 子功能位图索引 (MICROUDS_SSID_KEY)
+ * @return size_t
+ */
+static inline size_t MicroUDS_SessionIndex(const Microuds_Service_t *svc, uint8_t key)
+{
+    uint8_t w = key >> 5;
+    uint32_t below = svc->SessionMap[w] & ((1u << (key & 0x1F)) - 1u);
+
+    return (size_t)svc->SessionBase[w] + MicroUDS_PopCount(below);
+}
+
+/**
+ * @brief 根据ssid查找子功能，耗时与已注册的子功能数量无关
+ *
+ * @param svc 服务
+ * @param ssid 子功能
+ * @return MicroUDS_Session_t* 未注册返回NULL
+ */
+static inline MicroUDS_Session_t *MicroUDS_FindSession(const Microuds_Service_t *svc, uint8_t ssid)
+{
+    uint8_t key = MICROUDS_SSID_KEY(ssid);
+
+    if (!MICROUDS_SSID_TEST(svc->SessionMap, key))
+        return NULL;
+
+    return &svc->Session[MicroUDS_SessionIndex(svc, key)];
+}
+
+/**
+ * @brief 调用处理函数并发送响应
+ *
+ * @param handle 实例句柄
+ * @param handler 新接口处理函数，可为NULL
+ * @param func 旧接口处理函数，可为NULL
+ * @param param 用户参数
+ * @param req 请求视图
+ * @param ssid 是否为子功能处理函数（响应中回显子功能）
+ * @param reply 是否发送响应，false 时只返回NRC（服务级预检查）
+ * @return MicroUDS_NRC_t 处理结果
+ */
+static MicroUDS_NRC_t MicroUDS_Invoke(MicroUDS_Handle_t handle, MicroUDS_HandlerFunc_t handler, MicroUDS_GeneralFunc_t func,
+                                      void *param, const MicroUDS_Request_t *req, bool ssid, bool reply)
+{
+    MicroUDS_NRC_t ret;
+
+    if (handler && MicroUDS_TxBuffer(handle) == NULL)
+    {
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_OVERFLOW);
+        ret = UDS_NRC_BUSY_REPEAT_REQUEST; // 发送缓冲池已空
+    }
+    else if (handler)
+    {
+        /* 响应直接构建在发送缓冲区中，发送时无需拷贝 */
+        MicroUDS_Response_t rsp = {
+            .buf = handle->Tx.buf,
+            .cap = handle->Tx.size,
+            .len = 0,
+        };
+        rsp.buf[rsp.len++] = (uint8_t)(req->sid + MICROUDS_RESPONSE_OFFSET);
+        if (ssid)
+            rsp.buf[rsp.len++] = req->ssid;
+
+        ret = handler(handle, req, &rsp, param);
+
+        if (reply && ret == UDS_NRC_SUCCESS)
+        {
+            MicroUDS_SendMessage(handle, rsp.buf, rsp.len);
+            MicroUDS_TxRelease(handle);
+            return ret;
+        }
+    }
+    else
+    {
+        ret = func(param);
+    }
+
+    if (reply)
+        MicroUDS_Response(handle, ret);
+
+    MicroUDS_TxRelease(handle);
+    return ret;
+}
+
+/**
+ * @brief 分发一个完整的请求
+ *
+ * 服务注册了子功能时：先查找子功能，服务级处理函数（如有）作为预检查，
+ * 只有返回 UDS_NRC_SUCCESS 才继续执行子功能处理函数，整个请求只响应一次。
+ *
+ * @param handle 实例句柄
+ * @param msg 请求报文（从SID开始）
+ * @param len 报文长度
+ * @param total 请求总长度（含SID），流式接收时 msg 只包含首帧数据，total 大于 len
+ */
+static void MicroUDS_Dispatch(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, size_t total)
+{
+    if (len == 0)
+        return;
+
+    MicroUDS_Request_t req = {
+        .sid = msg[0],
+        .ssid = len > 1 ? msg[1] : 0,
+        .data = msg + 1,
+        .len = len - 1,
+        .total = total - 1,
+    };
+
+    handle->sid = req.sid;
+    handle->ssid = req.ssid;
+    MicroUDS_StatsRequest(handle, req.sid);
+
+    Microuds_Service_t *svc = MicroUDS_FindService(handle, req.sid); // 找服务
+    if (!svc)
+    {
+        MicroUDS_NegativeResponse(handle, UDS_NRC_SERVICE_NOT_SUPPORTED);
+        return;
+    }
+
+    MicroUDS_Session_t *ses = NULL;
+    if (svc->SessionCount != 0)
+    {
+        ses = MicroUDS_FindSession(svc, req.ssid); // 找子功能
+        if (!ses)
+        {
+            MicroUDS_NegativeResponse(handle, UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+            return;
+        }
+    }
+
+    MICROUDS_ECUSETBUSY(handle); // ECU置忙
+    atomic_store_explicit(&handle->Pending.state, MICROUDS_PENDING_OPEN, memory_order_relaxed); // 处理函数可能在返回0x78之前交给其他线程完成
+
+    bool has_service = (svc->handler != NULL || svc->func != NULL);
+    bool has_session = (ses != NULL && (ses->handler != NULL || ses->func != NULL));
+
+    if (has_service)
+    {
+        MicroUDS_NRC_t ret = MicroUDS_Invoke(handle, svc->handler, svc->func, svc->param, &req, false, !has_session);
+        if (has_session && ret != UDS_NRC_SUCCESS)
+            MicroUDS_Response(handle, ret); // 预检查未通过
+        else if (has_session)
+            MicroUDS_Invoke(handle, ses->handler, ses->func, ses->param, &req, true, true);
+    }
+    else if (has_session)
+    {
+        MicroUDS_Invoke(handle, ses->handler, ses->func, ses->param, &req, true, true);
+    }
+    else if (ses == NULL)
+    {
+        MicroUDS_NegativeResponse(handle, UDS_NRC_SERVICE_NOT_SUPPORTED); // 服务没有任何处理函数
+    }
+
+    if (!handle->Pending.active)
+    {
+        atomic_store_explicit(&handle->Pending.state, MICROUDS_PENDING_CLOSED, memory_order_relaxed); // 拒绝迟到的完成
+        MICROUDS_ECUCLEAR(handle); // ECU清除忙等待，挂起的请求在完成时清除
+        handle->ReqTimed = false;  // 没有响应的请求不计延迟
+    }
+}
+
+/**
+ * @brief 结束挂起的请求：发送最终响应，恢复 S3 和请求队列
+ *
+ * @param handle 实例句柄
+ * @param nrc 最终结果
+ * @param len 最终正响应长度（已在发送缓冲区中），0 = 只发送 [SID + 0x40, SSID]
+ */
+static void MicroUDS_PendingFinish(MicroUDS_Handle_t handle, MicroUDS_NRC_t nrc, size_t len)
+{
+    MicroUDS_Pending_t *pending = &handle->Pending;
+
+    pending->active = false;
+    atomic_store_explicit(&pending->state, MICROUDS_PENDING_CLOSED, memory_order_relaxed);
+    handle->sid = pending->sid;
+    handle->ssid = pending->ssid;
+    handle->Reply = pending->reply;
+
+    if (nrc == UDS_NRC_SUCCESS && len != 0)
+        MicroUDS_SendMessage(handle, handle->Tx.buf, len);
+    else
+        MicroUDS_Response(handle, nrc);
+
+    memset(&handle->Reply, 0, sizeof(MicroUDS_Reply_t));
+    memset(&pending->reply, 0, sizeof(MicroUDS_Reply_t));
+    MicroUDS_TxRelease(handle);
+    MICROUDS_ECUCLEAR(handle);
+    MicroUDS_ResetTimer(handle); // S3 在挂起期间停止，最终响应之后重新开始
+}
+
+/**
+ * @brief 挂起当前请求，等待 MicroUDS_CompleteRequest
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_PendingStart(MicroUDS_Handle_t handle)
+{
+    handle->Pending.sid = handle->sid;
+    handle->Pending.ssid = handle->ssid;
+    handle->Pending.start = handle->Tick;
+    handle->Pending.last_tick = handle->Tick;
+    handle->Pending.interval = MICROUDS_MS_TICK(MICROUDS_TIMEOUT_P2_MS - MICROUDS_P2_MARGIN_MS);
+    handle->Pending.reply = handle->Reply; // 0x78 和最终响应发往同一去向
+    handle->Pending.active = true;
+    handle->ReqPended = true;
+    MICROUDS_STAT_INC(handle, MICROUDS_STAT_PENDING);
+}
 
 /**
- * @brief 给一个响应
+ * @brief 处理挂起的请求：完成时发送最终响应，否则按 P2/P2* 发送 0x78
+ *
+ * @param handle 实例句柄
+ * @return true 请求仍然挂起
+ */
+static bool MicroUDS_PendingProcess(MicroUDS_Handle_t handle)
+{
+    MicroUDS_Pending_t *pending = &handle->Pending;
+
+    if (!pending->active)
+        return false;
+
+    if (atomic_load_explicit(&pending->state, memory_order_acquire) == MICROUDS_PENDING_DONE)
+    {
+        MicroUDS_PendingFinish(handle, pending->nrc, pending->len);
+        return false;
+    }
+
+#if MICROUDS_PENDING_TIMEOUT_MS
+    if (handle->Tick - pending->start >= MICROUDS_MS_TICK(MICROUDS_PENDING_TIMEOUT_MS))
+    {
+        uint_least8_t open = MICROUDS_PENDING_OPEN;
+        if (atomic_compare_exchange_strong_explicit(&pending->state, &open, MICROUDS_PENDING_CLOSED,
+                                                    memory_order_acq_rel, memory_order_relaxed))
+        {
+            MicroUDS_PendingFinish(handle, UDS_NRC_GENERAL_REJECT, 0); // 一直没有完成：放弃，之后的完成被拒绝
+            return false;
+        }
+        return true; // 其他线程正在写入最终响应，下一次调用发送
+    }
+#endif
+
+    if (handle->Tick - pending->last_tick >= pending->interval)
+    {
+        pending->last_tick = handle->Tick;
+        pending->interval = MICROUDS_MS_TICK(MICROUDS_TIMEOUT_P2_STAR_MS - MICROUDS_P2_MARGIN_MS);
+        handle->Reply = pending->reply;
+        MicroUDS_SendNRC(handle, pending->sid, UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING);
+        memset(&handle->Reply, 0, sizeof(MicroUDS_Reply_t));
+    }
+
+    return true;
+}
+
+MicroUDS_Sta_t MicroUDS_CompleteRequest(MicroUDS_Handle_t handle, MicroUDS_NRC_t nrc, const uint8_t *data, size_t len)
+{
+    MICROUDS_CHECKPTR(handle);
+
+    if (nrc == UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING || len > handle->Tx.size || (len != 0 && data == NULL))
+        return MICROUDS_ERR_PARAM;
+
+    /* 只有处理函数运行中或挂起的请求可以完成：没有挂起的请求、已经完成或超时放弃时拒绝，
+       避免写入可能正被分段发送的发送缓冲区 */
+    uint_least8_t open = MICROUDS_PENDING_OPEN;
+    if (!atomic_compare_exchange_strong_explicit(&handle->Pending.state, &open, MICROUDS_PENDING_FILLING,
+                                                 memory_order_acquire, memory_order_relaxed))
+        return MICROUDS_ERR;
+
+    /* 挂起期间发送缓冲区空闲，最终响应直接放入其中（使用发送缓冲池时此时借用） */
+    if (len != 0 && MicroUDS_TxBuffer(handle) == NULL)
+    {
+        atomic_store_explicit(&handle->Pending.state, MICROUDS_PENDING_OPEN, memory_order_release);
+        return MICROUDS_ERR_BUSY;
+    }
+    if (len != 0 && data != handle->Tx.buf)
+        memcpy(handle->Tx.buf, data, len);
+
+    handle->Pending.nrc = nrc;
+    handle->Pending.len = len;
+    atomic_store_explicit(&handle->Pending.state, MICROUDS_PENDING_DONE, memory_order_release);
+
+    if (handle->Wheel != NULL)
+        MicroUDS_WheelWake(handle); // 可能在其他线程中完成
+    MicroUDS_Notify(handle, MICROUDS_EVENT_COMPLETE);
+
+    return MICROUDS_OK;
+}
+
+uint8_t *MicroUDS_ResponseReserve(MicroUDS_Response_t *rsp, size_t n)
+{
+    if (rsp == NULL || n > rsp->cap - rsp->len)
+        return NULL;
+
+    uint8_t *ptr = rsp->buf + rsp->len;
+    rsp->len += n;
+
+    return ptr;
+}
+
+MicroUDS_Sta_t MicroUDS_ResponseAppend(MicroUDS_Response_t *rsp, const void *data, size_t n)
+{
+    MICROUDS_CHECKPTR(data);
+
+    uint8_t *ptr = MicroUDS_ResponseReserve(rsp, n);
+    if (ptr == NULL)
+        return MICROUDS_ERR_MEMORY;
+
+    memcpy(ptr, data, n);
+
+    return MICROUDS_OK;
+}
+
+MicroUDS_Sta_t MicroUDS_PositiveResponse(MicroUDS_Handle_t handle)
+{
+    MICROUDS_CHECKPTR(handle);
+
+    uint8_t data[2] = {0};
+    size_t len = 0;
+
+    /* SID + 0x40 表示正响应 */
+    data[0] = (uint8_t)(handle->sid + MICROUDS_RESPONSE_OFFSET);
+    len = 1;
+
+    if (handle->ssid != 0)
+        data[len++] = (uint8_t)handle->ssid;
+
+    MicroUDS_StatsTx(handle, data, len);
+    MicroUDS_StatsAnswer(handle);
+
+    return MicroUDS_SendSingleFrame(handle, data, len);
+}
+
+MicroUDS_Sta_t MicroUDS_NegativeResponse(MicroUDS_Handle_t handle, MicroUDS_NRC_t code)
+{
+    MICROUDS_CHECKPTR(handle);
+
+    if (code != UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING)
+        MicroUDS_StatsAnswer(handle);
+
+    return MicroUDS_SendNRC(handle, handle->sid, code);
+}
+
+/**
+ * @brief 对指定SID发送负响应（接收路径使用，不改变当前请求的SID）
  *
+ * @param handle 实例句柄
+ * @param sid 请求SID
  * @param code NRC码
+ * @return MicroUDS_Sta_t
+ */
+static MicroUDS_Sta_t MicroUDS_SendNRC(MicroUDS_Handle_t handle, uint8_t sid, MicroUDS_NRC_t code)
+{
+    uint8_t data[3];
+
+    /* 功能寻址请求不回复这些NRC（ISO 14229-1），其他ECU可能支持该服务 */
+    if (handle->Reply.Functional)
+    {
+        switch (code)
+        {
+        case UDS_NRC_SERVICE_NOT_SUPPORTED:
+        case UDS_NRC_SUBFUNCTION_NOT_SUPPORTED:
+        case UDS_NRC_REQUEST_OUT_OF_RANGE:
+        case UDS_NRC_SUBFUNCTION_NOT_SUPPORTED_ACTIVE_SESSION:
+        case UDS_NRC_SERVICE_NOT_SUPPORTED_ACTIVE_SESSION:
+            return MICROUDS_OK;
+        default:
+            break;
+        }
+    }
+
+    data[0] = 0x7F;
+    data[1] = sid;
+    data[2] = (uint8_t)code;
+
+    MicroUDS_StatsTx(handle, data, sizeof(data));
+
+    return MicroUDS_SendSingleFrame(handle, data, sizeof(data));
+}
+
+/**
+ * @brief 以单帧发送一条报文
+ *
+ * 经典CAN始终发送完整 8 字节帧；CAN FD 按 DLC 向上取整
+ *
+ * @param handle 实例句柄
+ * @param data 报文
+ * @param len 报文长度（不超过 MICROUDS_SF_MAX）
+ * @return MicroUDS_Sta_t
+ */
+static MicroUDS_Sta_t MicroUDS_SendSingleFrame(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
+{
+    uint8_t frame[MICROUDS_FRAME_MAX];
+    size_t frame_len;
+    MicroUDS_Sta_t ret;
+
+    if (MicroUDS_SendWhole(handle, data, len, &ret))
+        return ret;
+
+    if (Isotp_PackSingleFrameEx(frame, handle->FrameLen, data, len, &frame_len) != ISOTP_OK)
+        return MICROUDS_ERR;
+
+    MICROUDS_SAFE_CALL_TRANSMIT(handle, frame, frame_len);
+
+    return MICROUDS_OK;
+}
+
+/**
+ * @brief 整报文发送：提交请求的响应函数优先，其次报文模式的传输层
+ *
+ * @param handle 实例句柄
+ * @param data 报文
+ * @param len 报文长度
+ * @param ret 发送结果
+ * @return true 已按整报文处理，不再分帧
+ */
+static bool MicroUDS_SendWhole(MicroUDS_Handle_t handle, const uint8_t *data, size_t len, MicroUDS_Sta_t *ret)
+{
+    if (handle->Reply.Func != NULL)
+        *ret = handle->Reply.Func(handle->Reply.Ctx, data, len) == 0 ? MICROUDS_OK : MICROUDS_ERR_TRANS;
+    else if (handle->Transport.TxMessage != NULL)
+        *ret = handle->Transport.TxMessage(handle->TransportCtx, data, len) == 0 ? MICROUDS_OK : MICROUDS_ERR_TRANS;
+    else
+        return false;
+
+    if (*ret != MICROUDS_OK)
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ERROR);
+
+    return true;
+}
+
+/**
+ * @brief STmin 原始值转换为纳秒
+ *
+ * 0x00–0x7F 为毫秒；0xF1–0xF9 为 100–900 μs；保留值按 0x7F 处理 (ISO 15765-2)
+ *
+ * @param stmin FC 中的 STmin
+ * @return uint64_t
+ */
+static uint64_t MicroUDS_StminNs(uint8_t stmin)
+{
+    if (stmin <= 0x7F)
+        return stmin * 1000000ull;
+
+    if (stmin >= 0xF1 && stmin <= 0xF9)
+        return (stmin - 0xF0u) * 100000ull;
+
+    return 0x7F * 1000000ull;
+}
+
+/**
+ * @brief STmin 原始值转换为滴答数，向上取整
+ *
+ * 不足一个滴答的 STmin（如 1 kHz 时基下的 0xF1–0xF9）按一个滴答处理，
+ * 配合严格大于的比较，两帧间隔不会小于 STmin
+ *
+ * @param stmin FC 中的 STmin
+ * @return MicroUDS_Tick_t
+ */
+static MicroUDS_Tick_t MicroUDS_StminTick(uint8_t stmin)
+{
+    return (MicroUDS_StminNs(stmin) * MICROUDS_TICK_FREQ_HZ + 999999999u) / 1000000000u;
+}
+
+/**
+ * @brief 距上一连续帧是否已过 STmin
+ *
+ * 有纳秒时钟时按纳秒比较，不受时基精度限制；否则按滴答数比较
+ *
+ * @param handle 实例句柄
+ * @return true 可以发送下一连续帧
+ */
+static bool MicroUDS_StminElapsed(MicroUDS_Handle_t handle)
+{
+    if (handle->Transport.NowNs != NULL)
+        return handle->Transport.NowNs(handle->TransportCtx) - handle->Tx.last_ns >= MicroUDS_StminNs(handle->Tx.stmin);
+
+    return handle->Tick - handle->Tx.last_tick > MicroUDS_StminTick(handle->Tx.stmin); // 严格大于：保证两帧间隔不小于 STmin
+}
+
+/**
+ * @brief 下一连续帧的发送时刻（滴答）
+ *
+ * @param handle 实例句柄
+ * @return MicroUDS_Tick_t
+ */
+static MicroUDS_Tick_t MicroUDS_StminDeadline(MicroUDS_Handle_t handle)
+{
+    if (handle->Transport.NowNs != NULL)
+    {
+        const uint64_t elapsed = handle->Transport.NowNs(handle->TransportCtx) - handle->Tx.last_ns;
+        const uint64_t stmin = MicroUDS_StminNs(handle->Tx.stmin);
+        const uint64_t left = elapsed < stmin ? stmin - elapsed : 0;
+
+        return handle->Tick + (left * MICROUDS_TICK_FREQ_HZ + 999999999u) / 1000000000u;
+    }
+
+    return handle->Tx.last_tick + MicroUDS_StminTick(handle->Tx.stmin) + 1u;
+}
+
+/**
+ * @brief 终止分段发送
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_TxAbort(MicroUDS_Handle_t handle)
+{
+    handle->Tx.state = MICROUDS_TX_IDLE;
+    handle->Tx.len = 0;
+    handle->Tx.offset = 0;
+    MicroUDS_TxRelease(handle);
+}
+
+/**
+ * @brief 取得发送缓冲区，使用发送缓冲池时在这里借用
+ *
+ * @param handle 实例句柄
+ * @return uint8_t* 缓冲池已空时返回NULL
+ */
+static uint8_t *MicroUDS_TxBuffer(MicroUDS_Handle_t handle)
+{
+    if (handle->Tx.buf == NULL && handle->TxPool != NULL)
+        handle->Tx.buf = MicroUDS_PoolAcquire(handle->TxPool);
+
+    return handle->Tx.buf;
+}
+
+/**
+ * @brief 经 MICROUDS_SAFE_CALL_TRANSMIT 发送一帧，调用者需要在失败后清理时使用
+ *
+ * @param handle 实例句柄
+ * @param frame 帧
+ * @param len 帧长度
+ * @return MicroUDS_Sta_t
+ */
+static MicroUDS_Sta_t MicroUDS_TxFrame(MicroUDS_Handle_t handle, uint8_t *frame, size_t len)
+{
+    MICROUDS_SAFE_CALL_TRANSMIT(handle, frame, len);
+
+    return MICROUDS_OK;
+}
+
+/**
+ * @brief 响应发送完毕后归还借用的发送缓冲区
+ *
+ * 分段发送中或请求挂起（最终响应可能已写入缓冲区）时保留
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_TxRelease(MicroUDS_Handle_t handle)
+{
+    if (handle->TxPool == NULL || handle->Tx.buf == NULL)
+        return;
+
+    if (handle->Tx.state != MICROUDS_TX_IDLE || handle->Pending.active)
+        return;
+
+    MicroUDS_PoolRelease(handle->TxPool, handle->Tx.buf);
+    handle->Tx.buf = NULL;
+}
+
+/**
+ * @brief 发送下一个连续帧
+ *
+ * @param handle 实例句柄
+ * @return MicroUDS_Sta_t 发送失败时保持状态，下次重试
+ */
+static MicroUDS_Sta_t MicroUDS_TxSendCF(MicroUDS_Handle_t handle)
+{
+    uint8_t frame[MICROUDS_FRAME_MAX];
+    size_t copy_len, frame_len;
+
+    if (Isotp_PackConsecutiveFrameEx(frame, handle->FrameLen, handle->Tx.buf + handle->Tx.offset,
+                                     handle->Tx.len - handle->Tx.offset, handle->Tx.sn, &copy_len, &frame_len) != ISOTP_OK)
+    {
+        MicroUDS_TxAbort(handle);
+        return MICROUDS_ERR;
+    }
+
+    MICROUDS_SAFE_CALL_TRANSMIT(handle, frame, frame_len);
+
+    handle->Tx.offset += copy_len;
+    handle->Tx.sn = (uint8_t)((handle->Tx.sn + 1) & 0x0F);
+    handle->Tx.last_tick = handle->Tick;
+    if (handle->Tx.stmin != 0 && handle->Transport.NowNs != NULL)
+        handle->Tx.last_ns = handle->Transport.NowNs(handle->TransportCtx); // 按纳秒计 STmin
+
+    if (handle->Tx.offset >= handle->Tx.len) // 发送完成
+    {
+        MicroUDS_TxAbort(handle);
+        return MICROUDS_OK;
+    }
+
+    if (handle->Tx.bs != 0 && ++handle->Tx.bs_count >= handle->Tx.bs) // 块结束，等待下一个FC
+    {
+        handle->Tx.bs_count = 0;
+        handle->Tx.state = MICROUDS_TX_WAIT_FC;
+    }
+
+    return MICROUDS_OK;
+}
+
+/**
+ * @brief 一次交出当前块内剩余的连续帧（STmin = 0 且配置了批量发送）
+ *
+ * @param handle 实例句柄
+ * @return MicroUDS_Sta_t 回调只接受了一部分时返回 MICROUDS_ERR_TRANS，下次继续
+ */
+static MicroUDS_Sta_t MicroUDS_TxSendBurst(MicroUDS_Handle_t handle)
+{
+    MicroUDS_Tx_t *tx = &handle->Tx;
+    MicroUDS_Frame_t burst[MICROUDS_TX_BURST_MAX];
+    size_t count = MICROUDS_TX_BURST_MAX;
+
+    if (tx->bs != 0 && (size_t)(tx->bs - tx->bs_count) < count)
+        count = (size_t)(tx->bs - tx->bs_count); // 不超过当前块
+
+    Isotp_FrameArray_t frames = {
+        .Frames = burst[0].data,
+        .Length = &burst[0].len,
+        .Stride = sizeof(MicroUDS_Frame_t),
+        .Count = count,
+    };
+    size_t consumed;
+
+    if (Isotp_SegmentConsecutive(&frames, handle->FrameLen, tx->buf + tx->offset, tx->len - tx->offset, tx->sn,
+                                 &consumed, &count) != ISOTP_OK)
+    {
+        MicroUDS_TxAbort(handle);
+        return MICROUDS_ERR;
+    }
+
+    int sent = handle->Transport.TxBurst(handle->TransportCtx, burst, count);
+    if (sent <= 0)
+    {
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ERROR);
+        return MICROUDS_ERR_TRANS;
+    }
+
+#if MICROUDS_TRACE_ENABLE
+    if (handle->Trace != NULL)
+    {
+        for (int i = 0; i < sent; i++)
+            MicroUDS_TraceRecord(handle, MICROUDS_TRACE_TX, burst[i].data, burst[i].len);
+    }
+#endif
+
+    if ((size_t)sent < count) // 除最后一帧外每帧都装满
+        consumed = (size_t)sent * (handle->FrameLen - 1);
+
+    tx->offset += consumed;
+    tx->sn = (uint8_t)((tx->sn + sent) & 0x0F);
+    tx->last_tick = handle->Tick;
+
+    if (tx->offset >= tx->len) // 发送完成
+    {
+        MicroUDS_TxAbort(handle);
+        return MICROUDS_OK;
+    }
+
+    if (tx->bs != 0)
+    {
+        tx->bs_count = (uint8_t)(tx->bs_count + sent);
+        if (tx->bs_count >= tx->bs) // 块结束，等待下一个FC
+        {
+            tx->bs_count = 0;
+            tx->state = MICROUDS_TX_WAIT_FC;
+            return MICROUDS_OK;
+        }
+    }
+
+    return (size_t)sent < count ? MICROUDS_ERR_TRANS : MICROUDS_OK;
+}
+
+/**
+ * @brief 分段发送状态机，在 MicroUDS_TimerHandler 中调用
+ *
+ * STmin 为 0 时一次发完当前块（配置了批量发送时整块交给 TxBurst），
+ * 否则每个 STmin 间隔发送一帧
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_TxProcess(MicroUDS_Handle_t handle)
+{
+    switch (handle->Tx.state)
+    {
+    case MICROUDS_TX_WAIT_FC:
+        if (handle->Tick - handle->Tx.last_tick >= MICROUDS_MS_TICK(MICROUDS_TIMEOUT_N_BS_MS))
+        {
+            MicroUDS_TxAbort(handle); // N_Bs 超时
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ABORT);
+        }
+        break;
+
+    case MICROUDS_TX_SENDING:
+        if (handle->Tx.stmin == 0)
+        {
+            while (handle->Tx.state == MICROUDS_TX_SENDING)
+            {
+                MicroUDS_Sta_t ret = handle->Transport.TxBurst ? MicroUDS_TxSendBurst(handle) : MicroUDS_TxSendCF(handle);
+                if (ret != MICROUDS_OK)
+                    break;
+            }
+        }
+        else if (MicroUDS_StminElapsed(handle))
+        {
+            MicroUDS_TxSendCF(handle);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief 处理测试仪发来的流控帧
+ *
+ * @param handle 实例句柄
+ * @param data 原始帧
+ * @param len 帧长度
  */
-static inline void MicroUDS_Response(MicroUDS_NRC_t code);
+static void MicroUDS_TxFlowControl(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
+{
+    Isotp_FlowControlFrame_t fc;
+
+    if (handle->Tx.state != MICROUDS_TX_WAIT_FC)
+        return; // 不在等待流控，忽略
+
+    if (Isotp_UnpackFlowControlFrameEx(&fc, data, len) != ISOTP_OK)
+        return;
+
+    switch ((Isotp_FlowStatus_t)fc.byte.FS)
+    {
+    case ISOTP_FS_CTS:
+        handle->Tx.bs = fc.byte.BS;
+        handle->Tx.stmin = fc.byte.STmin;
+        handle->Tx.bs_count = 0;
+        handle->Tx.wft = 0;
+        handle->Tx.state = MICROUDS_TX_SENDING;
+        handle->Tx.last_tick = handle->Tick - MicroUDS_StminTick(fc.byte.STmin) - 1; // 首个CF立即发送
+        if (handle->Transport.NowNs != NULL)
+            handle->Tx.last_ns = handle->Transport.NowNs(handle->TransportCtx) - MicroUDS_StminNs(fc.byte.STmin);
+        MicroUDS_Notify(handle, MICROUDS_EVENT_TX);
+        break;
+
+    case ISOTP_FS_WAIT:
+        if (++handle->Tx.wft > MICROUDS_TX_WFT_MAX)
+        {
+            MicroUDS_TxAbort(handle);
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ABORT);
+        }
+        else
+        {
+            handle->Tx.last_tick = handle->Tick; // 重新开始 N_Bs
+        }
+        break;
+
+    case ISOTP_FS_OVFLW:
+    default:
+        MicroUDS_TxAbort(handle);
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_TX_ABORT);
+        break;
+    }
+}
 
-MicroUDS_Sta_t MicroUDS_PositiveResponse(void)
+MicroUDS_Sta_t MicroUDS_SendMessage(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
 {
-    uint8_t data[8] = {0};
-    uint8_t res[8] = {0};
-    size_t len = 0;
+    MICROUDS_CHECKPTR(handle);
+    MICROUDS_CHECKPTR(data);
 
-    /* SID + 0x40 表示正响应 */
-    data[0] = (uint8_t)(MicroUDS_Handle->sid + MICROUDS_RESPONSE_OFFSET);
-    len = 1;
+    if (len == 0)
+        return MICROUDS_ERR_PARAM;
 
-    if (MicroUDS_Handle->ssid != 0)
-        data[len++] = (uint8_t)MicroUDS_Handle->ssid;
+    MicroUDS_UpdateClock(handle); // N_Bs 从现在开始计时
 
-    if (Isotp_PackSingleFrame(res, data, (uint8_t)len) != ISOTP_OK)
-        return MICROUDS_ERR;
+    MicroUDS_StatsTx(handle, data, len);
+    if (len < 3 || data[0] != 0x7F || data[2] != UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING)
+        MicroUDS_StatsAnswer(handle);
 
-    /* 始终发送完整 8 字节 CAN 帧 */
-    MICROUDS_SAFE_CALL_TRANSMIT(res, 8);
+    if (handle->Reply.Func != NULL || handle->Transport.TxMessage != NULL) // 整报文交出，不分帧
+    {
+        MicroUDS_Sta_t ret;
+        if (len > handle->Tx.size)
+            return MICROUDS_ERR_PARAM;
+        MicroUDS_SendWhole(handle, data, len, &ret);
+        return ret;
+    }
 
-    return MICROUDS_OK;
-}
+    if (len <= Isotp_SingleFrameMax(handle->FrameLen)) // 单帧
+        return MicroUDS_SendSingleFrame(handle, data, len);
 
-MicroUDS_Sta_t MicroUDS_NegativeResponse(MicroUDS_NRC_t code)
-{
-    uint8_t data[8] = {0};
-    uint8_t res[8] = {0};
+    if (handle->Tx.state != MICROUDS_TX_IDLE)
+        return MICROUDS_ERR; // 上一个多帧仍在发送
 
-    data[0] = 0x7F;
-    data[1] = (uint8_t)MicroUDS_Handle->sid;
-    data[2] = (uint8_t)code;
+    if (len > handle->Tx.size)
+        return MICROUDS_ERR_PARAM;
 
-    if (Isotp_PackSingleFrame(res, data, 3) != ISOTP_OK)
-        return MICROUDS_ERR;
+    if (MicroUDS_TxBuffer(handle) == NULL)
+        return MICROUDS_ERR_BUSY; // 发送缓冲池已空
 
-    /* 始终发送完整 8 字节 CAN 帧 */
-    MICROUDS_SAFE_CALL_TRANSMIT(res, 8);
+    if (data != handle->Tx.buf)
+        memcpy(handle->Tx.buf, data, len);
+
+    uint8_t frame[MICROUDS_FRAME_MAX];
+    size_t consumed;
+    MicroUDS_Sta_t ret = MICROUDS_ERR;
+    if (Isotp_PackFirstFrameEx(frame, handle->FrameLen, handle->Tx.buf, len, &consumed) == ISOTP_OK)
+        ret = MicroUDS_TxFrame(handle, frame, handle->FrameLen); // 首帧总是完整帧长
+
+    if (ret != MICROUDS_OK)
+    {
+        MicroUDS_TxRelease(handle);
+        return ret;
+    }
+
+    handle->Tx.len = len;
+    handle->Tx.offset = consumed;
+    handle->Tx.sn = 1;
+    handle->Tx.bs_count = 0;
+    handle->Tx.wft = 0;
+    handle->Tx.last_tick = handle->Tick;
+    handle->Tx.state = MICROUDS_TX_WAIT_FC;
+    MicroUDS_Kick(handle); // N_Bs
 
     return MICROUDS_OK;
 }
 
-MicroUDS_Sta_t MicroUDS_Init(void)
+MicroUDS_Sta_t MicroUDS_Init(MicroUDS_Handle_t handle, const MicroUDS_Conf_t *conf)
 {
+    MICROUDS_CHECKPTR(handle);
 
-    if (MICROUDS_HASH_SIZE == 0)
+    if (MICROUDS_SERVICE_RECORDS == 0 || MICROUDS_SERVICE_RECORDS > 255)
         return MICROUDS_ERR_PARAM;
 
-    memset(&MicroUDS, 0, sizeof(MicroUDS));
+    memset(handle, 0, sizeof(MicroUDS_Obj));
+
+    /* 注册回调 */
+    if (conf != NULL)
+    {
+        if (conf->Transport != NULL)
+            handle->Transport = *conf->Transport;
+        handle->TransportCtx = conf->TransportCtx;
+        handle->UserData = conf->UserData;
+        handle->ReqBudget = conf->ReqBudget;
+        handle->RxPool = conf->RxPool;
+        handle->RxBufSize = conf->RxBufSize;
+        handle->TxPool = conf->TxPool;
+        handle->Wheel = conf->Wheel;
+        handle->Notify = conf->Notify;
+        handle->NotifyCtx = conf->NotifyCtx;
+#if MICROUDS_STATS_ENABLE
+        handle->Stats = conf->Stats;
+#endif
+#if MICROUDS_TRACE_ENABLE
+        handle->Trace = conf->Trace;
+#endif
+
+        if (handle->RxPool != NULL && (handle->RxPool->blocks == NULL || handle->RxBufSize > handle->RxPool->block_size))
+            return MICROUDS_ERR_PARAM; // 未初始化的缓冲池，或块放不下 RxBufSize
+        if (handle->TxPool != NULL && handle->TxPool->blocks == NULL)
+            return MICROUDS_ERR_PARAM;
+
+        /* 用户提供内存区：后续所有内部内存都从这里分配，不使用堆 */
+        if (conf->Arena != NULL)
+        {
+#if !MICROUDS_DISPATCH_TABLE
+            return MICROUDS_ERR_PARAM; // 哈希表需要堆内存
+#else
+            uintptr_t base = (uintptr_t)conf->Arena;
+            size_t pad = (size_t)(MICROUDS_ALIGN(base) - base);
+            if (conf->ArenaSize <= pad)
+                return MICROUDS_ERR_PARAM;
+
+            handle->Arena.base = (uint8_t *)conf->Arena + pad;
+            handle->Arena.size = conf->ArenaSize - pad;
+            handle->Arena.used = 0;
+#endif
+        }
+    }
+    if (handle->ReqBudget == 0)
+        handle->ReqBudget = MICROUDS_REQ_BUDGET;
+    if (handle->RxBufSize == 0)
+        handle->RxBufSize = handle->RxPool != NULL ? handle->RxPool->block_size : MICROUDS_RX_BUF_SIZE;
+
+    handle->FrameLen = handle->Transport.MaxFrameSize;
+    if (handle->FrameLen == 0)
+        handle->FrameLen = ISOTP_CAN_DL;
+
+    if (handle->FrameLen > MICROUDS_FRAME_MAX || Isotp_FrameLength(handle->FrameLen) != handle->FrameLen)
+        return MICROUDS_ERR_PARAM; // 只支持 8 及 CAN FD 的 12/16/20/24/32/48/64
+
+    /* Arena 模式一次分配全部服务槽；堆模式在注册时按需增长 */
+    handle->ServiceCount = 0;
+    if (handle->Arena.base != NULL)
+    {
+        handle->Services = (Microuds_Service_t *)MicroUDS_Alloc(handle, MICROUDS_SERVICE_RECORDS * sizeof(Microuds_Service_t));
+        if (handle->Services == NULL)
+            return MICROUDS_ERR_MEMORY;
+        handle->ServiceSize = MICROUDS_SERVICE_RECORDS;
+    }
+
+    /* 没有发送缓冲池时分配实例独占的发送缓冲区，否则在响应期间借用 */
+    if (handle->TxPool != NULL)
+    {
+        handle->Tx.size = handle->TxPool->block_size;
+    }
+    else
+    {
+        handle->Tx.buf = (uint8_t *)MicroUDS_Alloc(handle, MICROUDS_TX_BUF_SIZE);
+        if (handle->Tx.buf == NULL)
+        {
+            MicroUDS_Free(handle, handle->Services);
+            handle->Services = NULL;
+            return MICROUDS_ERR_MEMORY;
+        }
+        handle->Tx.size = MICROUDS_TX_BUF_SIZE;
+    }
+
+    /* 没有共享缓冲池时分配实例独占的多帧接收缓冲区 */
+    if (handle->RxPool == NULL)
+    {
+        handle->RxBuf = (uint8_t *)MicroUDS_Alloc(handle, handle->RxBufSize);
+        if (handle->RxBuf == NULL)
+        {
+            MicroUDS_Free(handle, handle->Tx.buf);
+            MicroUDS_Free(handle, handle->Services);
+            handle->Services = NULL;
+            return MICROUDS_ERR_MEMORY;
+        }
+    }
+
+#if !MICROUDS_DISPATCH_TABLE
+    if (MICROUDS_HASH_SIZE == 0)
+    {
+        MicroUDS_Free(handle, handle->RxBuf);
+        MicroUDS_Free(handle, handle->Tx.buf);
+        MicroUDS_Free(handle, handle->Services);
+        handle->Services = NULL;
+        return MICROUDS_ERR_PARAM;
+    }
 
     MicroHash_Conf_t hashConf = {
         .buckSize = MICROUDS_HASH_SIZE,
     };
 
-    /* 注册回调 */
-    MicroUDS_Handle->Transmit = MICROUDS_TRANSMIT_CB;
-
-    /* 分配记录表与初始化计数 */
-    MicroUDS_Handle->Record.data = (uint8_t *)calloc(MICROUDS_SERVICE_RECORDS, sizeof(uint8_t));
-    if (MicroUDS_Handle->Record.data == NULL)
-        return MICROUDS_ERR_MEMORY;
-    MicroUDS_Handle->Record.count = 0;
-    MicroUDS_Handle->Record.size = MICROUDS_SERVICE_RECORDS;
-
     /* 初始化哈希表 */
-    MicroHash_Sta_t HashRet = MicroHash_Init(&MicroUDS_Handle->hashTable, &hashConf);
+    MicroHash_Sta_t HashRet = MicroHash_Init(&handle->hashTable, &hashConf);
     if (HashRet != MICROHASH_OK)
     {
-        free(MicroUDS_Handle->Record.data);
-        MicroUDS_Handle->Record.data = NULL;
-        MicroUDS_Handle->Record.size = 0;
-        MicroUDS_Handle->Record.count = 0;
+        MicroUDS_Free(handle, handle->RxBuf);
+        MicroUDS_Free(handle, handle->Tx.buf);
+        MicroUDS_Free(handle, handle->Services);
+        handle->Services = NULL;
+        handle->ServiceSize = 0;
         switch (HashRet)
         {
         case MICROHASH_ERR:
@@ -107,322 +1670,1167 @@ MicroUDS_Sta_t MicroUDS_Init(void)
         default:
             return MICROUDS_ERR;
         }
-    }
+    }
+#endif
+
+#if MICROUDS_RX_QUEUE_DEPTH
+    atomic_init(&handle->RxQueue.head, 0);
+    atomic_init(&handle->RxQueue.tail, 0);
+    atomic_init(&handle->RxQueue.dropped, 0);
+#endif
+
+    /* 初始化会话为默认会话 */
+    handle->sid = UDS_DIAGNOSTIC_SESSION_CONTROL;
+    handle->ssid = UDS_SESSION_DEFAULT;
+    MicroUDS_UpdateClock(handle);
+    handle->last_time = handle->Tick;
+    atomic_init(&handle->Woken, false);
+    atomic_init(&handle->Notified, false);
+    handle->Timeout = MICROUDS_MS_TICK(MICROUDS_SERVICE_TIMEOUT_MS);
+    handle->N_Cs.Timeout = MICROUDS_MS_TICK(MICROUDS_TIMEOUT_N_CS_MS);
+
+    return MICROUDS_OK;
+}
+
+MicroUDS_Sta_t MicroUDS_Create(MicroUDS_Handle_t *handle, const MicroUDS_Conf_t *conf)
+{
+    MICROUDS_CHECKPTR(handle);
+    if (*handle != NULL)
+        return MICROUDS_ERR_PARAM;
+
+    *handle = (MicroUDS_Obj *)calloc(1, sizeof(MicroUDS_Obj)); // 分配实例空间
+    if (*handle == NULL)
+        return MICROUDS_ERR_MEMORY;
+
+    MicroUDS_Sta_t ret = MicroUDS_Init(*handle, conf);
+    if (ret != MICROUDS_OK)
+    {
+        free(*handle);
+        *handle = NULL;
+    }
+
+    return ret;
+}
+
+MicroUDS_Sta_t MicroUDS_Destroy(MicroUDS_Handle_t *handle)
+{
+    if (handle == NULL || *handle == NULL)
+        return MICROUDS_ERR_PARAM;
+
+    MicroUDS_Delete(*handle);
+    free(*handle);
+    *handle = NULL;
+
+    return MICROUDS_OK;
+}
+
+void MicroUDS_Delete(MicroUDS_Handle_t handle)
+{
+    if (handle == NULL)
+        return;
+
+    if (handle->Services)
+    {
+        for (size_t i = 0; i < handle->ServiceCount; i++)
+        {
+            MicroUDS_Free(handle, handle->Services[i].Session);
+            handle->Services[i].Session = NULL;
+        }
+
+        MicroUDS_Free(handle, handle->Services);
+        handle->Services = NULL;
+        handle->ServiceCount = 0;
+        handle->ServiceSize = 0;
+    }
+
+    if (handle->TxPool != NULL)
+    {
+        if (handle->Tx.buf != NULL)
+            MicroUDS_PoolRelease(handle->TxPool, handle->Tx.buf); // 归还借用的发送缓冲区
+    }
+    else
+    {
+        MicroUDS_Free(handle, handle->Tx.buf);
+    }
+    handle->Tx.buf = NULL;
+    MicroUDS_ClearRecv(handle); // 归还借用的接收缓冲区
+    MicroUDS_Free(handle, handle->RxBuf);
+
+    if (handle->Wheel != NULL)
+        MicroUDS_WheelUnlink(handle->Wheel, &handle->Timer);
+
+#if !MICROUDS_DISPATCH_TABLE
+    MicroHash_Delete(&handle->hashTable);
+#endif
+
+    memset(handle, 0, sizeof(MicroUDS_Obj));
+}
+
+MicroUDS_Sta_t MicroUDS_PoolInit(MicroUDS_Pool_t *pool, void *mem, size_t mem_size, size_t block_size)
+{
+    MICROUDS_CHECKPTR(pool);
+    MICROUDS_CHECKPTR(mem);
+
+    if (block_size == 0)
+        return MICROUDS_ERR_PARAM;
+
+    uintptr_t base = (uintptr_t)mem;
+    size_t pad = (size_t)(MICROUDS_ALIGN(base) - base);
+    if (mem_size <= pad)
+        return MICROUDS_ERR_PARAM;
+    mem_size -= pad;
+
+    /* 位图放在内存区开头，其余按对齐后的块大小切分 */
+    size_t stride = MICROUDS_ALIGN(block_size);
+    size_t count = mem_size / stride;
+    while (count != 0 && MICROUDS_ALIGN((count + 31u) / 32u * sizeof(atomic_uint_least32_t)) + count * stride > mem_size)
+        count--;
+    if (count == 0)
+        return MICROUDS_ERR_MEMORY;
+
+    memset(pool, 0, sizeof(MicroUDS_Pool_t));
+    pool->map = (atomic_uint_least32_t *)((uint8_t *)mem + pad);
+    pool->words = (count + 31u) / 32u;
+    pool->blocks = (uint8_t *)pool->map + MICROUDS_ALIGN(pool->words * sizeof(atomic_uint_least32_t));
+    pool->count = count;
+    pool->block_size = stride;
+
+    for (size_t w = 0; w < pool->words; w++)
+    {
+        size_t used = count - w * 32u; // 本字中有效的块数
+        atomic_init(&pool->map[w], used >= 32u ? 0u : (uint_least32_t)(0xFFFFFFFFu << used));
+    }
+    atomic_init(&pool->exhausted, 0);
+
+    return MICROUDS_OK;
+}
+
+size_t MicroUDS_PoolAvailable(MicroUDS_Pool_t *pool)
+{
+    size_t n = 0;
+
+    if (pool == NULL)
+        return 0;
+
+    for (size_t w = 0; w < pool->words; w++)
+        n += 32u - MicroUDS_PopCount((uint32_t)atomic_load_explicit(&pool->map[w], memory_order_relaxed));
+
+    return n;
+}
+
+/**
+ * @brief 拷贝一组计数器，可同时清零
+ *
+ * @param src 计数器
+ * @param dst 快照，NULL = 只清零
+ * @param count 计数器个数
+ * @param reset 读取的同时清零（交换，不丢失并发的计数）
+ */
+static void MicroUDS_StatsCopy(atomic_uint_least32_t *src, uint32_t *dst, size_t count, bool reset)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t v = reset ? (uint32_t)atomic_exchange_explicit(&src[i], 0, memory_order_relaxed)
+                           : (uint32_t)atomic_load_explicit(&src[i], memory_order_relaxed);
+        if (dst != NULL)
+            dst[i] = v;
+    }
+}
+
+MicroUDS_Sta_t MicroUDS_StatsInit(MicroUDS_Stats_t *stats)
+{
+    MICROUDS_CHECKPTR(stats);
+
+    for (size_t i = 0; i < MICROUDS_STAT_COUNT; i++)
+        atomic_init(&stats->Counter[i], 0);
+    for (size_t i = 0; i < 256u; i++)
+    {
+        atomic_init(&stats->Requests[i], 0);
+        atomic_init(&stats->Nrc[i], 0);
+    }
+    for (size_t i = 0; i < MICROUDS_STATS_BUCKETS; i++)
+    {
+        atomic_init(&stats->Latency[i], 0);
+        atomic_init(&stats->PendingLatency[i], 0);
+    }
+
+    return MICROUDS_OK;
+}
+
+MicroUDS_Sta_t MicroUDS_StatsSnapshot(MicroUDS_Stats_t *stats, MicroUDS_StatsSnapshot_t *snap, bool reset)
+{
+    MICROUDS_CHECKPTR(stats);
+
+    if (snap == NULL && !reset)
+        return MICROUDS_ERR_PARAM;
+
+    MicroUDS_StatsCopy(stats->Counter, snap != NULL ? snap->Counter : NULL, MICROUDS_STAT_COUNT, reset);
+    MicroUDS_StatsCopy(stats->Requests, snap != NULL ? snap->Requests : NULL, 256u, reset);
+    MicroUDS_StatsCopy(stats->Nrc, snap != NULL ? snap->Nrc : NULL, 256u, reset);
+    MicroUDS_StatsCopy(stats->Latency, snap != NULL ? snap->Latency : NULL, MICROUDS_STATS_BUCKETS, reset);
+    MicroUDS_StatsCopy(stats->PendingLatency, snap != NULL ? snap->PendingLatency : NULL, MICROUDS_STATS_BUCKETS, reset);
+
+    return MICROUDS_OK;
+}
+
+uint32_t MicroUDS_StatsBucketUs(size_t bucket)
+{
+    if (bucket >= MICROUDS_STATS_BUCKETS)
+        return UINT32_MAX;
+
+    if (bucket < MICROUDS_STATS_SUB)
+        return (uint32_t)bucket;
+
+    uint32_t shift = (uint32_t)(bucket / MICROUDS_STATS_SUB) - 1u; // 子桶宽度 2^shift
+    return (uint32_t)(MICROUDS_STATS_SUB + bucket % MICROUDS_STATS_SUB) << shift;
+}
+
+MicroUDS_Sta_t MicroUDS_TraceInit(MicroUDS_Trace_t *trace, MicroUDS_TraceRec_t *rec, size_t count)
+{
+    MICROUDS_CHECKPTR(trace);
+    MICROUDS_CHECKPTR(rec);
+
+    if (count == 0 || count > 0x80000000u || (count & (count - 1u)) != 0)
+        return MICROUDS_ERR_PARAM; // 2的幂，序号回绕时槽位连续
+
+    for (size_t i = 0; i < count; i++)
+        atomic_init(&rec[i].seq, 0);
+
+    trace->rec = rec;
+    trace->mask = (uint32_t)(count - 1u);
+    trace->Clock = NULL;
+    trace->ClockCtx = NULL;
+    atomic_init(&trace->head, 0);
+
+    return MICROUDS_OK;
+}
+
+#define MICROUDS_PCAP_HDR_LEN   24u                                 // pcap 文件头
+#define MICROUDS_PCAP_REC_LEN   (16u + 8u + ISOTP_CANFD_DL)         // 记录头 + SocketCAN 头 + 最长数据
+#define MICROUDS_CANDUMP_LINE   (24u + 8u + 3u + 2u * ISOTP_CANFD_DL) // candump 一行（不含接口名）
+
+static const char MicroUDS_Hex[] = "0123456789ABCDEF";
+
+/**
+ * @brief 写入定宽十进制数（不足补0）
+ */
+static char *MicroUDS_PutDec(char *p, uint64_t v, size_t width)
+{
+    for (size_t i = width; i > 0; i--)
+    {
+        p[i - 1] = (char)('0' + v % 10u);
+        v /= 10u;
+    }
+    return p + width;
+}
+
+/**
+ * @brief 写入十六进制字节串
+ */
+static char *MicroUDS_PutHex(char *p, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        *p++ = MicroUDS_Hex[data[i] >> 4];
+        *p++ = MicroUDS_Hex[data[i] & 0x0F];
+    }
+    return p;
+}
+
+/**
+ * @brief 32位小端写入（pcap 文件头和记录头）
+ */
+static inline void MicroUDS_PutLe32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 一条记录转换为 candump -l 格式的一行
+ *
+ * 帧：(秒.微秒) 接口 ID#数据，CAN FD 为 ID##标志数据；事件：# (秒.微秒) 接口 类型 参数
+ *
+ * @return size_t 行长度
+ */
+static size_t MicroUDS_TraceCandump(const MicroUDS_TraceRec_t *rec, const char *ifname, char *out)
+{
+    static const char *const event[] = {"RX", "TX", "FF", "SN_ERROR", "N_CS_ABORT", "SESSION_RESET"};
+    char *p = out;
+
+    if (rec->kind > MICROUDS_TRACE_TX)
+    {
+        *p++ = '#';
+        *p++ = ' ';
+    }
+
+    *p++ = '(';
+    p = MicroUDS_PutDec(p, rec->ts / 1000000000u, 10);
+    *p++ = '.';
+    p = MicroUDS_PutDec(p, rec->ts % 1000000000u / 1000u, 6);
+    *p++ = ')';
+    *p++ = ' ';
+
+    for (const char *s = ifname; *s != '\0'; s++)
+        *p++ = *s;
+    *p++ = ' ';
+
+    if (rec->kind > MICROUDS_TRACE_TX)
+    {
+        size_t kind = rec->kind < MICROUDS_COUNTOF(event) ? rec->kind : 0;
+        for (const char *s = event[kind]; *s != '\0'; s++)
+            *p++ = *s;
+        *p++ = ' ';
+    }
+    else
+    {
+        uint32_t id = rec->id & 0x1FFFFFFFu; // 去掉 CAN_EFF_FLAG 等标志位
+        for (int shift = rec->id > 0x7FFu ? 28 : 8; shift >= 0; shift -= 4)
+            *p++ = MicroUDS_Hex[(id >> shift) & 0x0Fu];
+        *p++ = '#';
+        if (rec->flags & MICROUDS_TRACE_FD)
+        {
+            *p++ = '#';
+            *p++ = '0'; // 标志：无 BRS / ESI
+        }
+    }
+
+    p = MicroUDS_PutHex(p, rec->data, rec->len);
+    *p++ = '\n';
+
+    return (size_t)(p - out);
+}
+
+/**
+ * @brief 一条帧记录转换为 pcap 记录（LINKTYPE_CAN_SOCKETCAN）
+ *
+ * @return size_t 记录长度，事件不导出时为0
+ */
+static size_t MicroUDS_TracePcap(const MicroUDS_TraceRec_t *rec, uint8_t *out)
+{
+    if (rec->kind > MICROUDS_TRACE_TX)
+        return 0;
+
+    bool fd = (rec->flags & MICROUDS_TRACE_FD) != 0;
+    size_t dlen = fd ? ISOTP_CANFD_DL : ISOTP_CAN_DL; // 数据区按 can_frame / canfd_frame 补齐
+    uint32_t id = rec->id > 0x7FFu ? ((rec->id & 0x1FFFFFFFu) | 0x80000000u) : rec->id; // CAN_EFF_FLAG
+
+    MicroUDS_PutLe32(out, (uint32_t)(rec->ts / 1000000000u));
+    MicroUDS_PutLe32(out + 4, (uint32_t)(rec->ts % 1000000000u));
+    MicroUDS_PutLe32(out + 8, (uint32_t)(8u + dlen));
+    MicroUDS_PutLe32(out + 12, (uint32_t)(8u + dlen));
+
+    uint8_t *frame = out + 16;
+    MicroUDS_PutBe32(frame, id);     // CAN ID 为大端
+    frame[4] = rec->len;             // 数据长度
+    frame[5] = fd ? 0x04u : 0x00u;   // CANFD_FDF
+    frame[6] = 0;
+    frame[7] = 0;
+    memset(frame + 8, 0, dlen);
+    memcpy(frame + 8, rec->data, rec->len);
+
+    return 16u + 8u + dlen;
+}
+
+size_t MicroUDS_TraceExport(MicroUDS_Trace_t *trace, MicroUDS_TraceFormat_t fmt, const char *ifname, uint8_t *buf, size_t cap)
+{
+    if (trace == NULL || trace->rec == NULL)
+        return 0;
+
+    if (ifname == NULL)
+        ifname = "can0";
+
+    size_t count = (size_t)trace->mask + 1u;
+    size_t name_len = strlen(ifname);
+    size_t rec_max = fmt == MICROUDS_TRACE_PCAP ? MICROUDS_PCAP_REC_LEN : MICROUDS_CANDUMP_LINE + name_len;
+    size_t hdr_len = fmt == MICROUDS_TRACE_PCAP ? MICROUDS_PCAP_HDR_LEN : 0u;
+
+    if (buf == NULL)
+        return hdr_len + count * rec_max; // 上限
+
+    if (cap < hdr_len)
+        return 0;
+
+    size_t len = 0;
+    if (fmt == MICROUDS_TRACE_PCAP)
+    {
+        MicroUDS_PutLe32(buf, 0xA1B23C4Du); // 纳秒时间戳
+        buf[4] = 2;                         // 版本 2.4
+        buf[5] = 0;
+        buf[6] = 4;
+        buf[7] = 0;
+        memset(buf + 8, 0, 8);              // thiszone, sigfigs
+        MicroUDS_PutLe32(buf + 16, 8u + ISOTP_CANFD_DL); // snaplen
+        MicroUDS_PutLe32(buf + 20, 227u);   // LINKTYPE_CAN_SOCKETCAN
+        len = MICROUDS_PCAP_HDR_LEN;
+    }
+
+    uint32_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    uint32_t n = head < count ? head : (uint32_t)count;
+
+    for (uint32_t seq = head - n; seq != head; seq++)
+    {
+        MicroUDS_TraceRec_t *slot = &trace->rec[seq & trace->mask];
+        MicroUDS_TraceRec_t rec;
+
+        /* 序号前后一致才是完整的记录，否则正在写入或已被覆盖 */
+        uint32_t before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (before != seq + 1u)
+            continue;
+        rec.kind = slot->kind;
+        rec.len = slot->len;
+        rec.flags = slot->flags;
+        rec.id = slot->id;
+        rec.ts = slot->ts;
+        memcpy(rec.data, slot->data, sizeof(rec.data));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != before || rec.len > sizeof(rec.data))
+            continue;
+
+        if (cap - len < rec_max)
+            break; // 缓冲区不足，保留已导出的部分
+
+        len += fmt == MICROUDS_TRACE_PCAP ? MicroUDS_TracePcap(&rec, buf + len)
+                                          : MicroUDS_TraceCandump(&rec, ifname, (char *)buf + len);
+    }
+
+    return len;
+}
+
+/**
+ * @brief 滴答数转换为毫秒（向上取整，不超过 MICROUDS_DEADLINE_NONE - 1）
+ */
+static inline uint32_t MicroUDS_TickMs(MicroUDS_Tick_t ticks)
+{
+    const uint64_t hz = MICROUDS_TICK_FREQ_HZ;
+    MicroUDS_Tick_t ms = ticks / hz * 1000u + ((ticks % hz) * 1000u + hz - 1u) / hz;
+
+    return ms < MICROUDS_DEADLINE_NONE ? (uint32_t)ms : MICROUDS_DEADLINE_NONE - 1u;
+}
+
+uint32_t MicroUDS_NextDeadline(MicroUDS_Handle_t handle)
+{
+    MicroUDS_Tick_t deadline;
+
+    if (handle == NULL)
+        return MICROUDS_DEADLINE_NONE;
+
+    MicroUDS_UpdateClock(handle); // 主循环可能已休眠很久，距离按当前时刻计算
+    if (!MicroUDS_Deadline(handle, &deadline))
+        return MICROUDS_DEADLINE_NONE;
+
+    return MicroUDS_TickMs(deadline - handle->Tick);
+}
+
+MicroUDS_Sta_t MicroUDS_WheelInit(MicroUDS_Wheel_t *wheel, uint64_t now_ms)
+{
+    MICROUDS_CHECKPTR(wheel);
+
+    memset(wheel, 0, sizeof(MicroUDS_Wheel_t));
+    atomic_init(&wheel->ready, NULL);
+    wheel->now = (uint32_t)MICROUDS_MS_TICK(now_ms);
+
+    return MICROUDS_OK;
+}
+
+size_t MicroUDS_WheelRun(MicroUDS_Wheel_t *wheel, uint64_t now_ms)
+{
+    if (wheel == NULL)
+        return 0;
+
+    uint32_t target = (uint32_t)MICROUDS_MS_TICK(now_ms);
+
+    /* 中断或其他线程唤醒的实例移入到期链表 */
+    MicroUDS_Obj *woken = atomic_exchange_explicit(&wheel->ready, NULL, memory_order_acquire);
+    while (woken != NULL)
+    {
+        MicroUDS_Obj *next = woken->WakeNext;
+        atomic_store_explicit(&woken->Woken, false, memory_order_release); // 之后到达的帧会再次唤醒
+        MicroUDS_Kick(woken);
+        woken = next;
+    }
+
+    size_t n = MicroUDS_WheelExpire(wheel, &wheel->due, 0, 0); // 上次调用之后被唤醒的实例
+
+    while ((int32_t)(target - wheel->now) > 0)
+    {
+        uint32_t t = wheel->now + 1u;
+
+        if ((t & MICROUDS_WHEEL_MASK) == 0)
+            MicroUDS_WheelCascade(wheel, t);
+
+        /* 跳过空槽：本圈剩余槽位都为空时直接跳到下一圈之前 */
+        uint64_t rest = wheel->occupied[0] >> (t & MICROUDS_WHEEL_MASK);
+        if (rest == 0)
+        {
+            uint32_t last = t | MICROUDS_WHEEL_MASK;
+            wheel->now = (int32_t)(last - target) > 0 ? target : last;
+            continue;
+        }
+
+        t += MicroUDS_Ctz64(rest);
+        if ((int32_t)(t - target) > 0)
+        {
+            wheel->now = target;
+            break;
+        }
 
-    /* 初始化会话为默认会话 */
-    MicroUDS_Handle->sid = UDS_DIAGNOSTIC_SESSION_CONTROL;
-    MicroUDS_Handle->ssid = UDS_SESSION_DEFAULT;
-    MicroUDS_Handle->last_time = 0;
-    MicroUDS_Handle->Tick = 0;
-    MicroUDS_Handle->Timeout = MICROUDS_MS_TICK(MICROUDS_SERVICE_TIMEOUT_MS);
-    MicroUDS_Handle->N_Cs.Timeout = MICROUDS_MS_TICK(MICROUDS_TIMEOUT_N_CS_MS);
+        uint32_t index = t & MICROUDS_WHEEL_MASK;
+        wheel->now = t; // 处理中重新到期的实例进入到期链表，下一次调用处理
+        n += MicroUDS_WheelExpire(wheel, &wheel->slot[0][index], 0, index);
+    }
 
-    return MICROUDS_OK;
+    return n;
 }
 
-void MicroUDS_Delete(void)
+uint32_t MicroUDS_WheelNextDeadline(MicroUDS_Wheel_t *wheel)
 {
-    if (MicroUDS_Handle->Record.data)
+    if (wheel == NULL)
+        return MICROUDS_DEADLINE_NONE;
+
+    if (wheel->due != NULL || atomic_load_explicit(&wheel->ready, memory_order_relaxed) != NULL)
+        return 0;
+
+    if (wheel->count == 0)
+        return MICROUDS_DEADLINE_NONE;
+
+    /* 每层最早的非空槽中的节点最早到期（超出范围的节点按实际到期时间计算） */
+    uint32_t best = UINT32_MAX;
+    for (uint32_t level = 0; level < MICROUDS_WHEEL_LEVELS; level++)
     {
-        for (size_t i = 0; i < MicroUDS_Handle->Record.count; i++)
-        {
-            MicroUDS_Sid_t sid = (MicroUDS_Sid_t)MicroUDS_Handle->Record.data[i];
-            Microuds_Service_t *svc = (Microuds_Service_t *)MicroHash_Find(&MicroUDS_Handle->hashTable, (MicroHash_key_t)sid);
-            if (!svc)
-                continue;
+        uint64_t map = wheel->occupied[level];
+        if (map == 0)
+            continue;
 
-            MicroUDS_Session_t *ses = svc->Session;
-            while (ses)
-            {
-                MicroUDS_Session_t *next = ses->next;
-                free(ses);
-                ses = next;
-            }
-            free(svc);
-        }
+        uint32_t shift = MICROUDS_WHEEL_BITS * level;
+        uint32_t from = ((wheel->now >> shift) + 1u) & MICROUDS_WHEEL_MASK; // 下一个到达的槽
+        uint64_t rotated = (map >> from) | (from != 0 ? map << (MICROUDS_WHEEL_SLOTS - from) : 0);
+        uint32_t index = (from + MicroUDS_Ctz64(rotated)) & MICROUDS_WHEEL_MASK;
 
-        free(MicroUDS_Handle->Record.data);
-        MicroUDS_Handle->Record.data = NULL;
-        MicroUDS_Handle->Record.count = 0;
-        MicroUDS_Handle->Record.size = 0;
+        for (const MicroUDS_TimerNode_t *node = wheel->slot[level][index]; node != NULL; node = node->next)
+        {
+            uint32_t d = node->expires - wheel->now;
+            if (d < best)
+                best = d;
+        }
     }
 
-    MicroHash_Delete(&MicroUDS_Handle->hashTable);
-
-    memset(&MicroUDS, 0, sizeof(MicroUDS));
+    return MicroUDS_TickMs(best);
 }
 
-MicroUDS_Sta_t MicroUDS_RegisterService(MicroUDS_ServiceTable_t *table, size_t table_len)
+MicroUDS_Sta_t MicroUDS_RegisterService(MicroUDS_Handle_t handle, const MicroUDS_ServiceTable_t *table, size_t table_len)
 {
+    MICROUDS_CHECKPTR(handle);
     MICROUDS_CHECKPTR(table);
     if (table_len == 0)
         return MICROUDS_ERR_PARAM;
 
+    /* 统计新服务（表中重复的只算一次），超出上限时不注册任何服务 */
+    uint32_t seen[8] = {0};
+    size_t added = 0;
     for (size_t i = 0; i < table_len; i++)
     {
-        Microuds_Service_t *svc = (Microuds_Service_t *)calloc(1, sizeof(Microuds_Service_t));
-        if (!svc)
+        uint8_t sid = (uint8_t)table[i].sid;
+        if (MicroUDS_FindService(handle, sid) == NULL && !(seen[sid >> 5] & (1u << (sid & 31u))))
+        {
+            seen[sid >> 5] |= 1u << (sid & 31u);
+            added++;
+        }
+    }
+
+    if (handle->ServiceCount + added > MICROUDS_SERVICE_RECORDS)
+        return MICROUDS_ERR_MEMORY;
+
+    if (handle->ServiceCount + added > handle->ServiceSize) // 只有堆模式会走到这里
+    {
+        Microuds_Service_t *grown = (Microuds_Service_t *)MicroUDS_Alloc(handle, (handle->ServiceCount + added) * sizeof(Microuds_Service_t));
+        if (grown == NULL)
             return MICROUDS_ERR_MEMORY;
 
-        svc->func = table[i].func;
-        svc->param = table[i].param;
-        svc->sid = table[i].sid;
-        svc->Session = NULL;
+        if (handle->Services != NULL)
+            memcpy(grown, handle->Services, handle->ServiceCount * sizeof(Microuds_Service_t));
+        if (handle->MultiFrame.stream != NULL) // 正在流式接收的服务随数组移动
+            handle->MultiFrame.stream = grown + (handle->MultiFrame.stream - handle->Services);
+        MicroUDS_Free(handle, handle->Services);
+        handle->Services = grown;
+        handle->ServiceSize = handle->ServiceCount + added;
+    }
+
+    for (size_t i = 0; i < table_len; i++)
+    {
+        Microuds_Service_t *svc = MicroUDS_FindService(handle, (uint8_t)table[i].sid);
 
-        if (MicroHash_Insert(&MicroUDS_Handle->hashTable, (MicroHash_key_t)table[i].sid, (void *)svc) != MICROHASH_OK)
+        if (svc == NULL) // 新服务，占用一个服务槽
         {
-            free(svc);
-            return MICROUDS_ERR_HASH;
+            svc = &handle->Services[handle->ServiceCount];
+            svc->sid = (uint8_t)table[i].sid;
+            svc->Session = NULL;
+
+#if MICROUDS_DISPATCH_TABLE
+            handle->Dispatch[svc->sid] = (uint8_t)(handle->ServiceCount + 1);
+#else
+            if (MicroHash_Insert(&handle->hashTable, (MicroHash_key_t)svc->sid, (void *)(uintptr_t)(handle->ServiceCount + 1)) != MICROHASH_OK)
+                return MICROUDS_ERR_HASH;
+#endif
+            handle->ServiceCount++;
         }
 
-        if (MicroUDS_Handle->Record.count < MicroUDS_Handle->Record.size)
-            MicroUDS_Handle->Record.data[MicroUDS_Handle->Record.count++] = (uint8_t)table[i].sid;
+        svc->func = table[i].func;
+        svc->param = table[i].param;
+        svc->handler = table[i].handler;
+        svc->chunk = table[i].chunk;
     }
 
     return MICROUDS_OK;
 }
 
-MicroUDS_Sta_t MicroUDS_RegisterSession(MicroUDS_Sid_t sid, MicroUDS_SessionTable_t *table, size_t table_len)
+bool MicroUDS_ServiceRegistered(MicroUDS_Handle_t handle, MicroUDS_Sid_t sid)
+{
+    return handle != NULL && MicroUDS_FindService(handle, (uint8_t)sid) != NULL;
+}
+
+MicroUDS_Sta_t MicroUDS_RegisterSession(MicroUDS_Handle_t handle, MicroUDS_Sid_t sid, const MicroUDS_SessionTable_t *table, size_t table_len)
 {
+    MICROUDS_CHECKPTR(handle);
     MICROUDS_CHECKPTR(table);
     if (table_len == 0)
         return MICROUDS_ERR_PARAM;
 
-    Microuds_Service_t *svc = (Microuds_Service_t *)MicroHash_Find(&MicroUDS_Handle->hashTable, (MicroHash_key_t)sid);
+    Microuds_Service_t *svc = MicroUDS_FindService(handle, (uint8_t)sid);
     if (!svc)
         return MICROUDS_ERR_PARAM;
 
-    MicroUDS_Session_t *last = svc->Session;
-    while (last && last->next)
-        last = last->next;
-
+    /* 统计新子功能（表中重复的只算一次），按实际数量分配 */
+    uint32_t map[4];
+    size_t added = 0;
+    memcpy(map, svc->SessionMap, sizeof(map));
     for (size_t i = 0; i < table_len; i++)
     {
-        MicroUDS_Session_t *node = (MicroUDS_Session_t *)calloc(1, sizeof(MicroUDS_Session_t));
-        if (!node)
+        uint8_t key = MICROUDS_SSID_KEY(table[i].ssid);
+        if (!MICROUDS_SSID_TEST(map, key))
+        {
+            MICROUDS_SSID_SET(map, key);
+            added++;
+        }
+    }
+
+    MicroUDS_Session_t *packed = svc->Session;
+    if (added != 0)
+    {
+        /* Arena 不能释放旧数组，重新打包会一直占用新的空间：只允许一次 */
+        if (handle->Arena.base != NULL && svc->Session != NULL)
+            return MICROUDS_ERR_PARAM;
+
+        packed = (MicroUDS_Session_t *)MicroUDS_Alloc(handle, (svc->SessionCount + added) * sizeof(MicroUDS_Session_t));
+        if (!packed)
             return MICROUDS_ERR_MEMORY;
 
-        node->ssid = table[i].ssid;
-        node->param = table[i].param;
-        node->func = table[i].func;
-        node->next = NULL;
+        if (svc->Session)
+            memcpy(packed, svc->Session, svc->SessionCount * sizeof(MicroUDS_Session_t));
+        MicroUDS_Free(handle, svc->Session);
+        svc->Session = packed;
+    }
 
-        if (!svc->Session)
-        {
-            svc->Session = node;
-            last = node;
-        }
-        else
+    for (size_t i = 0; i < table_len; i++)
+    {
+        uint8_t key = MICROUDS_SSID_KEY(table[i].ssid);
+        size_t index = MicroUDS_SessionIndex(svc, key);
+
+        if (!MICROUDS_SSID_TEST(svc->SessionMap, key)) // 新子功能，按ssid升序插入
         {
-            last->next = node;
-            last = node;
+            memmove(&packed[index + 1], &packed[index], (svc->SessionCount - index) * sizeof(MicroUDS_Session_t));
+            MICROUDS_SSID_SET(svc->SessionMap, key);
+            svc->SessionCount++;
+
+            for (uint8_t w = (uint8_t)((key >> 5) + 1); w < 4; w++)
+                svc->SessionBase[w]++;
         }
+
+        packed[index].ssid = table[i].ssid;
+        packed[index].param = table[i].param;
+        packed[index].func = table[i].func;
+        packed[index].handler = table[i].handler;
     }
     return MICROUDS_OK;
 }
 
-void MicroUDS_TickHandler(void)
+void MicroUDS_TickHandler(MicroUDS_Handle_t handle)
 {
-    MicroUDS_Handle->Tick++;
+    if (handle == NULL)
+        return;
+
+    handle->TickCount++;
 }
 
-void MicroUDS_ResetTimer(void)
+void MicroUDS_ResetTimer(MicroUDS_Handle_t handle)
 {
-    MicroUDS_Handle->last_time = MicroUDS_Handle->Tick;
+    if (handle == NULL)
+        return;
+
+    MicroUDS_UpdateClock(handle);
+    handle->last_time = handle->Tick;
 }
 
-void MicroUDS_TimerHandler(void)
+/**
+ * @brief 从时钟源更新64位时基
+ *
+ * 纳秒时钟直接换算；32位的毫秒时钟、时间轮时钟和 TickHandler 计数按差值累加，
+ * 回绕不影响时基
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_UpdateClock(MicroUDS_Handle_t handle)
 {
-    uint32_t current_time = MicroUDS_Handle->Tick;
-
-    if (current_time - MicroUDS_Handle->last_time >= MicroUDS_Handle->Timeout)
+    if (handle->Transport.NowNs != NULL)
+    {
+        const uint64_t ns = handle->Transport.NowNs(handle->TransportCtx);
+        handle->Tick = ns / 1000000000u * MICROUDS_TICK_FREQ_HZ + ns % 1000000000u * MICROUDS_TICK_FREQ_HZ / 1000000000u;
+    }
+    else if (handle->Transport.Now != NULL)
+    {
+        const uint32_t now = handle->Transport.Now(handle->TransportCtx); // 传输层时钟代替 TickHandler
+        handle->ClockMs += (uint32_t)(now - handle->ClockLast);
+        handle->ClockLast = now;
+        handle->Tick = MICROUDS_MS_TICK(handle->ClockMs);
+    }
+    else
     {
-        MicroUDS_Handle->last_time = current_time;
+        const uint32_t now = handle->Wheel != NULL ? handle->Wheel->now : handle->TickCount; // 时间轮的时钟
+        handle->Tick += (uint32_t)(now - handle->ClockLast);
+        handle->ClockLast = now;
+    }
+}
+
+/**
+ * @brief 是否需要处理：定时器到期、有新帧或挂起的请求已完成
+ *
+ * @param handle 实例句柄
+ * @return true 需要处理
+ */
+static bool MicroUDS_Due(MicroUDS_Handle_t handle)
+{
+    if (handle->Armed && handle->Tick >= handle->Deadline)
+        return true;
+
+    if (handle->Tx.state == MICROUDS_TX_SENDING && handle->Transport.NowNs != NULL && MicroUDS_StminElapsed(handle))
+        return true; // 纳秒时钟下 STmin 可能在两个滴答之间到期
+
+#if MICROUDS_RX_QUEUE_DEPTH
+    if (atomic_load_explicit(&handle->RxQueue.head, memory_order_acquire) !=
+        atomic_load_explicit(&handle->RxQueue.tail, memory_order_relaxed))
+        return true; // 生产者入队了新帧
+#endif
 
-        MicroUDS_Handle->sid = UDS_DIAGNOSTIC_SESSION_CONTROL;
-        MicroUDS_Handle->ssid = UDS_SESSION_DEFAULT;
+    return handle->Pending.active &&
+           atomic_load_explicit(&handle->Pending.state, memory_order_relaxed) == MICROUDS_PENDING_DONE; // 其他线程完成了请求
+}
+
+void MicroUDS_TimerHandler(MicroUDS_Handle_t handle)
+{
+    if (handle == NULL)
         return;
+
+    MicroUDS_UpdateClock(handle);
+
+    if (!MicroUDS_Due(handle))
+    {
+        if (handle->Wheel != NULL && handle->Timer.pprev == NULL)
+            MicroUDS_Reschedule(handle); // 时间轮提前（时钟不一致）唤醒，重新挂入
+        return; // 没有到期的定时器，空转时只需比较一次
     }
 
-    if (MicroUDS_Handle->N_Cs.Active)
+    if (handle->Notify != NULL)
+        atomic_store_explicit(&handle->Notified, true, memory_order_relaxed); // 处理期间产生的事件不通知
+
+    MicroUDS_TimerProcess(handle);
+    MicroUDS_Reschedule(handle);
+
+    if (handle->Notify != NULL)
+        MicroUDS_NotifyRearm(handle);
+}
+
+/**
+ * @brief 定时处理：分段发送、S3、N_Cr、挂起请求和请求队列
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_TimerProcess(MicroUDS_Handle_t handle)
+{
+    MicroUDS_Tick_t current_time = handle->Tick;
+
+    MicroUDS_TxProcess(handle); // 分段发送
+
+    /* S3：挂起的请求仍属于当前会话，挂起期间停止，最终响应之后重新开始 */
+    if (!handle->Pending.active && current_time - handle->last_time >= handle->Timeout)
     {
-        MicroUDS_Handle->N_Cs.tick = MicroUDS_Handle->Tick; // N_CS定时器
-        if (MicroUDS_Handle->N_Cs.tick - MicroUDS_Handle->N_Cs.lash_tick >= MicroUDS_Handle->N_Cs.Timeout)
+        handle->last_time = current_time;
+        if (handle->sid != UDS_DIAGNOSTIC_SESSION_CONTROL || handle->ssid != UDS_SESSION_DEFAULT)
         {
-            MicroUDS_Handle->N_Cs.lash_tick = MicroUDS_Handle->N_Cs.tick;
-            // 多帧超时
-            memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
-            MicroUDS_Handle->N_Cs.Active = false;
+            const uint8_t prev[2] = {handle->sid, handle->ssid};
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_S3_TIMEOUT);
+            MICROUDS_TRACE(handle, MICROUDS_TRACE_SESSION_RESET, prev, sizeof(prev));
         }
+
+        handle->sid = UDS_DIAGNOSTIC_SESSION_CONTROL;
+        handle->ssid = UDS_SESSION_DEFAULT; // 继续处理 N_Cr、挂起和排队的请求
     }
-    if (MicroUDS_Handle->active == UDS_ACTIVE_NO)
+
+    if (handle->N_Cs.Active)
     {
-        return; // 没有请求
+        handle->N_Cs.tick = handle->Tick; // N_CS定时器
+        if (handle->N_Cs.tick - handle->N_Cs.lash_tick >= handle->N_Cs.Timeout)
+        {
+            handle->N_Cs.lash_tick = handle->N_Cs.tick;
+            // 多帧超时
+#if MICROUDS_TRACE_ENABLE
+            uint8_t arg[8];
+            MicroUDS_PutBe32(arg, handle->MultiFrame.recv_len);
+            MicroUDS_PutBe32(arg + 4, handle->MultiFrame.total_len);
+            MICROUDS_TRACE(handle, MICROUDS_TRACE_N_CS_ABORT, arg, sizeof(arg));
+#endif
+            MicroUDS_ClearRecv(handle);
+            handle->N_Cs.Active = false;
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_N_CS_TIMEOUT);
+        }
     }
-    MicroUDS_Handle->active = UDS_ACTIVE_NO;
-
-    Microuds_Service_t *svc = (Microuds_Service_t *)MicroHash_Find(&MicroUDS_Handle->hashTable, (MicroHash_key_t)MicroUDS_Handle->sid); // 找服务
-    if (!svc)
+    if (MicroUDS_PendingProcess(handle))
     {
-
-        MicroUDS_NegativeResponse(UDS_NRC_SERVICE_NOT_SUPPORTED);
-        MicroUDS_ClearRecv();
+#if MICROUDS_RX_QUEUE_DEPTH
+        MicroUDS_RxQueueDrain(handle); // 挂起期间继续接收，新请求排队等待
+#endif
         return;
     }
 
-    if (svc->func)
+    /* 按顺序处理排队的请求，每次调用最多处理 ReqBudget 个 */
+    for (size_t budget = handle->ReqBudget; budget > 0; budget--)
     {
-        MICROUDS_ECUSETBUSY(); // ECU置忙
-        MicroUDS_NRC_t ret = svc->func(svc->param);
-        MicroUDS_Response(ret);
-        MICROUDS_ECUCLEAR(); // ECU清除忙等待
-    }
+#if MICROUDS_RX_QUEUE_DEPTH
+        MicroUDS_RxQueueDrain(handle); // 处理ISR入队的帧
+#endif
+        if (handle->ReqQueue.count == 0)
+        {
+            return; // 没有请求
+        }
 
-    bool session_found = false;
-    for (MicroUDS_Session_t *ses = svc->Session; ses; ses = ses->next)
-    {
-        if (ses->ssid == MicroUDS_Handle->ssid)
+        if (handle->Tx.state != MICROUDS_TX_IDLE)
         {
-            session_found = true;
-            if (ses->func)
-            {
-                MICROUDS_ECUSETBUSY();
-                MicroUDS_NRC_t ret = ses->func(ses->param);
-                MicroUDS_Response(ret);
-                MICROUDS_ECUCLEAR();
-            }
+            return; // 上一个响应仍在分段发送，发送缓冲区被占用，稍后处理
+        }
 
-            break;
+        if (handle->Pending.active)
+        {
+            return; // 上一个请求挂起，等待完成
+        }
+
+        MicroUDS_ReqEntry_t *req = &handle->ReqQueue.entry[handle->ReqQueue.head];
+
+        handle->ReqAt = req->at;
+        handle->Reply.Functional = req->functional; // 排队的请求经传输层响应
+        if (req->multi)
+        {
+            MicroUDS_Dispatch(handle, handle->MultiFrame.buf, req->len, handle->MultiFrame.total_len);
+            MicroUDS_ClearRecv(handle); // 释放多帧缓冲区
+        }
+        else
+        {
+            MicroUDS_Dispatch(handle, req->data, req->len, req->len);
         }
+        handle->Reply.Functional = false;
+
+        handle->ReqQueue.head = (uint8_t)((handle->ReqQueue.head + 1) % MICROUDS_REQ_QUEUE_DEPTH);
+        handle->ReqQueue.count--;
     }
+}
+
+/**
+ * @brief 请求入队（完整拷贝单帧请求；多帧请求占用多帧缓冲区直到处理完成）
+ *
+ * 队列满时回复 NRC 0x21，不会覆盖已排队的请求
+ *
+ * @param handle 实例句柄
+ * @param msg 请求报文（从SID开始）
+ * @param len 报文长度
+ * @param multi 报文在多帧缓冲区中
+ * @param functional 功能寻址请求
+ */
+static void MicroUDS_ReqPush(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, bool multi, bool functional)
+{
+    MicroUDS_ReqQueue_t *q = &handle->ReqQueue;
 
-    if (!session_found)
+    if (q->count >= MICROUDS_REQ_QUEUE_DEPTH)
     {
-        MicroUDS_NegativeResponse(UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_BUSY);
+        MicroUDS_SendNRC(handle, msg[0], UDS_NRC_BUSY_REPEAT_REQUEST);
+        if (multi)
+            MicroUDS_ClearRecv(handle);
+        return;
     }
 
-    MicroUDS_ClearRecv();
+    MicroUDS_ReqEntry_t *entry = &q->entry[(q->head + q->count) % MICROUDS_REQ_QUEUE_DEPTH];
+
+    entry->multi = multi;
+    entry->functional = functional;
+    entry->len = (uint32_t)len;
+    entry->at = MicroUDS_StatsNow(handle);
+    if (multi)
+        handle->MultiFrame.queued = true;
+    else
+        memcpy(entry->data, msg, len);
+
+    q->count++;
+    MicroUDS_Notify(handle, MICROUDS_EVENT_RX);
+}
+
+/**
+ * @brief 结束多帧接收，归还从缓冲池借用的缓冲区
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_ClearRecv(MicroUDS_Handle_t handle)
+{
+    MicroUDS_MultiFrame_t *mf = &handle->MultiFrame;
+
+    if (handle->RxPool != NULL && mf->buf != NULL && mf->buf != mf->head)
+        MicroUDS_PoolRelease(handle->RxPool, mf->buf);
+
+    memset(mf, 0, sizeof(MicroUDS_MultiFrame_t));
 }
 
-static void MicroUDS_ClearRecv(void)
+/**
+ * @brief 取得多帧接收缓冲区：流式接收用 head，其余用实例缓冲区或从缓冲池借用
+ *
+ * @param handle 实例句柄
+ * @param stream 流式接收
+ * @return uint8_t* 缓冲池无空闲块时返回NULL
+ */
+static uint8_t *MicroUDS_RecvBuffer(MicroUDS_Handle_t handle, bool stream)
 {
-    memset(&MicroUDS_Handle->Recbuf, 0, sizeof(MicroUDS_Isotp_t));
+    if (stream)
+        return handle->MultiFrame.head;
+
+    if (handle->RxPool != NULL)
+        return MicroUDS_PoolAcquire(handle->RxPool);
 
-    memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
+    return handle->RxBuf;
 }
 
-void MicroUDS_ReceiveCallback(uint8_t *data)
+/**
+ * @brief 回复请求首帧的流控帧
+ *
+ * 与其他帧一样经 MICROUDS_SAFE_CALL_TRANSMIT 发送：失败计入 MICROUDS_STAT_TX_ERROR。
+ * 帧长与单帧相同按 DLC 取整，3 字节的流控帧在经典CAN和CAN FD上都是 8 字节
+ *
+ * @param handle 实例句柄
+ * @param fs 流状态
+ * @return MicroUDS_Sta_t
+ */
+static MicroUDS_Sta_t MicroUDS_SendFlowControl(MicroUDS_Handle_t handle, Isotp_FlowStatus_t fs)
 {
-    if (data == NULL)
-        return;
+    uint8_t frame[MICROUDS_FRAME_MAX];
+    size_t frame_len = Isotp_FrameLength(3);
+
+    memset(frame, 0, sizeof(frame));
+    Isotp_PackFlowControlFrame(frame, MICROUDS_FC_BS, MICROUDS_FC_STMIN, fs);
+    MICROUDS_SAFE_CALL_TRANSMIT(handle, frame, frame_len);
+
+    return MICROUDS_OK;
+}
+
+/**
+ * @brief 把新到达的多帧数据交给流式接收回调
+ *
+ * 回调返回 NRC 时发送负响应并放弃本次接收
+ *
+ * @param handle 实例句柄
+ * @param data 新数据（SID 之后的请求数据）
+ * @param len 数据长度
+ * @param offset 数据在请求数据中的偏移
+ * @return true 继续接收
+ */
+static bool MicroUDS_StreamChunk(MicroUDS_Handle_t handle, const uint8_t *data, size_t len, size_t offset)
+{
+    MicroUDS_MultiFrame_t *mf = &handle->MultiFrame;
+    Microuds_Service_t *svc = mf->stream;
+
+    MicroUDS_Request_t chunk = {
+        .sid = mf->buf[0],
+        .ssid = mf->buf[1],
+        .data = data,
+        .len = len,
+        .total = mf->total_len - 1,
+    };
+    MicroUDS_NRC_t ret = svc->chunk(handle, &chunk, offset, svc->param);
+    if (ret == UDS_NRC_SUCCESS)
+        return true;
+
+    uint8_t sid = mf->buf[0];
+    MicroUDS_ClearRecv(handle);
+    if (ret != UDS_NRC_NO)
+        MicroUDS_SendNRC(handle, sid, ret);
+    return false;
+}
 
+/**
+ * @brief 处理一帧（协议处理，在消费者上下文执行）
+ *
+ * @param handle 实例句柄
+ * @param data CAN / CAN FD 帧数据
+ * @param len 帧长度
+ */
+static void MicroUDS_ProcessFrame(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
+{
+    Isotp_Payload_t frame;
     Isotp_FrameType_t FrameType = (Isotp_FrameType_t)((data[0] & 0xF0) >> 4);
 
     switch (FrameType)
     {
     case FRAME_SINGLE:
 
-        if (Isotp_UnpackSingleFrame(&MicroUDS_Handle->Recbuf.SF, data) != ISOTP_OK)
+        if (Isotp_UnpackSingleFrameEx(&frame, data, len) != ISOTP_OK)
             return;
 
-        UDS_CHECK_ECU_BUSY(); // 检查ECU是否忙
-        MicroUDS_ResetTimer();
-        MicroUDS_Handle->sid = MicroUDS_Handle->Recbuf.SF.byte.Payload[0];
-        MicroUDS_Handle->ssid = MicroUDS_Handle->Recbuf.SF.byte.Payload[1];
-        MicroUDS_Handle->active = UDS_ACTIVE_SIGNAL;
+        if (frame.Size > MICROUDS_SF_MAX)
+            return; // 比本实例帧长度更长的单帧
+
+        MicroUDS_ResetTimer(handle);
+        MicroUDS_ReqPush(handle, frame.Payload, frame.Size, false, false); // 完整拷贝请求入队
         break;
 
     case FRAME_FIRST: // 首帧
     {
-        if (Isotp_UnpackFirstFrame(&MicroUDS_Handle->Recbuf.FF, data) != ISOTP_OK)
+        if (Isotp_UnpackFirstFrameEx(&frame, data, len) != ISOTP_OK)
+            return;
+
+        if (handle->MultiFrame.queued)
+        {
+            /* 多帧缓冲区被队列中尚未处理的请求占用 */
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_BUSY);
+            MicroUDS_SendNRC(handle, frame.Payload[0], UDS_NRC_BUSY_REPEAT_REQUEST);
             return;
+        }
 
-        if (MicroUDS_Handle->MultiFrame.receiving)
+        if (handle->MultiFrame.receiving)
         {
-            MicroUDS_NegativeResponse(UDS_NRC_REQUEST_SEQ_ERROR);
-            memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_SEQ_ERROR);
+            MicroUDS_SendNRC(handle, handle->MultiFrame.buf[0], UDS_NRC_REQUEST_SEQ_ERROR);
+            MicroUDS_ClearRecv(handle);
         }
 
-        UDS_CHECK_ECU_BUSY(); // 检查ECU是否忙
-        MicroUDS_ResetTimer();
+        MicroUDS_ResetTimer(handle);
 
-        MicroUDS_Handle->MultiFrame.total_len =
-            ((MicroUDS_Handle->Recbuf.FF.byte.FF_DL_H & 0x0F) << 8) |
-            MicroUDS_Handle->Recbuf.FF.byte.FF_DL_L;
+        handle->MultiFrame.total_len = frame.Total;
+
+        /* 服务注册了流式接收回调：数据边收边交付，只缓存首帧 */
+        Microuds_Service_t *svc = MicroUDS_FindService(handle, frame.Payload[0]);
+        handle->MultiFrame.stream = (svc != NULL && svc->chunk != NULL) ? svc : NULL;
 
         /* 边界检查：避免超过 buf 长度 */
-        if (MicroUDS_Handle->MultiFrame.total_len > sizeof(MicroUDS_Handle->MultiFrame.buf))
+        if (handle->MultiFrame.stream == NULL && handle->MultiFrame.total_len > handle->RxBufSize)
         {
             /* 总长度超限，拒绝或截断，根据策略返回 overflow */
-            MicroUDS_NegativeResponse(UDS_NRC_RESPONSE_TOO_LONG);
-            memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_OVERFLOW);
+            MicroUDS_SendNRC(handle, frame.Payload[0], UDS_NRC_RESPONSE_TOO_LONG);
+            MicroUDS_ClearRecv(handle);
             break;
         }
 
-        size_t ff_payload = 6;
-        if (ff_payload > MicroUDS_Handle->MultiFrame.total_len)
-            ff_payload = MicroUDS_Handle->MultiFrame.total_len;
-
-        memcpy(MicroUDS_Handle->MultiFrame.buf,
-               MicroUDS_Handle->Recbuf.FF.byte.Payload, ff_payload);
+        handle->MultiFrame.buf = MicroUDS_RecvBuffer(handle, handle->MultiFrame.stream != NULL);
+        if (handle->MultiFrame.buf == NULL)
+        {
+            /* 缓冲池已空：流控溢出，测试仪终止本次传输 */
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_OVERFLOW);
+            MicroUDS_SendFlowControl(handle, ISOTP_FS_OVFLW);
+            MicroUDS_ClearRecv(handle);
+            break;
+        }
 
-        MicroUDS_Handle->MultiFrame.recv_len = (uint16_t)ff_payload;
-        MicroUDS_Handle->MultiFrame.next_sn = 1;
-        MicroUDS_Handle->MultiFrame.receiving = true;
+        memcpy(handle->MultiFrame.buf, frame.Payload, frame.Size);
 
-        if (MicroUDS_Handle->MultiFrame.recv_len >= 1)
-            MicroUDS_Handle->sid = MicroUDS_Handle->MultiFrame.buf[0]; // 在首帧取ID
+        handle->MultiFrame.recv_len = (uint32_t)frame.Size;
+        handle->MultiFrame.head_len = (uint32_t)frame.Size;
+        handle->MultiFrame.next_sn = 1;
+        handle->MultiFrame.receiving = true;
 
-        Isotp_PackFlowControlFrame(MicroUDS_Handle->Recbuf.FC.data, MICROUDS_FC_BS, MICROUDS_FC_STMIN, ISOTP_FS_CTS);
-        if (MicroUDS_Handle->Transmit)
-            MicroUDS_Handle->Transmit(MicroUDS_Handle->Recbuf.FC.data, 8);
+        if (handle->MultiFrame.stream != NULL && !MicroUDS_StreamChunk(handle, frame.Payload + 1, frame.Size - 1, 0))
+            break; // 拒绝请求，不回复流控
 
-        MicroUDS_Handle->N_Cs.Active = true;
+        if (MicroUDS_SendFlowControl(handle, ISOTP_FS_CTS) != MICROUDS_OK)
+        {
+            MicroUDS_ClearRecv(handle); // 测试仪收不到流控，不会发送连续帧，立即释放缓冲区
+            break;
+        }
+#if MICROUDS_TRACE_ENABLE
+        uint8_t total[4];
+        MicroUDS_PutBe32(total, handle->MultiFrame.total_len);
+        MICROUDS_TRACE(handle, MICROUDS_TRACE_FF, total, sizeof(total));
+#endif
+
+        handle->N_Cs.lash_tick = handle->Tick;
+        handle->N_Cs.Active = true;
     }
     break;
 
     case FRAME_CONSECUTIVE:
     {
-        if (!MicroUDS_Handle->MultiFrame.receiving)
+        if (!handle->MultiFrame.receiving)
             break;
 
-        if (Isotp_UnPackConsecutiveFrame(&MicroUDS_Handle->Recbuf.CF, data) != ISOTP_OK)
+        if (len < 2)
         {
-            memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
+            MicroUDS_ClearRecv(handle);
             return;
         }
 
-        MicroUDS_ResetTimer();
-        uint8_t sn = MicroUDS_Handle->Recbuf.CF.byte.SN;
-        if (sn != MicroUDS_Handle->MultiFrame.next_sn)
+        MicroUDS_ResetTimer(handle);
+        uint8_t sn = data[0] & 0x0F;
+        if (sn != handle->MultiFrame.next_sn)
         {
-            MicroUDS_Handle->MultiFrame.receiving = false;
-            MicroUDS_NegativeResponse(UDS_NRC_REQUEST_SEQ_ERROR);
-            memset(&MicroUDS_Handle->MultiFrame, 0, sizeof(MicroUDS_MultiFrame_t));
+            const uint8_t arg[2] = {handle->MultiFrame.next_sn, sn};
+            MICROUDS_TRACE(handle, MICROUDS_TRACE_SN_ERROR, arg, sizeof(arg));
+            handle->MultiFrame.receiving = false;
+            MICROUDS_STAT_INC(handle, MICROUDS_STAT_SEQ_ERROR);
+            MicroUDS_SendNRC(handle, handle->MultiFrame.buf[0], UDS_NRC_REQUEST_SEQ_ERROR);
+            MicroUDS_ClearRecv(handle);
+            handle->N_Cs.Active = false;
             break;
         }
 
-        size_t remaining = MicroUDS_Handle->MultiFrame.total_len - MicroUDS_Handle->MultiFrame.recv_len;
-        size_t copy_len = remaining >= 7 ? 7 : remaining;
+        size_t remaining = handle->MultiFrame.total_len - handle->MultiFrame.recv_len;
+        size_t copy_len = remaining >= len - 1 ? len - 1 : remaining;
 
-        memcpy(MicroUDS_Handle->MultiFrame.buf + MicroUDS_Handle->MultiFrame.recv_len,
-               MicroUDS_Handle->Recbuf.CF.byte.Payload, copy_len);
+        if (handle->MultiFrame.stream != NULL)
+        {
+            if (!MicroUDS_StreamChunk(handle, data + 1, copy_len, handle->MultiFrame.recv_len - 1))
+            {
+                handle->N_Cs.Active = false;
+                break;
+            }
+        }
+        else
+        {
+            memcpy(handle->MultiFrame.buf + handle->MultiFrame.recv_len, data + 1, copy_len);
+        }
 
-        MicroUDS_Handle->MultiFrame.recv_len += (uint16_t)copy_len;
-        MicroUDS_Handle->MultiFrame.next_sn = (uint8_t)((sn + 1) & 0x0F);
+        handle->MultiFrame.recv_len += (uint32_t)copy_len;
+        handle->MultiFrame.next_sn = (uint8_t)((sn + 1) & 0x0F);
+        handle->N_Cs.lash_tick = handle->Tick; // 收到CF，重新开始 N_Cs
 
-        if (MicroUDS_Handle->MultiFrame.recv_len >= MicroUDS_Handle->MultiFrame.total_len)
+        if (handle->MultiFrame.recv_len >= handle->MultiFrame.total_len)
         {
-            MicroUDS_Handle->MultiFrame.receiving = false;
-            MicroUDS_Handle->active = UDS_ACTIVE_MULTI;
+            handle->MultiFrame.receiving = false;
+            handle->N_Cs.Active = false;
 
-            memset((void*)&MicroUDS_Handle->N_Cs, 0, sizeof(MicroUDS_N_Cs_t));
+            /* 多帧缓冲区交给请求队列，处理完成后释放（流式接收只有首帧数据） */
+            uint32_t buffered = handle->MultiFrame.stream != NULL ? handle->MultiFrame.head_len : handle->MultiFrame.recv_len;
+            MicroUDS_ReqPush(handle, handle->MultiFrame.buf, buffered, true, false);
         }
     }
     break;
 
     case FRAME_FLOWCONTROL:
-        /* ECU 不处理流控帧*/
+        MicroUDS_TxFlowControl(handle, data, len); // 多帧响应的流控
         break;
 
     default:
@@ -430,38 +2838,215 @@ void MicroUDS_ReceiveCallback(uint8_t *data)
         break;
     }
 }
-static inline void MicroUDS_Response(MicroUDS_NRC_t code)
+
+#if MICROUDS_RX_QUEUE_DEPTH
+/**
+ * @brief 取出接收队列中的帧并处理，直到接收队列为空或请求队列已满
+ *
+ * 只在消费者（MicroUDS_TimerHandler）上下文调用
+ *
+ * @param handle 实例句柄
+ */
+static void MicroUDS_RxQueueDrain(MicroUDS_Handle_t handle)
+{
+    MicroUDS_RxQueue_t *q = &handle->RxQueue;
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    while (tail != head && handle->ReqQueue.count < MICROUDS_REQ_QUEUE_DEPTH)
+    {
+        uint32_t slot = tail & (MICROUDS_RX_QUEUE_DEPTH - 1);
+        MicroUDS_ProcessFrame(handle, q->frame[slot], q->len[slot]);
+        tail++;
+        atomic_store_explicit(&q->tail, tail, memory_order_release); // 释放槽位给生产者
+    }
+}
+#endif
+
+void MicroUDS_ReceiveCallback(MicroUDS_Handle_t handle, uint8_t *data)
+{
+    MicroUDS_ReceiveFrame(handle, data, ISOTP_CAN_DL);
+}
+
+void MicroUDS_ReceiveFrame(MicroUDS_Handle_t handle, const uint8_t *data, size_t len)
+{
+    if (handle == NULL || data == NULL || len == 0 || len > handle->FrameLen)
+        return;
+
+    MICROUDS_TRACE(handle, MICROUDS_TRACE_RX, data, len);
+
+#if MICROUDS_RX_QUEUE_DEPTH
+    /* 生产者：只入队，O(1)，协议处理在 MicroUDS_TimerHandler 中完成 */
+    MicroUDS_RxQueue_t *q = &handle->RxQueue;
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    if (head - tail >= MICROUDS_RX_QUEUE_DEPTH)
+    {
+        atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed); // 队列满，丢帧
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_RX_DROPPED);
+        return;
+    }
+
+    uint32_t slot = head & (MICROUDS_RX_QUEUE_DEPTH - 1);
+    memcpy(q->frame[slot], data, len);
+    q->len[slot] = (uint8_t)len;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release); // 发布给消费者
+
+    if (handle->Wheel != NULL)
+        MicroUDS_WheelWake(handle);
+    MicroUDS_Notify(handle, MICROUDS_EVENT_RX);
+#else
+    MicroUDS_UpdateClock(handle); // 空闲时主循环不调用 MicroUDS_TimerHandler，时基可能已过时
+    MicroUDS_ProcessFrame(handle, data, len);
+    MicroUDS_Kick(handle);
+#endif
+}
+
+/**
+ * @brief 完整请求入队
+ *
+ * @param handle 实例句柄
+ * @param msg 请求报文（从SID开始）
+ * @param len 报文长度
+ * @param functional 功能寻址请求
+ */
+static void MicroUDS_ReceiveWhole(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, bool functional)
+{
+    if (handle == NULL || msg == NULL || len == 0)
+        return;
+
+    MicroUDS_ResetTimer(handle); // 同时更新时基
+    MicroUDS_Kick(handle);
+
+    if (len <= MICROUDS_SF_MAX)
+    {
+        MicroUDS_ReqPush(handle, msg, len, false, functional); // 完整拷贝请求入队
+        return;
+    }
+
+    if (handle->MultiFrame.queued || handle->MultiFrame.receiving)
+    {
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_BUSY);
+        MicroUDS_SendNRC(handle, msg[0], UDS_NRC_BUSY_REPEAT_REQUEST); // 多帧缓冲区被占用
+        return;
+    }
+
+    if (len > handle->RxBufSize)
+    {
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_OVERFLOW);
+        MicroUDS_SendNRC(handle, msg[0], UDS_NRC_RESPONSE_TOO_LONG);
+        return;
+    }
+
+    handle->MultiFrame.buf = MicroUDS_RecvBuffer(handle, false);
+    if (handle->MultiFrame.buf == NULL)
+    {
+        MICROUDS_STAT_INC(handle, MICROUDS_STAT_OVERFLOW);
+        MicroUDS_SendNRC(handle, msg[0], UDS_NRC_BUSY_REPEAT_REQUEST); // 缓冲池已空
+        return;
+    }
+
+    memcpy(handle->MultiFrame.buf, msg, len);
+    handle->MultiFrame.total_len = (uint32_t)len;
+    handle->MultiFrame.recv_len = (uint32_t)len;
+    MicroUDS_ReqPush(handle, handle->MultiFrame.buf, len, true, functional);
+}
+
+void MicroUDS_ReceiveMessage(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len)
+{
+    MicroUDS_ReceiveWhole(handle, msg, len, false);
+}
+
+void MicroUDS_ReceiveFunctional(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len)
+{
+    MicroUDS_ReceiveWhole(handle, msg, len, true);
+}
+
+MicroUDS_Sta_t MicroUDS_SubmitRequest(MicroUDS_Handle_t handle, const uint8_t *msg, size_t len, const MicroUDS_Reply_t *reply)
+{
+    MICROUDS_CHECKPTR(handle);
+    MICROUDS_CHECKPTR(msg);
+
+    if (len == 0)
+        return MICROUDS_ERR_PARAM;
+
+    /* 发送缓冲区被占用、有挂起或排队的请求时不插队 */
+    if (handle->Tx.state != MICROUDS_TX_IDLE || handle->Pending.active || handle->ReqQueue.count != 0)
+        return MICROUDS_ERR_BUSY;
+
+    MicroUDS_ResetTimer(handle); // 同时更新时基
+
+    if (reply != NULL)
+        handle->Reply = *reply;
+
+    handle->ReqAt = MicroUDS_StatsNow(handle);
+    MicroUDS_Dispatch(handle, msg, len, len); // 请求视图直接指向调用者的报文，不拷贝
+
+    memset(&handle->Reply, 0, sizeof(MicroUDS_Reply_t));
+    MicroUDS_Reschedule(handle); // 会话、挂起或分段发送的定时器
+
+    return MICROUDS_OK;
+}
+
+static inline void MicroUDS_Response(MicroUDS_Handle_t handle, MicroUDS_NRC_t code)
 {
     switch (code)
     {
     case UDS_NRC_SUCCESS: // 正响应
-        MicroUDS_PositiveResponse();
+        MicroUDS_PositiveResponse(handle);
         break;
     case UDS_NRC_NO: // 直接跳过，不做响应 (默认)
         break;
+    case UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING: // 挂起，稍后由 MicroUDS_CompleteRequest 完成
+        MicroUDS_PendingStart(handle);
+        break;
     default:
-        MicroUDS_NegativeResponse(code); // 负响应
+        MicroUDS_NegativeResponse(handle, code); // 负响应
         break;
     }
 }
 
-MicroUDS_Sta_t MicroUDS_ReadMultiframeInfo(MicroUDS_MultiInfo_t *info)
+MicroUDS_Sta_t MicroUDS_ReadMultiframeInfo(MicroUDS_Handle_t handle, MicroUDS_MultiInfo_t *info)
 {
+    MICROUDS_CHECKPTR(handle);
     MICROUDS_CHECKPTR(info);
 
-    if (MicroUDS_Handle->MultiFrame.recv_len <= 1)
+    const MicroUDS_MultiFrame_t *mf = &handle->MultiFrame;
+    uint32_t buffered = mf->stream != NULL ? mf->head_len : mf->recv_len; // 流式接收只缓存了首帧
+
+    if (mf->buf == NULL || buffered <= 1)
         return MICROUDS_ERR;
 
-    info->sid = MicroUDS_Handle->MultiFrame.buf[0];
-    info->data = &MicroUDS_Handle->MultiFrame.buf[1];
-    info->data_len = MicroUDS_Handle->MultiFrame.recv_len - 1;
+    info->sid = mf->buf[0];
+    info->data = &mf->buf[1];
+    info->data_len = buffered - 1;
 
     return MICROUDS_OK;
 }
 
-uint32_t MicroUDS_GetTickCount()
+uint32_t MicroUDS_GetTickCount(MicroUDS_Handle_t handle)
+{
+    if (handle == NULL)
+        return 0;
+
+    return (uint32_t)handle->Tick;
+}
+
+void *MicroUDS_GetUserData(MicroUDS_Handle_t handle)
+{
+    if (handle == NULL)
+        return NULL;
+
+    return handle->UserData;
+}
+
+const MicroUDS_Transport_t *MicroUDS_GetTransport(MicroUDS_Handle_t handle)
 {
-    return MicroUDS_Handle->Tick;
+    if (handle == NULL)
+        return NULL;
+
+    return &handle->Transport;
 }
 
 /* EOF */
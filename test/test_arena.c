@@ -0,0 +1,100 @@
+/**
+ * @file test_arena.c
+ * @brief Sub-function registration in arena (zero-heap) and heap mode.
+ */
+
+#include "test_common.h"
+
+static MicroUDS_Loopback_t lb;
+
+static MicroUDS_NRC_t Test_Reject(void *param)
+{
+    (void)param;
+    return UDS_NRC_CONDITION_NOT_CORRECT;
+}
+
+static const MicroUDS_ServiceTable_t services[] = {
+    {UDS_DIAGNOSTIC_SESSION_CONTROL, NULL, NULL, NULL, NULL},
+};
+
+static const MicroUDS_SessionTable_t sessions[] = {
+    {UDS_SESSION_DEFAULT, Test_Positive, NULL, NULL},
+    {UDS_SESSION_EXTENDED, Test_Positive, NULL, NULL},
+};
+
+/* 发送 10 xx，返回响应的最后一个字节（正响应为ssid，负响应为NRC），超时返回 -1 */
+static int Test_Session(uint8_t ssid)
+{
+    const uint8_t req[] = {UDS_DIAGNOSTIC_SESSION_CONTROL, ssid};
+
+    int len = MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10);
+    return len > 0 ? lb.Rsp[len - 1] : -1;
+}
+
+/* Arena：替换已有子功能不占用新空间，新增子功能被拒绝 */
+static int Test_ArenaReRegister(void)
+{
+    static uint8_t arena[MICROUDS_ARENA_SIZE(3)];
+    static MicroUDS_Obj obj;
+    MicroUDS_Conf_t conf = {.Arena = arena, .ArenaSize = sizeof(arena)};
+    MicroUDS_Handle_t ecu = &obj;
+
+    TEST_CHECK(MicroUDS_Loopback_Init(&lb, NULL) == MICROUDS_OK);
+    MicroUDS_Loopback_Attach(&lb, &conf);
+    TEST_CHECK(MicroUDS_Init(ecu, &conf) == MICROUDS_OK);
+    MicroUDS_Loopback_Bind(&lb, ecu);
+
+    TEST_CHECK(MicroUDS_RegisterService(ecu, services, 1) == MICROUDS_OK);
+    TEST_CHECK(MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, sessions, 2) == MICROUDS_OK);
+    size_t used = obj.Arena.used;
+
+    const MicroUDS_SessionTable_t replace[] = {{UDS_SESSION_EXTENDED, Test_Reject, NULL, NULL}};
+    TEST_CHECK(MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, replace, 1) == MICROUDS_OK);
+    TEST_CHECK(obj.Arena.used == used);
+    TEST_CHECK(Test_Session(UDS_SESSION_EXTENDED) == UDS_NRC_CONDITION_NOT_CORRECT);
+
+    const MicroUDS_SessionTable_t add[] = {{UDS_SESSION_PROGRAMMING, Test_Positive, NULL, NULL}};
+    for (int i = 0; i < 4; i++)
+        TEST_CHECK(MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, add, 1) == MICROUDS_ERR_PARAM);
+    TEST_CHECK(obj.Arena.used == used);
+    TEST_CHECK(Test_Session(UDS_SESSION_PROGRAMMING) == UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+    TEST_CHECK(Test_Session(UDS_SESSION_DEFAULT) == UDS_SESSION_DEFAULT);
+
+    MicroUDS_Delete(ecu);
+    return 0;
+}
+
+/* 堆模式：之后仍可新增子功能，按ssid有序查找 */
+static int Test_HeapAddLater(void)
+{
+    MicroUDS_Conf_t conf = {0};
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    TEST_CHECK(MicroUDS_RegisterService(ecu, services, 1) == MICROUDS_OK);
+    TEST_CHECK(MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, sessions, 2) == MICROUDS_OK);
+
+    const MicroUDS_SessionTable_t add[] = {
+        {UDS_SESSION_PROGRAMMING, Test_Positive, NULL, NULL},
+        {UDS_SESSION_PROGRAMMING, Test_Reject, NULL, NULL}, // 表中重复时后者生效
+    };
+    TEST_CHECK(MicroUDS_RegisterSession(ecu, UDS_DIAGNOSTIC_SESSION_CONTROL, add, 2) == MICROUDS_OK);
+
+    TEST_CHECK(Test_Session(UDS_SESSION_DEFAULT) == UDS_SESSION_DEFAULT);
+    TEST_CHECK(Test_Session(UDS_SESSION_PROGRAMMING) == UDS_NRC_CONDITION_NOT_CORRECT);
+    TEST_CHECK(Test_Session(UDS_SESSION_EXTENDED) == UDS_SESSION_EXTENDED);
+    TEST_CHECK(Test_Session(UDS_SESSION_SAFETY) == UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_ArenaReRegister);
+    TEST_RUN(failed, Test_HeapAddLater);
+
+    return failed;
+}
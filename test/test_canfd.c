@@ -0,0 +1,204 @@
+/**
+ * @file test_canfd.c
+ * @brief CAN FD framing: escaped Single Frame SF_DL and 32-bit First Frame FF_DL,
+ *        in both directions. Built against the core compiled with MICROUDS_CANFD_ENABLE.
+ */
+
+#include "test_common.h"
+
+#if MICROUDS_CANFD_ENABLE
+
+#define TEST_DL      ISOTP_CANFD_DL // 64 字节帧
+#define TEST_BIG_LEN 5000u          // 超过 12 位 FF_DL
+
+static Test_Bus_t bus;
+static uint8_t req[TEST_BIG_LEN];
+static uint8_t rsp[TEST_BIG_LEN];
+
+/* 回显请求数据：响应长度与请求长度相同 */
+static MicroUDS_NRC_t Test_Echo(MicroUDS_Handle_t handle, const MicroUDS_Request_t *request, MicroUDS_Response_t *response, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    return MicroUDS_ResponseAppend(response, request->data, request->len) == MICROUDS_OK ? UDS_NRC_SUCCESS : UDS_NRC_RESPONSE_TOO_LONG;
+}
+
+static MicroUDS_Handle_t Test_Setup(void)
+{
+    MicroUDS_Conf_t conf = {.RxBufSize = TEST_BIG_LEN};
+    MicroUDS_Handle_t ecu = Test_BusCreate(&bus, TEST_DL, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_ROUTINE_CONTROL, NULL, NULL, Test_Echo, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+    return ecu;
+}
+
+static void Test_Fill(size_t len)
+{
+    req[0] = UDS_ROUTINE_CONTROL;
+    for (size_t i = 1; i < len; i++)
+        req[i] = (uint8_t)(i * 13);
+}
+
+/* 检查从 first 开始的响应为 71 加回显的请求数据 */
+static bool Test_Echoed(size_t first, size_t len)
+{
+    if (Test_BusMessage(&bus, first, rsp, sizeof(rsp)) != len)
+        return false;
+    return rsp[0] == 0x71 && memcmp(rsp + 1, req + 1, len - 1) == 0;
+}
+
+/* 以单帧发送 len 字节的请求（len > 7 时使用 SF_DL 转义），帧长按 DLC 取整 */
+static void Test_SendSingle(MicroUDS_Handle_t ecu, size_t len)
+{
+    uint8_t frame[TEST_DL];
+    size_t pci = len > 7 ? 2 : 1;
+
+    frame[0] = len > 7 ? 0x00 : (uint8_t)len;
+    frame[1] = (uint8_t)len;
+    memcpy(frame + pci, req, len);
+    Test_BusFeed(ecu, frame, pci + len, Isotp_FrameLength(pci + len));
+    MicroUDS_TimerHandler(ecu);
+}
+
+/* 以首帧 + 连续帧发送 len 字节的请求，len > 4095 时使用 32 位 FF_DL 转义 */
+static bool Test_SendMulti(MicroUDS_Handle_t ecu, size_t len)
+{
+    uint8_t frame[TEST_DL];
+    size_t pci;
+
+    if (len > 4095u)
+    {
+        frame[0] = 0x10;
+        frame[1] = 0x00;
+        frame[2] = (uint8_t)(len >> 24);
+        frame[3] = (uint8_t)(len >> 16);
+        frame[4] = (uint8_t)(len >> 8);
+        frame[5] = (uint8_t)len;
+        pci = 6;
+    }
+    else
+    {
+        frame[0] = (uint8_t)(0x10 | (len >> 8));
+        frame[1] = (uint8_t)len;
+        pci = 2;
+    }
+
+    size_t fc = bus.Count;
+    size_t offset = TEST_DL - pci;
+    memcpy(frame + pci, req, offset);
+    Test_BusFeed(ecu, frame, TEST_DL, TEST_DL);
+    if (bus.Count != fc + 1 || bus.Frame[fc][0] != 0x30)
+        return false; // 期望流控 CTS
+
+    for (uint8_t sn = 1; offset < len; sn = (uint8_t)((sn + 1) & 0x0F))
+    {
+        size_t n = len - offset < TEST_DL - 1u ? len - offset : TEST_DL - 1u;
+
+        frame[0] = (uint8_t)(0x20 | sn);
+        memcpy(frame + 1, req + offset, n);
+        Test_BusFeed(ecu, frame, 1 + n, Isotp_FrameLength(1 + n));
+        offset += n;
+    }
+
+    MicroUDS_TimerHandler(ecu);
+    return true;
+}
+
+static void Test_Fc(MicroUDS_Handle_t ecu)
+{
+    static const uint8_t fc[] = {0x30, 0x00, 0x00};
+
+    Test_BusFeed(ecu, fc, sizeof(fc), ISOTP_CAN_DL);
+    Test_BusAdvance(&bus, ecu, 10);
+}
+
+/* 单帧：不超过 7 字节仍用经典 SF_DL，更长的用 00 + SF_DL，最长 62 字节 */
+static int Test_SingleFrame(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    Test_Fill(TEST_DL);
+
+    Test_SendSingle(ecu, 7);
+    TEST_CHECK(bus.Count == 1 && bus.Frame[0][0] == 0x07 && bus.Len[0] == ISOTP_CAN_DL);
+    TEST_CHECK(Test_Echoed(0, 7));
+
+    Test_SendSingle(ecu, 8);
+    TEST_CHECK(bus.Count == 2 && bus.Frame[1][0] == 0x00 && bus.Frame[1][1] == 8 && bus.Len[1] == 12);
+    TEST_CHECK(Test_Echoed(1, 8));
+
+    Test_SendSingle(ecu, 20);
+    TEST_CHECK(bus.Count == 3 && bus.Frame[2][0] == 0x00 && bus.Frame[2][1] == 20 && bus.Len[2] == 24);
+    TEST_CHECK(Test_Echoed(2, 20));
+
+    Test_SendSingle(ecu, TEST_DL - 2);
+    TEST_CHECK(bus.Count == 4 && bus.Frame[3][0] == 0x00 && bus.Frame[3][1] == TEST_DL - 2 && bus.Len[3] == TEST_DL);
+    TEST_CHECK(Test_Echoed(3, TEST_DL - 2));
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 首帧：63 字节起分段；FF_DL 不超过 4095 用 12 位，超过时用 10 00 + 32 位长度 */
+static int Test_FirstFrame(void)
+{
+    static const size_t lens[] = {TEST_DL - 1, 4095, 4096, TEST_BIG_LEN};
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    Test_Fill(TEST_BIG_LEN);
+
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        size_t len = lens[i];
+
+        TEST_CHECK(Test_SendMulti(ecu, len));
+        size_t first = bus.Count - 1;
+        TEST_CHECK(bus.Frame[first][0] >> 4 == 0x1 && bus.Len[first] == TEST_DL);
+
+        if (len > 4095u)
+        {
+            const uint8_t *ff = bus.Frame[first];
+            TEST_CHECK(ff[0] == 0x10 && ff[1] == 0x00);
+            TEST_CHECK(((uint32_t)ff[2] << 24 | (uint32_t)ff[3] << 16 | (uint32_t)ff[4] << 8 | ff[5]) == len);
+        }
+        else
+        {
+            TEST_CHECK(((bus.Frame[first][0] & 0x0Fu) << 8 | bus.Frame[first][1]) == len);
+        }
+
+        Test_Fc(ecu);
+        TEST_CHECK(Test_Echoed(first, len));
+        TEST_CHECK(bus.Len[bus.Count - 2] == TEST_DL); // 只有最后一个连续帧按 DLC 缩短
+    }
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_SingleFrame);
+    TEST_RUN(failed, Test_FirstFrame);
+
+    return failed;
+}
+
+#else
+
+int main(void)
+{
+    printf("skipped: MICROUDS_CANFD_ENABLE = 0\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file test_clock.c
+ * @brief Timers started after the main loop slept through a long idle period.
+ *
+ * A sleeping main loop (Poll(-1) + MicroUDS_TimerHandler) does not call
+ * into the instance while nothing is scheduled, so the instance clock
+ * must be read when a frame arrives, not only in MicroUDS_TimerHandler.
+ */
+
+#include "test_common.h"
+
+static MicroUDS_Loopback_t lb;
+
+/* 空闲超过 N_Cr 之后的多帧请求不应被误判超时 */
+static int Test_IdleMultiFrame(void)
+{
+    static MicroUDS_Stats_t stats;
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_WRITE_DATA_BY_IDENTIFIER, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    uint8_t req[20] = {0x2E, 0xF1, 0x90};
+    for (uint32_t idle = 200; idle <= 3000; idle += 1400)
+    {
+        lb.Now += idle; // 主循环休眠：时钟前进但不调用 MicroUDS_TimerHandler
+        TEST_CHECK(MicroUDS_NextDeadline(ecu) != 0);
+
+        int len = MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 100);
+        TEST_CHECK(len == 2 && lb.Rsp[0] == 0x6E && lb.Rsp[1] == 0xF1);
+    }
+
+    MicroUDS_StatsSnapshot_t snap;
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    TEST_CHECK(snap.Counter[MICROUDS_STAT_N_CS_TIMEOUT] == 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 空闲之后进入扩展会话，S3 从收到请求时开始计时 */
+static int Test_IdleSessionS3(void)
+{
+    static MicroUDS_Stats_t stats;
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_DIAGNOSTIC_SESSION_CONTROL, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    lb.Now += 3000;
+    const uint8_t req[] = {0x10, 0x03};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 100) == 2 && lb.Rsp[0] == 0x50);
+
+    uint32_t s3 = MicroUDS_NextDeadline(ecu);
+    TEST_CHECK(s3 > MICROUDS_SERVICE_TIMEOUT_MS - 10 && s3 <= MICROUDS_SERVICE_TIMEOUT_MS);
+
+    MicroUDS_StatsSnapshot_t snap;
+    MicroUDS_Loopback_Advance(&lb, s3 - 1);
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    TEST_CHECK(snap.Counter[MICROUDS_STAT_S3_TIMEOUT] == 0);
+
+    MicroUDS_Loopback_Advance(&lb, 1);
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    TEST_CHECK(snap.Counter[MICROUDS_STAT_S3_TIMEOUT] == 1);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_IdleMultiFrame);
+    TEST_RUN(failed, Test_IdleSessionS3);
+
+    return failed;
+}
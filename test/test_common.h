@@ -0,0 +1,210 @@
+#ifndef MICROUDS_TEST_COMMON_H
+#define MICROUDS_TEST_COMMON_H
+
+/**
+ * @file test_common.h
+ * @brief Helpers shared by the loopback-driven tests.
+ *
+ * Each test/test_*.c is one executable (one ctest case): it prints one line
+ * per check function and exits with the number of failed functions.
+ */
+
+#include "Microuds_loopback.h"
+#include <stdio.h>
+#include <string.h>
+
+/* 条件不成立时打印位置并让当前测试函数失败 */
+#define TEST_CHECK(cond)                                                         \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);    \
+            return 1;                                                            \
+        }                                                                        \
+    } while (0)
+
+/* 运行一个测试函数并累计失败数 */
+#define TEST_RUN(failed, fn)                                                     \
+    do                                                                           \
+    {                                                                            \
+        int ret_ = fn();                                                         \
+        printf("%s %s\n", ret_ == 0 ? "ok  " : "FAIL", #fn);                     \
+        (failed) += ret_ != 0;                                                   \
+    } while (0)
+
+static inline MicroUDS_NRC_t Test_Positive(void *param)
+{
+    (void)param;
+    return UDS_NRC_SUCCESS;
+}
+
+/**
+ * @brief 创建绑定到回环端口的实例
+ *
+ * @param lb 回环端口（调用者存储）
+ * @param lbConf 回环配置，NULL = 经典 CAN 帧模式
+ * @param conf 实例配置，可预先填写 Stats / Trace / RxBufSize 等，传输层字段由这里填写
+ * @return MicroUDS_Handle_t 失败返回NULL
+ */
+static inline MicroUDS_Handle_t Test_Create(MicroUDS_Loopback_t *lb, const MicroUDS_LoopbackConf_t *lbConf, MicroUDS_Conf_t *conf)
+{
+    MicroUDS_Handle_t handle = NULL;
+
+    if (MicroUDS_Loopback_Init(lb, lbConf) != MICROUDS_OK)
+        return NULL;
+
+    MicroUDS_Loopback_Attach(lb, conf);
+    if (MicroUDS_Create(&handle, conf) != MICROUDS_OK)
+        return NULL;
+
+    MicroUDS_Loopback_Bind(lb, handle);
+    return handle;
+}
+
+/**
+ * @brief 记录实例发出的每一帧的测试总线（帧模式），用于检查分段细节
+ *
+ * 回环端口会自动回复流控帧；需要自己构造流控帧、检查帧间隔或CAN FD帧格式时使用
+ */
+#ifndef TEST_BUS_FRAMES
+#define TEST_BUS_FRAMES 1024
+#endif
+
+typedef struct
+{
+    MicroUDS_Transport_t Transport;       // 传输层接口（Test_BusCreate 填写）
+    uint32_t Now;                         // 手动时钟（毫秒）
+    size_t Count;                         // 已记录的帧数
+    size_t BurstMax;                      // TxBurst 每次最多接受的帧数，0 = 不配置 TxBurst
+    uint8_t Frame[TEST_BUS_FRAMES][MICROUDS_FRAME_MAX];
+    uint8_t Len[TEST_BUS_FRAMES];
+    uint32_t At[TEST_BUS_FRAMES];         // 发送时刻
+} Test_Bus_t;
+
+static inline int Test_BusTx(void *user, uint8_t *data, size_t size)
+{
+    Test_Bus_t *bus = (Test_Bus_t *)user;
+
+    if (bus->Count >= TEST_BUS_FRAMES)
+        return 1;
+
+    memcpy(bus->Frame[bus->Count], data, size);
+    bus->Len[bus->Count] = (uint8_t)size;
+    bus->At[bus->Count] = bus->Now;
+    bus->Count++;
+    return 0;
+}
+
+static inline int Test_BusBurst(void *user, const MicroUDS_Frame_t *frames, size_t count)
+{
+    Test_Bus_t *bus = (Test_Bus_t *)user;
+    size_t n = count < bus->BurstMax ? count : bus->BurstMax;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (Test_BusTx(user, (uint8_t *)frames[i].data, frames[i].len) != 0)
+            return (int)i;
+    }
+    return (int)n;
+}
+
+static inline uint32_t Test_BusNow(void *user)
+{
+    return ((Test_Bus_t *)user)->Now;
+}
+
+/**
+ * @brief 创建绑定到测试总线的实例
+ *
+ * @param bus 测试总线（调用者存储）
+ * @param frameLen 帧长度，0 = 8
+ * @param conf 实例配置，传输层字段由这里填写
+ * @return MicroUDS_Handle_t 失败返回NULL
+ */
+static inline MicroUDS_Handle_t Test_BusCreate(Test_Bus_t *bus, size_t frameLen, MicroUDS_Conf_t *conf)
+{
+    MicroUDS_Handle_t handle = NULL;
+    size_t burst = bus->BurstMax;
+
+    memset(bus, 0, sizeof(*bus));
+    bus->BurstMax = burst;
+    bus->Transport.Tx = Test_BusTx;
+    bus->Transport.TxBurst = burst != 0 ? Test_BusBurst : NULL;
+    bus->Transport.Now = Test_BusNow;
+    bus->Transport.MaxFrameSize = frameLen;
+
+    conf->Transport = &bus->Transport;
+    conf->TransportCtx = bus;
+    if (MicroUDS_Create(&handle, conf) != MICROUDS_OK)
+        return NULL;
+
+    return handle;
+}
+
+/* 推进时钟，每毫秒调用一次 MicroUDS_TimerHandler */
+static inline void Test_BusAdvance(Test_Bus_t *bus, MicroUDS_Handle_t handle, uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        bus->Now++;
+        MicroUDS_TimerHandler(handle);
+    }
+}
+
+/* 输入一帧（不足帧长的部分按 0xCC 填充） */
+static inline void Test_BusFeed(MicroUDS_Handle_t handle, const uint8_t *data, size_t len, size_t frameLen)
+{
+    uint8_t frame[MICROUDS_FRAME_MAX];
+
+    memset(frame, 0xCC, sizeof(frame));
+    memcpy(frame, data, len);
+    MicroUDS_ReceiveFrame(handle, frame, frameLen != 0 ? frameLen : len);
+}
+
+/**
+ * @brief 从第 first 帧开始重组一条响应（单帧，或首帧加连续帧，跳过其间的其他帧）
+ *
+ * @return size_t 响应长度，不完整、序号错误或超过 cap 时返回0
+ */
+static inline size_t Test_BusMessage(const Test_Bus_t *bus, size_t first, uint8_t *out, size_t cap)
+{
+    Isotp_Payload_t p;
+
+    if (first >= bus->Count)
+        return 0;
+
+    if ((bus->Frame[first][0] & 0xF0) == 0x00)
+    {
+        if (Isotp_UnpackSingleFrameEx(&p, bus->Frame[first], bus->Len[first]) != ISOTP_OK || p.Size > cap)
+            return 0;
+        memcpy(out, p.Payload, p.Size);
+        return p.Size;
+    }
+
+    if (Isotp_UnpackFirstFrameEx(&p, bus->Frame[first], bus->Len[first]) != ISOTP_OK || p.Total > cap)
+        return 0;
+
+    size_t len = p.Size;
+    uint8_t sn = 1;
+    memcpy(out, p.Payload, p.Size);
+
+    for (size_t i = first + 1; i < bus->Count && len < p.Total; i++)
+    {
+        if ((bus->Frame[i][0] & 0xF0) != 0x20)
+            continue;
+        if ((bus->Frame[i][0] & 0x0F) != sn)
+            return 0;
+
+        size_t n = bus->Len[i] - 1u;
+        if (n > p.Total - len)
+            n = p.Total - len;
+        memcpy(out + len, bus->Frame[i] + 1, n);
+        len += n;
+        sn = (uint8_t)((sn + 1) & 0x0F);
+    }
+
+    return len == p.Total ? len : 0;
+}
+
+#endif
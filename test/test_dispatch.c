@@ -0,0 +1,86 @@
+/**
+ * @file test_dispatch.c
+ * @brief Service registration: growing the service array, replacing handlers
+ *        and the MICROUDS_SERVICE_RECORDS limit.
+ */
+
+#include "test_common.h"
+
+static MicroUDS_Loopback_t lb;
+
+static MicroUDS_NRC_t Test_Reject(void *param)
+{
+    (void)param;
+    return UDS_NRC_CONDITION_NOT_CORRECT;
+}
+
+/* 发送只含SID的请求，返回响应首字节（正响应 SID + 0x40，负响应 0x7F），超时返回 -1 */
+static int Test_Send(uint8_t sid)
+{
+    int len = MicroUDS_Loopback_Transact(&lb, &sid, 1, 10);
+    return len > 0 ? lb.Rsp[0] : -1;
+}
+
+/* 分多次注册：先注册的服务在数组增长后仍然可用 */
+static int Test_Grow(void)
+{
+    MicroUDS_Conf_t conf = {0};
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    for (uint8_t sid = 0x10; sid < 0x10 + 20; sid++)
+    {
+        const MicroUDS_ServiceTable_t one[] = {{sid, Test_Positive, NULL, NULL, NULL}};
+        TEST_CHECK(MicroUDS_RegisterService(ecu, one, 1) == MICROUDS_OK);
+    }
+
+    for (uint8_t sid = 0x10; sid < 0x10 + 20; sid++)
+    {
+        TEST_CHECK(MicroUDS_ServiceRegistered(ecu, sid));
+        TEST_CHECK(Test_Send(sid) == sid + 0x40);
+    }
+    TEST_CHECK(!MicroUDS_ServiceRegistered(ecu, 0x10 + 20));
+    TEST_CHECK(Test_Send(0x10 + 20) == 0x7F);
+
+    /* 再次注册同一SID只替换处理函数 */
+    const MicroUDS_ServiceTable_t replace[] = {{0x15, Test_Reject, NULL, NULL, NULL}, {0x15, Test_Reject, NULL, NULL, NULL}};
+    TEST_CHECK(MicroUDS_RegisterService(ecu, replace, 2) == MICROUDS_OK);
+    TEST_CHECK(Test_Send(0x15) == 0x7F && lb.Rsp[2] == UDS_NRC_CONDITION_NOT_CORRECT);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 超过 MICROUDS_SERVICE_RECORDS 的表整体被拒绝，已注册的服务不受影响 */
+static int Test_Limit(void)
+{
+    MicroUDS_ServiceTable_t table[MICROUDS_SERVICE_RECORDS + 1];
+    MicroUDS_Conf_t conf = {0};
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    for (size_t i = 0; i < MICROUDS_SERVICE_RECORDS + 1; i++)
+        table[i] = (MicroUDS_ServiceTable_t){(MicroUDS_Sid_t)i, Test_Positive, NULL, NULL, NULL};
+
+    TEST_CHECK(MicroUDS_RegisterService(ecu, table, MICROUDS_SERVICE_RECORDS - 1) == MICROUDS_OK);
+    TEST_CHECK(MicroUDS_RegisterService(ecu, table + MICROUDS_SERVICE_RECORDS - 1, 2) == MICROUDS_ERR_MEMORY);
+    TEST_CHECK(!MicroUDS_ServiceRegistered(ecu, (MicroUDS_Sid_t)(MICROUDS_SERVICE_RECORDS - 1)));
+
+    TEST_CHECK(MicroUDS_RegisterService(ecu, table, MICROUDS_SERVICE_RECORDS) == MICROUDS_OK); // 只新增一个
+    TEST_CHECK(MicroUDS_ServiceRegistered(ecu, (MicroUDS_Sid_t)(MICROUDS_SERVICE_RECORDS - 1)));
+    TEST_CHECK(MicroUDS_RegisterService(ecu, table + MICROUDS_SERVICE_RECORDS, 1) == MICROUDS_ERR_MEMORY);
+    TEST_CHECK(Test_Send(0x10) == 0x50);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_Grow);
+    TEST_RUN(failed, Test_Limit);
+
+    return failed;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_functional.c
+ * @brief Functionally addressed requests: suppressed NRCs (ISO 14229-1).
+ */
+
+#include "test_common.h"
+
+static MicroUDS_Loopback_t lb;
+
+static MicroUDS_NRC_t Test_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)rsp;
+    (void)param;
+
+    if (req->len != 2)
+        return UDS_NRC_INVALID_FORMAT;
+    if (req->data[1] == 0x91)
+        return UDS_NRC_CONDITION_NOT_CORRECT;
+    if (req->data[1] != 0x90)
+        return UDS_NRC_REQUEST_OUT_OF_RANGE;
+
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_Handle_t Test_Setup(void)
+{
+    MicroUDS_Conf_t conf = {0};
+    const MicroUDS_LoopbackConf_t lbConf = {.Message = true};
+
+    MicroUDS_Handle_t ecu = Test_Create(&lb, &lbConf, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Test_ReadDid, NULL},
+        {UDS_TESTER_PRESENT, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+
+    return ecu;
+}
+
+/* 提交请求，返回发出的响应数，响应留在 lb.Rsp */
+static uint64_t Test_Submit(MicroUDS_Handle_t ecu, const uint8_t *req, size_t len, bool functional)
+{
+    const MicroUDS_Reply_t reply = {.Functional = functional};
+    uint64_t before = lb.TxFrames;
+
+    lb.Done = false;
+    if (MicroUDS_SubmitRequest(ecu, req, len, &reply) != MICROUDS_OK)
+        return UINT64_MAX;
+
+    return lb.TxFrames - before;
+}
+
+/* 立即分发：功能寻址只抑制 0x11/0x12/0x31/0x7E/0x7F */
+static int Test_SubmitFunctional(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t unknown[] = {0x85, 0x02};
+    TEST_CHECK(Test_Submit(ecu, unknown, sizeof(unknown), false) == 1);
+    TEST_CHECK(lb.Len == 3 && lb.Rsp[0] == 0x7F && lb.Rsp[2] == UDS_NRC_SERVICE_NOT_SUPPORTED);
+    TEST_CHECK(Test_Submit(ecu, unknown, sizeof(unknown), true) == 0);
+
+    const uint8_t range[] = {0x22, 0xF1, 0x00};
+    TEST_CHECK(Test_Submit(ecu, range, sizeof(range), false) == 1);
+    TEST_CHECK(lb.Rsp[2] == UDS_NRC_REQUEST_OUT_OF_RANGE);
+    TEST_CHECK(Test_Submit(ecu, range, sizeof(range), true) == 0);
+
+    const uint8_t condition[] = {0x22, 0xF1, 0x91};
+    TEST_CHECK(Test_Submit(ecu, condition, sizeof(condition), true) == 1);
+    TEST_CHECK(lb.Len == 3 && lb.Rsp[2] == UDS_NRC_CONDITION_NOT_CORRECT); // 其他NRC照常发送
+
+    const uint8_t did[] = {0x22, 0xF1, 0x90};
+    TEST_CHECK(Test_Submit(ecu, did, sizeof(did), true) == 1);
+    TEST_CHECK(lb.Len == 1 && lb.Rsp[0] == 0x62);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 排队的功能寻址请求保留寻址类型，不影响之后的物理寻址请求 */
+static int Test_QueuedFunctional(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t unknown[] = {0x85, 0x02};
+    const uint8_t present[] = {0x3E, 0x00};
+
+    MicroUDS_ReceiveFunctional(ecu, unknown, sizeof(unknown));
+    MicroUDS_ReceiveFunctional(ecu, present, sizeof(present));
+    MicroUDS_Loopback_Advance(&lb, 1);
+    TEST_CHECK(lb.TxFrames == 1 && lb.Len == 1 && lb.Rsp[0] == 0x7E);
+
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, unknown, sizeof(unknown), 10) == 3);
+    TEST_CHECK(lb.Rsp[0] == 0x7F && lb.Rsp[2] == UDS_NRC_SERVICE_NOT_SUPPORTED);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_SubmitFunctional);
+    TEST_RUN(failed, Test_QueuedFunctional);
+
+    return failed;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file test_long_request.c
+ * @brief Requests longer than 65535 bytes keep their full length.
+ *
+ * FF_DL escapes and whole messages (kernel ISO-TP, DoIP) may exceed 16 bits;
+ * the request queue and the handler's request view must not truncate them.
+ */
+
+#include "test_common.h"
+
+#define TEST_REQ_LEN 65537u
+
+static MicroUDS_Loopback_t lb;
+static uint8_t req[TEST_REQ_LEN];
+static size_t seenLen;
+static size_t seenTotal;
+static uint8_t seenLast;
+
+static MicroUDS_NRC_t Test_TransferData(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)rsp;
+    (void)param;
+
+    seenLen = req->len;
+    seenTotal = req->total;
+    seenLast = req->data[req->len - 1];
+    return UDS_NRC_SUCCESS;
+}
+
+/* 报文模式：整报文输入，经请求队列交给处理函数 */
+static int Test_MessageOver64k(void)
+{
+    MicroUDS_Conf_t conf = {.RxBufSize = TEST_REQ_LEN + 100};
+    const MicroUDS_LoopbackConf_t lbConf = {.Message = true};
+
+    MicroUDS_Handle_t ecu = Test_Create(&lb, &lbConf, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TRANSFER_DATA, NULL, NULL, Test_TransferData, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    req[0] = UDS_TRANSFER_DATA;
+    req[1] = 0x01;
+    req[TEST_REQ_LEN - 1] = 0xA5;
+
+    int len = MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 100);
+    TEST_CHECK(len == 1 && lb.Rsp[0] == 0x76);
+    TEST_CHECK(seenLen == TEST_REQ_LEN - 1 && seenTotal == TEST_REQ_LEN - 1);
+    TEST_CHECK(seenLast == 0xA5);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 多帧：FF_DL 转义（32位长度）的经典 CAN 请求 */
+static int Test_FrameOver64k(void)
+{
+    MicroUDS_Conf_t conf = {.RxBufSize = TEST_REQ_LEN};
+
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TRANSFER_DATA, NULL, NULL, Test_TransferData, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    seenLen = 0;
+    req[TEST_REQ_LEN - 1] = 0x5A;
+
+    int len = MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 100);
+    TEST_CHECK(len == 1 && lb.Rsp[0] == 0x76);
+    TEST_CHECK(seenLen == TEST_REQ_LEN - 1 && seenLast == 0x5A);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_MessageOver64k);
+    TEST_RUN(failed, Test_FrameOver64k);
+
+    return failed;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file test_pending.c
+ * @brief Response-Pending (NRC 0x78) requests and their completion.
+ */
+
+#include "test_common.h"
+#include <pthread.h>
+
+static MicroUDS_Loopback_t lb;
+static MicroUDS_Stats_t stats;
+static bool useWorker;
+static pthread_t worker;
+
+static void *Test_Worker(void *arg)
+{
+    static const uint8_t rsp[] = {0x71, 0x01, 0x02, 0x00, 0x55};
+
+    MicroUDS_CompleteRequest((MicroUDS_Handle_t)arg, UDS_NRC_SUCCESS, rsp, sizeof(rsp));
+    return NULL;
+}
+
+static MicroUDS_NRC_t Test_Routine(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)req;
+    (void)rsp;
+    (void)param;
+
+    if (useWorker && pthread_create(&worker, NULL, Test_Worker, handle) != 0)
+        return UDS_NRC_CONDITION_NOT_CORRECT; // 工作线程可能在返回0x78之前或之后完成
+
+    return UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING;
+}
+
+static MicroUDS_Handle_t Test_Setup(void)
+{
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_ROUTINE_CONTROL, NULL, NULL, Test_Routine, NULL},
+        {UDS_TESTER_PRESENT, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+    useWorker = false;
+
+    return ecu;
+}
+
+static uint32_t Test_Stat(size_t nrc, MicroUDS_Stat_t stat)
+{
+    MicroUDS_StatsSnapshot_t snap;
+
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    return nrc != 0 ? snap.Nrc[nrc] : snap.Counter[stat];
+}
+
+/* 0x78 后由主循环完成：只接受一次 */
+static int Test_CompleteLater(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t req[] = {0x31, 0x01, 0x02, 0x00};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), MICROUDS_TIMEOUT_P2_MS * 2) < 0);
+    TEST_CHECK(Test_Stat(0x78, 0) == 1); // P2 之后发送一次0x78
+
+    const uint8_t rsp[] = {0x71, 0x01, 0x02, 0x00, 0xAA};
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, rsp, sizeof(rsp)) == MICROUDS_OK);
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, rsp, sizeof(rsp)) == MICROUDS_ERR);
+    TEST_CHECK(MicroUDS_NextDeadline(ecu) == 0);
+
+    MicroUDS_Loopback_Advance(&lb, 1);
+    TEST_CHECK(lb.Done && lb.Len == sizeof(rsp) && memcmp(lb.Rsp, rsp, sizeof(rsp)) == 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 工作线程完成，可能早于处理函数返回 */
+static int Test_CompleteFromWorker(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    useWorker = true;
+    const uint8_t req[] = {0x31, 0x01, 0x02, 0x00};
+    for (int i = 0; i < 100; i++)
+    {
+        int len = MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 0);
+        pthread_join(worker, NULL); // 模拟时钟不等待真实线程
+        if (len < 0)
+        {
+            MicroUDS_Loopback_Advance(&lb, 1);
+            len = lb.Done ? (int)lb.Len : -1;
+        }
+        TEST_CHECK(len == 5 && lb.Rsp[0] == 0x71 && lb.Rsp[4] == 0x55);
+    }
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 没有挂起的请求：拒绝完成，不写发送缓冲区 */
+static int Test_CompleteNotPending(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t stray[] = {0x71, 0x01, 0xDE, 0xAD};
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, stray, sizeof(stray)) == MICROUDS_ERR);
+
+    const uint8_t req[] = {0x3E, 0x00};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) > 0 && lb.Rsp[0] == 0x7E);
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, stray, sizeof(stray)) == MICROUDS_ERR);
+    TEST_CHECK(MicroUDS_NextDeadline(ecu) != 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 一直没有完成：超时后回复 NRC 0x10，继续处理排队的请求 */
+static int Test_PendingTimeout(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t req[] = {0x31, 0x01, 0x02, 0x00};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) < 0);
+
+    const uint8_t tp[] = {0x3E, 0x00};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, tp, sizeof(tp), 10) < 0); // 排队等待
+    TEST_CHECK(MicroUDS_SubmitRequest(ecu, tp, sizeof(tp), NULL) == MICROUDS_ERR_BUSY);
+
+#if MICROUDS_PENDING_TIMEOUT_MS
+    MicroUDS_Loopback_Advance(&lb, MICROUDS_PENDING_TIMEOUT_MS);
+    TEST_CHECK(Test_Stat(UDS_NRC_GENERAL_REJECT, 0) == 1);
+    TEST_CHECK(lb.Done && lb.Rsp[0] == 0x7E); // 超时的负响应之后处理排队的请求
+
+    const uint8_t late[] = {0x71, 0x01};
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, late, sizeof(late)) == MICROUDS_ERR);
+    TEST_CHECK(MicroUDS_SubmitRequest(ecu, tp, sizeof(tp), NULL) == MICROUDS_OK);
+#endif
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 挂起期间 S3 停止，最终响应之后重新开始 */
+static int Test_PendingStopsS3(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    const uint8_t tp[] = {0x3E, 0x00}; // 离开默认会话，S3 开始计时
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, tp, sizeof(tp), 10) > 0 && lb.Rsp[0] == 0x7E);
+
+    const uint8_t req[] = {0x31, 0x01, 0x02, 0x00};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) < 0);
+
+    MicroUDS_Loopback_Advance(&lb, MICROUDS_SERVICE_TIMEOUT_MS * 2);
+    TEST_CHECK(Test_Stat(0, MICROUDS_STAT_S3_TIMEOUT) == 0);
+    TEST_CHECK(Test_Stat(0x78, 0) >= 2); // P2，之后每个 P2*
+
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, NULL, 0) == MICROUDS_OK);
+    MicroUDS_Loopback_Advance(&lb, 1);
+    TEST_CHECK(lb.Done && lb.Len == 2 && lb.Rsp[0] == 0x71);
+
+    uint32_t s3 = MicroUDS_NextDeadline(ecu);
+    TEST_CHECK(s3 == MICROUDS_SERVICE_TIMEOUT_MS);
+    MicroUDS_Loopback_Advance(&lb, s3);
+    TEST_CHECK(Test_Stat(0, MICROUDS_STAT_S3_TIMEOUT) == 1);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_CompleteLater);
+    TEST_RUN(failed, Test_CompleteFromWorker);
+    TEST_RUN(failed, Test_CompleteNotPending);
+    TEST_RUN(failed, Test_PendingTimeout);
+    TEST_RUN(failed, Test_PendingStopsS3);
+
+    return failed;
+}
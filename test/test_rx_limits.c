@@ -0,0 +1,169 @@
+/**
+ * @file test_rx_limits.c
+ * @brief Receive limits: request queue overflow (NRC 0x21), occupied and
+ *        oversized multi-frame buffers, shared pool exhaustion (FC overflow).
+ */
+
+#include "test_common.h"
+
+static Test_Bus_t bus;
+static Test_Bus_t bus2;
+static MicroUDS_Stats_t stats;
+
+static const uint8_t present[] = {0x02, 0x3E, 0x00};
+static const uint8_t first[] = {0x10, 0x0A, 0x2E, 0xF1, 0x90, 0x01, 0x02, 0x03}; // 10 字节写请求的首帧
+static const uint8_t next[] = {0x21, 0x04, 0x05, 0x06, 0x07};
+
+static void Test_Register(MicroUDS_Handle_t ecu)
+{
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TESTER_PRESENT, Test_Positive, NULL, NULL, NULL},
+        {UDS_WRITE_DATA_BY_IDENTIFIER, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+}
+
+static MicroUDS_Handle_t Test_Setup(Test_Bus_t *b, MicroUDS_Conf_t *conf)
+{
+    MicroUDS_Handle_t ecu = Test_BusCreate(b, 0, conf);
+    if (ecu != NULL)
+        Test_Register(ecu);
+    return ecu;
+}
+
+static uint32_t Test_Stat(MicroUDS_Stat_t stat)
+{
+    MicroUDS_StatsSnapshot_t snap;
+
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    return snap.Counter[stat];
+}
+
+/* 检查第 i 帧为单帧负响应 7F sid nrc */
+static bool Test_IsNrc(const Test_Bus_t *b, size_t i, uint8_t sid, uint8_t nrc)
+{
+    return i < b->Count && b->Frame[i][0] == 0x03 && b->Frame[i][1] == 0x7F && b->Frame[i][2] == sid && b->Frame[i][3] == nrc;
+}
+
+/* 请求队列满：立即回复 0x21，已排队的请求不受影响 */
+static int Test_QueueOverflow(void)
+{
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Setup(&bus, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    for (int i = 0; i < MICROUDS_REQ_QUEUE_DEPTH; i++)
+        Test_BusFeed(ecu, present, sizeof(present), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 0);
+
+    Test_BusFeed(ecu, present, sizeof(present), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 1 && Test_IsNrc(&bus, 0, UDS_TESTER_PRESENT, UDS_NRC_BUSY_REPEAT_REQUEST));
+    TEST_CHECK(Test_Stat(MICROUDS_STAT_BUSY) == 1);
+
+    MicroUDS_TimerHandler(ecu);
+    TEST_CHECK(bus.Count == 1 + MICROUDS_REQ_QUEUE_DEPTH);
+    for (size_t i = 1; i < bus.Count; i++)
+        TEST_CHECK(bus.Frame[i][0] == 0x01 && bus.Frame[i][1] == 0x7E);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 多帧缓冲区被尚未处理的请求占用时，新的首帧回复 0x21 */
+static int Test_MultiFrameBusy(void)
+{
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Setup(&bus, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 1 && bus.Frame[0][0] == 0x30); // CTS
+    Test_BusFeed(ecu, next, sizeof(next), ISOTP_CAN_DL);
+
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 2 && Test_IsNrc(&bus, 1, UDS_WRITE_DATA_BY_IDENTIFIER, UDS_NRC_BUSY_REPEAT_REQUEST));
+
+    MicroUDS_TimerHandler(ecu);
+    TEST_CHECK(bus.Count == 3 && bus.Frame[2][0] == 0x02 && bus.Frame[2][1] == 0x6E);
+
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL); // 缓冲区已释放
+    TEST_CHECK(bus.Count == 4 && bus.Frame[3][0] == 0x30);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 请求超过 RxBufSize：回复 0x14，不回复流控 */
+static int Test_Oversized(void)
+{
+    MicroUDS_Conf_t conf = {.Stats = &stats, .RxBufSize = 8};
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecu = Test_Setup(&bus, &conf);
+    TEST_CHECK(ecu != NULL);
+
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 1 && Test_IsNrc(&bus, 0, UDS_WRITE_DATA_BY_IDENTIFIER, UDS_NRC_RESPONSE_TOO_LONG));
+    TEST_CHECK(Test_Stat(MICROUDS_STAT_OVERFLOW) == 1);
+
+    Test_BusFeed(ecu, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+    TEST_CHECK(bus.Count == 1); // 不属于任何接收的连续帧被忽略
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 两个实例共享只有一个块的缓冲池：块被占用时首帧回复流控溢出，归还后恢复 */
+static int Test_PoolExhausted(void)
+{
+    static uint8_t mem[MICROUDS_POOL_SIZE(1, 64)];
+    static MicroUDS_Pool_t pool;
+
+    TEST_CHECK(MicroUDS_PoolInit(&pool, mem, sizeof(mem), 64) == MICROUDS_OK);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    MicroUDS_Conf_t confA = {.RxPool = &pool};
+    MicroUDS_Conf_t confB = {.RxPool = &pool, .Stats = &stats};
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t ecuA = Test_Setup(&bus, &confA);
+    MicroUDS_Handle_t ecuB = Test_Setup(&bus2, &confB);
+    TEST_CHECK(ecuA != NULL && ecuB != NULL);
+
+    Test_BusFeed(ecuA, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 1 && bus.Frame[0][0] == 0x30);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 0);
+
+    Test_BusFeed(ecuB, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus2.Count == 1 && bus2.Frame[0][0] == 0x32); // FS = 2
+    TEST_CHECK(Test_Stat(MICROUDS_STAT_OVERFLOW) == 1);
+
+    Test_BusFeed(ecuA, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecuA);
+    TEST_CHECK(bus.Count == 2 && bus.Frame[1][1] == 0x6E);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    Test_BusFeed(ecuB, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus2.Count == 2 && bus2.Frame[1][0] == 0x30);
+    Test_BusFeed(ecuB, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecuB);
+    TEST_CHECK(bus2.Count == 3 && bus2.Frame[2][1] == 0x6E);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    MicroUDS_Destroy(&ecuA);
+    MicroUDS_Destroy(&ecuB);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_QueueOverflow);
+    TEST_RUN(failed, Test_MultiFrameBusy);
+    TEST_RUN(failed, Test_Oversized);
+    TEST_RUN(failed, Test_PoolExhausted);
+
+    return failed;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file test_segmented_tx.c
+ * @brief Segmented responses: Flow Control BS / STmin (including 100–900 μs) / WAIT / OVFLW,
+ *        N_Bs and TxBurst.
+ */
+
+#include "test_common.h"
+
+#define TEST_RSP_LEN 100 // FF 6 字节 + 14 个连续帧
+
+static Test_Bus_t bus;
+static MicroUDS_Stats_t stats;
+
+static MicroUDS_NRC_t Test_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    MicroUDS_ResponseAppend(rsp, req->data, 2);
+    uint8_t *data = MicroUDS_ResponseReserve(rsp, TEST_RSP_LEN - 3);
+    if (data == NULL)
+        return UDS_NRC_RESPONSE_TOO_LONG;
+
+    for (size_t i = 0; i < TEST_RSP_LEN - 3; i++)
+        data[i] = (uint8_t)i;
+
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_Handle_t Test_Setup(size_t burst)
+{
+    MicroUDS_Conf_t conf = {.Stats = &stats};
+
+    MicroUDS_StatsInit(&stats);
+    bus.BurstMax = burst;
+    MicroUDS_Handle_t ecu = Test_BusCreate(&bus, 0, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Test_ReadDid, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    return ecu;
+}
+
+/* 发送请求并处理，实例发出首帧后等待流控；返回首帧的序号 */
+static size_t Test_Request(MicroUDS_Handle_t ecu)
+{
+    static const uint8_t sf[] = {0x03, 0x22, 0xF1, 0x90};
+    size_t first = bus.Count;
+
+    Test_BusFeed(ecu, sf, sizeof(sf), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+    return first;
+}
+
+static void Test_Fc(MicroUDS_Handle_t ecu, uint8_t fs, uint8_t bs, uint8_t stmin)
+{
+    const uint8_t fc[] = {(uint8_t)(0x30 | fs), bs, stmin};
+
+    Test_BusFeed(ecu, fc, sizeof(fc), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+}
+
+static uint32_t Test_Aborts(void)
+{
+    MicroUDS_StatsSnapshot_t snap;
+
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    return snap.Counter[MICROUDS_STAT_TX_ABORT];
+}
+
+/* 检查从 first 开始的响应完整且内容正确 */
+static bool Test_Complete(size_t first)
+{
+    uint8_t rsp[TEST_RSP_LEN];
+
+    if (Test_BusMessage(&bus, first, rsp, sizeof(rsp)) != TEST_RSP_LEN)
+        return false;
+    if (rsp[0] != 0x62 || rsp[1] != 0xF1 || rsp[2] != 0x90)
+        return false;
+    for (size_t i = 3; i < TEST_RSP_LEN; i++)
+    {
+        if (rsp[i] != (uint8_t)(i - 3))
+            return false;
+    }
+    return true;
+}
+
+/* BS = 4：每块 4 帧，块之间等待新的流控帧 */
+static int Test_BlockSize(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0);
+    TEST_CHECK(ecu != NULL);
+
+    size_t first = Test_Request(ecu);
+    TEST_CHECK(bus.Count == first + 1 && bus.Frame[first][0] == 0x10 && bus.Frame[first][1] == TEST_RSP_LEN);
+
+    for (size_t block = 1; block <= 3; block++)
+    {
+        Test_Fc(ecu, ISOTP_FS_CTS, 4, 0);
+        TEST_CHECK(bus.Count == first + 1 + 4 * block);
+        Test_BusAdvance(&bus, ecu, 10);
+        TEST_CHECK(bus.Count == first + 1 + 4 * block); // 块结束，等待流控
+    }
+
+    Test_Fc(ecu, ISOTP_FS_CTS, 4, 0);
+    TEST_CHECK(bus.Count == first + 15); // 最后一块只剩 2 帧
+    TEST_CHECK(Test_Complete(first));
+    TEST_CHECK(Test_Aborts() == 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* STmin = 5 ms：相邻连续帧间隔不小于 STmin */
+static int Test_Stmin(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0);
+    TEST_CHECK(ecu != NULL);
+
+    size_t first = Test_Request(ecu);
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 5);
+    TEST_CHECK(bus.Count == first + 2); // 第一个连续帧立即发送
+
+    Test_BusAdvance(&bus, ecu, 14 * 6);
+    TEST_CHECK(bus.Count == first + 15);
+    for (size_t i = first + 2; i < bus.Count; i++)
+        TEST_CHECK(bus.At[i] - bus.At[i - 1] >= 5);
+    TEST_CHECK(Test_Complete(first));
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+static uint64_t clockNs;            // 纳秒时钟
+static uint64_t sentNs[TEST_BUS_FRAMES]; // 每帧的发送时刻 (ns)
+
+static uint64_t Test_NowNs(void *user)
+{
+    (void)user;
+    return clockNs;
+}
+
+static int Test_NsTx(void *user, uint8_t *data, size_t size)
+{
+    int ret = Test_BusTx(user, data, size);
+
+    if (ret == 0)
+        sentNs[bus.Count - 1] = clockNs;
+    return ret;
+}
+
+/* STmin = 100–900 μs，默认 1 kHz 时基加纳秒时钟：主循环每 4 μs 调用一次，连续帧按 STmin 间隔发送 */
+static int Test_StminSubTick(void)
+{
+    MicroUDS_Handle_t ecu = NULL;
+
+    memset(&bus, 0, sizeof(bus));
+    bus.Transport.Tx = Test_NsTx;
+    bus.Transport.NowNs = Test_NowNs;
+    clockNs = 0;
+    MicroUDS_Conf_t conf = {.Transport = &bus.Transport, .TransportCtx = &bus};
+    TEST_CHECK(MicroUDS_Create(&ecu, &conf) == MICROUDS_OK);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Test_ReadDid, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    for (uint8_t stmin = 0xF1; stmin <= 0xF9; stmin++)
+    {
+        const uint64_t gap = (stmin - 0xF0u) * 100000u;
+
+        size_t first = Test_Request(ecu);
+        Test_Fc(ecu, ISOTP_FS_CTS, 0, stmin);
+        TEST_CHECK(bus.Count == first + 2);
+
+        for (uint64_t end = clockNs + 14 * gap + 1000000u; clockNs < end;)
+        {
+            clockNs += 4000u;
+            MicroUDS_TimerHandler(ecu);
+        }
+
+        TEST_CHECK(bus.Count == first + 15);
+        for (size_t i = first + 2; i < bus.Count; i++)
+            TEST_CHECK(sentNs[i] - sentNs[i - 1] >= gap && sentNs[i] - sentNs[i - 1] < gap + 8000u);
+        TEST_CHECK(Test_Complete(first));
+    }
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* FC.WAIT 重新开始 N_Bs；超过 MICROUDS_TX_WFT_MAX 次时终止 */
+static int Test_Wait(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0);
+    TEST_CHECK(ecu != NULL);
+
+    size_t first = Test_Request(ecu);
+    for (int i = 0; i < 3; i++)
+    {
+        Test_Fc(ecu, ISOTP_FS_WAIT, 0, 0);
+        Test_BusAdvance(&bus, ecu, MICROUDS_TIMEOUT_N_BS_MS - 100);
+    }
+    TEST_CHECK(Test_Aborts() == 0 && bus.Count == first + 1);
+
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 0);
+    TEST_CHECK(Test_Complete(first));
+
+    first = Test_Request(ecu);
+    for (int i = 0; i < MICROUDS_TX_WFT_MAX; i++)
+        Test_Fc(ecu, ISOTP_FS_WAIT, 0, 0);
+    TEST_CHECK(Test_Aborts() == 0);
+    Test_Fc(ecu, ISOTP_FS_WAIT, 0, 0);
+    TEST_CHECK(Test_Aborts() == 1);
+
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 0);
+    TEST_CHECK(bus.Count == first + 1); // 已终止，流控被忽略
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 没有流控帧：N_Bs 到期终止，之后的请求正常响应；FC 溢出立即终止 */
+static int Test_AbortPaths(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0);
+    TEST_CHECK(ecu != NULL);
+
+    size_t first = Test_Request(ecu);
+    Test_BusAdvance(&bus, ecu, MICROUDS_TIMEOUT_N_BS_MS - 1);
+    TEST_CHECK(Test_Aborts() == 0);
+    Test_BusAdvance(&bus, ecu, 2);
+    TEST_CHECK(Test_Aborts() == 1);
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 0);
+    TEST_CHECK(bus.Count == first + 1);
+
+    first = Test_Request(ecu);
+    TEST_CHECK(bus.Count == first + 1 && bus.Frame[first][0] == 0x10);
+    Test_Fc(ecu, ISOTP_FS_OVFLW, 0, 0);
+    TEST_CHECK(Test_Aborts() == 2);
+
+    first = Test_Request(ecu);
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 0);
+    TEST_CHECK(Test_Complete(first));
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* TxBurst 每次只接受 3 帧，且不跨越 BS 块 */
+static int Test_Burst(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(3);
+    TEST_CHECK(ecu != NULL);
+
+    size_t first = Test_Request(ecu);
+    Test_Fc(ecu, ISOTP_FS_CTS, 0, 0);
+    Test_BusAdvance(&bus, ecu, 10);
+    TEST_CHECK(bus.Count == first + 15 && Test_Complete(first));
+
+    first = Test_Request(ecu);
+    Test_Fc(ecu, ISOTP_FS_CTS, 5, 0);
+    Test_BusAdvance(&bus, ecu, 10);
+    TEST_CHECK(bus.Count == first + 6);
+    Test_Fc(ecu, ISOTP_FS_CTS, 5, 0);
+    Test_BusAdvance(&bus, ecu, 10);
+    TEST_CHECK(bus.Count == first + 11);
+    Test_Fc(ecu, ISOTP_FS_CTS, 5, 0);
+    Test_BusAdvance(&bus, ecu, 10);
+    TEST_CHECK(bus.Count == first + 15 && Test_Complete(first));
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_BlockSize);
+    TEST_RUN(failed, Test_Stmin);
+    TEST_RUN(failed, Test_StminSubTick);
+    TEST_RUN(failed, Test_Wait);
+    TEST_RUN(failed, Test_AbortPaths);
+    TEST_RUN(failed, Test_Burst);
+
+    return failed;
+}
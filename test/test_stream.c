@@ -0,0 +1,135 @@
+/**
+ * @file test_stream.c
+ * @brief Streaming receive: chunk callbacks instead of the multi-frame buffer.
+ */
+
+#include "test_common.h"
+
+#define TEST_REQ_LEN 300
+
+static MicroUDS_Loopback_t lb;
+static uint8_t got[TEST_REQ_LEN];
+static size_t gotLen;
+static size_t chunks;
+static size_t rejectAt; // 数据偏移达到该值时拒绝，0 = 不拒绝
+
+static MicroUDS_NRC_t Test_Chunk(MicroUDS_Handle_t handle, const MicroUDS_Request_t *chunk, size_t offset, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    if (offset != gotLen || offset + chunk->len > chunk->total || chunk->total != TEST_REQ_LEN - 1)
+        return UDS_NRC_GENERAL_PROGRAMMING_FAILURE; // 必须按顺序、不重叠地交付
+    if (rejectAt != 0 && offset >= rejectAt)
+        return UDS_NRC_REQUEST_OUT_OF_RANGE;
+
+    memcpy(got + 1 + offset, chunk->data, chunk->len);
+    gotLen += chunk->len;
+    chunks++;
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_NRC_t Test_Transfer(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    if (req->total != TEST_REQ_LEN - 1 || gotLen != req->total)
+        return UDS_NRC_GENERAL_PROGRAMMING_FAILURE;
+
+    uint8_t sum = 0;
+    for (size_t i = 1; i < TEST_REQ_LEN; i++)
+        sum = (uint8_t)(sum + got[i]);
+    MicroUDS_ResponseAppend(rsp, &sum, 1);
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_Handle_t Test_Setup(void)
+{
+    MicroUDS_Conf_t conf = {.RxBufSize = 16}; // 流式接收不受多帧缓冲区大小限制
+    MicroUDS_Handle_t ecu = Test_Create(&lb, NULL, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_TRANSFER_DATA, NULL, NULL, Test_Transfer, Test_Chunk},
+        {UDS_TESTER_PRESENT, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+
+    gotLen = 0;
+    chunks = 0;
+    rejectAt = 0;
+    return ecu;
+}
+
+static void Test_Fill(uint8_t *req)
+{
+    req[0] = UDS_TRANSFER_DATA;
+    for (size_t i = 1; i < TEST_REQ_LEN; i++)
+        req[i] = (uint8_t)(i * 7);
+}
+
+/* 数据按帧交付，处理函数在最后一帧之后运行一次 */
+static int Test_StreamWhole(void)
+{
+    uint8_t req[TEST_REQ_LEN];
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    Test_Fill(req);
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) == 2);
+    TEST_CHECK(memcmp(got + 1, req + 1, TEST_REQ_LEN - 1) == 0);
+    TEST_CHECK(chunks == 1 + 42); // 首帧 5 字节 + 42 个连续帧
+
+    uint8_t sum = 0;
+    for (size_t i = 1; i < TEST_REQ_LEN; i++)
+        sum = (uint8_t)(sum + req[i]);
+    TEST_CHECK(lb.Rsp[0] == 0x76 && lb.Rsp[1] == sum);
+
+    /* 没有流式回调的服务仍受 RxBufSize 限制 */
+    uint8_t big[20] = {UDS_TESTER_PRESENT};
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, big, sizeof(big), 10) == 3);
+    TEST_CHECK(lb.Rsp[0] == 0x7F && lb.Rsp[2] == UDS_NRC_RESPONSE_TOO_LONG);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* 回调返回NRC：发送负响应，之后的连续帧被忽略，处理函数不运行 */
+static int Test_StreamReject(void)
+{
+    uint8_t req[TEST_REQ_LEN];
+    MicroUDS_Handle_t ecu = Test_Setup();
+    TEST_CHECK(ecu != NULL);
+
+    Test_Fill(req);
+    rejectAt = 100;
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) == 3);
+    TEST_CHECK(lb.Rsp[0] == 0x7F && lb.Rsp[1] == UDS_TRANSFER_DATA && lb.Rsp[2] == UDS_NRC_REQUEST_OUT_OF_RANGE);
+    TEST_CHECK(gotLen >= 100 && gotLen < 107);
+
+    uint64_t frames = lb.TxFrames;
+    MicroUDS_Loopback_Advance(&lb, 10);
+    TEST_CHECK(lb.TxFrames == frames); // 只有一个负响应
+
+    /* 之后的请求正常接收 */
+    gotLen = 0;
+    chunks = 0;
+    rejectAt = 0;
+    TEST_CHECK(MicroUDS_Loopback_Transact(&lb, req, sizeof(req), 10) == 2);
+    TEST_CHECK(gotLen == TEST_REQ_LEN - 1);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_StreamWhole);
+    TEST_RUN(failed, Test_StreamReject);
+
+    return failed;
+}
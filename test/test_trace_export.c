@@ -0,0 +1,172 @@
+/**
+ * @file test_trace_export.c
+ * @brief Trace ring export as candump log lines and as a pcap image.
+ */
+
+#include "test_common.h"
+
+#if MICROUDS_TRACE_ENABLE
+
+#define TEST_TS0  1000250000ull // 第一条记录的时间戳 (ns)
+#define TEST_STEP 1500000ull    // 每条记录的时间间隔 (ns)
+
+static Test_Bus_t bus;
+static MicroUDS_Trace_t trace;
+static MicroUDS_TraceRec_t rec[16];
+static uint64_t clockNs;
+static uint8_t out[4096];
+
+static const uint8_t first[] = {0x10, 0x0A, 0x2E, 0xF1, 0x90, 0x01, 0x02, 0x03};
+static const uint8_t next[] = {0x21, 0x04, 0x05, 0x06, 0x07};
+
+static uint64_t Test_Clock(void *user)
+{
+    (void)user;
+
+    uint64_t ts = clockNs;
+    clockNs += TEST_STEP;
+    return ts;
+}
+
+/* 创建记录到跟踪环的实例，收发 ID 为 rx / tx，并完成一次多帧写请求 */
+static MicroUDS_Handle_t Test_Setup(uint32_t rx, uint32_t tx)
+{
+    MicroUDS_Handle_t ecu = NULL;
+
+    MicroUDS_TraceInit(&trace, rec, sizeof(rec) / sizeof(rec[0]));
+    trace.Clock = Test_Clock;
+    clockNs = TEST_TS0;
+
+    memset(&bus, 0, sizeof(bus));
+    bus.Transport.Tx = Test_BusTx;
+    bus.Transport.Now = Test_BusNow;
+    bus.Transport.Addressing.Source = rx;
+    bus.Transport.Addressing.Target = tx;
+
+    MicroUDS_Conf_t conf = {.Transport = &bus.Transport, .TransportCtx = &bus, .Trace = &trace};
+    if (MicroUDS_Create(&ecu, &conf) != MICROUDS_OK)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_WRITE_DATA_BY_IDENTIFIER, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    /* RX 首帧、TX 流控、FF 事件、RX 连续帧、TX 正响应 */
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    Test_BusFeed(ecu, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+    return ecu;
+}
+
+static char *Test_Hex(char *p, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        p += sprintf(p, "%02X", data[i]);
+    return p;
+}
+
+/* 第 i 条记录的时间戳 "(秒.微秒)" */
+static char *Test_Ts(char *p, size_t i)
+{
+    uint64_t ts = TEST_TS0 + i * TEST_STEP;
+    return p + sprintf(p, "(%010llu.%06llu)", (unsigned long long)(ts / 1000000000u), (unsigned long long)(ts % 1000000000u / 1000u));
+}
+
+static uint32_t Test_Le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* candump：帧为 ID#数据，事件为 '#' 注释行 */
+static int Test_Candump(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0x7E0, 0x7E8);
+    TEST_CHECK(ecu != NULL && bus.Count == 2);
+
+    uint8_t cf[ISOTP_CAN_DL];
+    memset(cf, 0xCC, sizeof(cf));
+    memcpy(cf, next, sizeof(next));
+
+    char expect[1024];
+    char *p = expect;
+    p = Test_Ts(p, 0);
+    p += sprintf(p, " vcan1 7E0#");
+    p = Test_Hex(p, first, sizeof(first));
+    p = Test_Ts(p + sprintf(p, "\n"), 1);
+    p += sprintf(p, " vcan1 7E8#");
+    p = Test_Hex(p, bus.Frame[0], bus.Len[0]);
+    p = Test_Ts(p + sprintf(p, "\n# "), 2);
+    p += sprintf(p, " vcan1 FF 0000000A\n");
+    p = Test_Ts(p, 3);
+    p += sprintf(p, " vcan1 7E0#");
+    p = Test_Hex(p, cf, sizeof(cf));
+    p = Test_Ts(p + sprintf(p, "\n"), 4);
+    p += sprintf(p, " vcan1 7E8#");
+    p = Test_Hex(p, bus.Frame[1], bus.Len[1]);
+    p += sprintf(p, "\n");
+
+    size_t need = MicroUDS_TraceExport(&trace, MICROUDS_TRACE_CANDUMP, "vcan1", NULL, 0);
+    size_t len = MicroUDS_TraceExport(&trace, MICROUDS_TRACE_CANDUMP, "vcan1", out, sizeof(out));
+    TEST_CHECK(len == (size_t)(p - expect) && len <= need);
+    TEST_CHECK(memcmp(out, expect, len) == 0);
+
+    /* 缓冲区不足时只导出完整的行 */
+    size_t line = (size_t)(strchr(expect, '\n') - expect) + 1;
+    len = MicroUDS_TraceExport(&trace, MICROUDS_TRACE_CANDUMP, "vcan1", out, need / 16 * 2);
+    TEST_CHECK(len >= line && out[len - 1] == '\n' && memcmp(out, expect, len) == 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+/* pcap：纳秒文件头、LINKTYPE_CAN_SOCKETCAN，只含帧，扩展ID带 CAN_EFF_FLAG */
+static int Test_Pcap(void)
+{
+    MicroUDS_Handle_t ecu = Test_Setup(0x18DAF110, 0x18DA10F1);
+    TEST_CHECK(ecu != NULL && bus.Count == 2);
+
+    size_t len = MicroUDS_TraceExport(&trace, MICROUDS_TRACE_PCAP, NULL, out, sizeof(out));
+    TEST_CHECK(len == 24u + 4u * (16u + 8u + ISOTP_CAN_DL)); // 4 帧，FF 事件不导出
+    TEST_CHECK(Test_Le32(out) == 0xA1B23C4Du && out[4] == 2 && out[6] == 4);
+    TEST_CHECK(Test_Le32(out + 20) == 227u);
+
+    static const size_t index[] = {0, 1, 3, 4}; // 各帧的记录序号（跳过 FF 事件）
+    static const uint8_t rxId[] = {0x98, 0xDA, 0xF1, 0x10};
+    static const uint8_t txId[] = {0x98, 0xDA, 0x10, 0xF1};
+    const uint8_t *r = out + 24;
+
+    for (size_t i = 0; i < 4; i++, r += 16u + 8u + ISOTP_CAN_DL)
+    {
+        uint64_t ts = TEST_TS0 + index[i] * TEST_STEP;
+        TEST_CHECK(Test_Le32(r) == ts / 1000000000u && Test_Le32(r + 4) == ts % 1000000000u);
+        TEST_CHECK(Test_Le32(r + 8) == 16u && Test_Le32(r + 12) == 16u);
+        TEST_CHECK(memcmp(r + 16, (i & 1) ? txId : rxId, 4) == 0); // 大端 ID
+        TEST_CHECK(r[20] == ISOTP_CAN_DL && r[21] == 0);
+    }
+    TEST_CHECK(memcmp(out + 24 + 24, first, sizeof(first)) == 0);
+    TEST_CHECK(memcmp(out + 24 + 32 + 24, bus.Frame[0], bus.Len[0]) == 0);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_Candump);
+    TEST_RUN(failed, Test_Pcap);
+
+    return failed;
+}
+
+#else
+
+int main(void)
+{
+    printf("skipped: MICROUDS_TRACE_ENABLE = 0\n");
+    return 0;
+}
+
+#endif
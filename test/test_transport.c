@@ -0,0 +1,77 @@
+/**
+ * @file test_transport.c
+ * @brief Transport interface: Flow Control frames go through the same transmit
+ *        path as the other frames (TX error accounting, trace).
+ */
+
+#include "test_common.h"
+
+static Test_Bus_t bus;
+static MicroUDS_Stats_t stats;
+static bool failTx; // 让下一次发送失败
+
+static const uint8_t first[] = {0x10, 0x0A, 0x2E, 0xF1, 0x90, 0x01, 0x02, 0x03}; // 10 字节写请求的首帧
+static const uint8_t next[] = {0x21, 0x04, 0x05, 0x06, 0x07};
+
+static int Test_FailingTx(void *user, uint8_t *data, size_t size)
+{
+    if (failTx)
+    {
+        failTx = false;
+        return 1;
+    }
+    return Test_BusTx(user, data, size);
+}
+
+static uint32_t Test_Stat(MicroUDS_Stat_t stat)
+{
+    MicroUDS_StatsSnapshot_t snap;
+
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    return snap.Counter[stat];
+}
+
+/* 流控帧发送失败：计入 TX 错误并放弃本次接收，之后的首帧正常接收 */
+static int Test_FlowControlError(void)
+{
+    MicroUDS_Handle_t ecu = NULL;
+
+    memset(&bus, 0, sizeof(bus));
+    bus.Transport.Tx = Test_FailingTx;
+    bus.Transport.Now = Test_BusNow;
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Conf_t conf = {.Transport = &bus.Transport, .TransportCtx = &bus, .Stats = &stats};
+    TEST_CHECK(MicroUDS_Create(&ecu, &conf) == MICROUDS_OK);
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_WRITE_DATA_BY_IDENTIFIER, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, 1);
+
+    failTx = true;
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 0 && Test_Stat(MICROUDS_STAT_TX_ERROR) == 1);
+
+    Test_BusFeed(ecu, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+    TEST_CHECK(bus.Count == 0); // 接收已放弃，连续帧被忽略
+
+    Test_BusFeed(ecu, first, sizeof(first), ISOTP_CAN_DL);
+    TEST_CHECK(bus.Count == 1 && bus.Frame[0][0] == 0x30 && bus.Len[0] == ISOTP_CAN_DL);
+    Test_BusFeed(ecu, next, sizeof(next), ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+    TEST_CHECK(bus.Count == 2 && bus.Frame[1][1] == 0x6E);
+    TEST_CHECK(Test_Stat(MICROUDS_STAT_TX_ERROR) == 1);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_FlowControlError);
+
+    return failed;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_tx_pool.c
+ * @brief Shared transmit buffer pool: instances hold no transmit buffer while
+ *        idle and borrow one only while a response is built, pending or sent.
+ */
+
+#include "test_common.h"
+
+#define TEST_RSP_LEN 100 // FF 6 字节 + 14 个连续帧
+#define TEST_BLOCK   128
+
+static Test_Bus_t busA, busB;
+static MicroUDS_Stats_t stats;
+static uint8_t mem[MICROUDS_POOL_SIZE(1, TEST_BLOCK)];
+static MicroUDS_Pool_t pool;
+
+static MicroUDS_NRC_t Test_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    MicroUDS_ResponseAppend(rsp, req->data, 2);
+    uint8_t *data = MicroUDS_ResponseReserve(rsp, TEST_RSP_LEN - 3);
+    if (data == NULL)
+        return UDS_NRC_RESPONSE_TOO_LONG;
+
+    memset(data, 0x5A, TEST_RSP_LEN - 3);
+    return UDS_NRC_SUCCESS;
+}
+
+static MicroUDS_NRC_t Test_Routine(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)req;
+    (void)rsp;
+    (void)param;
+
+    return UDS_NRC_REQUEST_CORRECTLY_RECEIVED_RSP_PENDING;
+}
+
+static MicroUDS_Handle_t Test_Setup(Test_Bus_t *bus, MicroUDS_Stats_t *st)
+{
+    MicroUDS_Conf_t conf = {.TxPool = &pool, .Stats = st};
+
+    MicroUDS_Handle_t ecu = Test_BusCreate(bus, 0, &conf);
+    if (ecu == NULL)
+        return NULL;
+
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Test_ReadDid, NULL},
+        {UDS_ROUTINE_CONTROL, NULL, NULL, Test_Routine, NULL},
+        {UDS_TESTER_PRESENT, Test_Positive, NULL, NULL, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+    return ecu;
+}
+
+static void Test_Send(MicroUDS_Handle_t ecu, const uint8_t *sf, size_t len)
+{
+    Test_BusFeed(ecu, sf, len, ISOTP_CAN_DL);
+    MicroUDS_TimerHandler(ecu);
+}
+
+static void Test_Fc(Test_Bus_t *bus, MicroUDS_Handle_t ecu)
+{
+    static const uint8_t fc[] = {0x30, 0x00, 0x00};
+
+    Test_BusFeed(ecu, fc, sizeof(fc), ISOTP_CAN_DL);
+    Test_BusAdvance(bus, ecu, 10);
+}
+
+static const uint8_t readDid[] = {0x03, 0x22, 0xF1, 0x90};
+static const uint8_t testerPresent[] = {0x02, 0x3E, 0x00};
+static const uint8_t routine[] = {0x04, 0x31, 0x01, 0x02, 0x00};
+
+/* 空闲实例不持有发送缓冲区；分段响应期间借用，发送完成或中止后归还 */
+static int Test_Borrow(void)
+{
+    uint8_t rsp[TEST_RSP_LEN];
+
+    TEST_CHECK(MicroUDS_PoolInit(&pool, mem, sizeof(mem), TEST_BLOCK) == MICROUDS_OK);
+    MicroUDS_Handle_t ecu = Test_Setup(&busA, NULL);
+    TEST_CHECK(ecu != NULL);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    Test_Send(ecu, testerPresent, sizeof(testerPresent));
+    TEST_CHECK(busA.Count == 1 && busA.Frame[0][1] == 0x7E);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1); // 单帧响应发送后立即归还
+
+    Test_Send(ecu, readDid, sizeof(readDid));
+    TEST_CHECK(busA.Count == 2 && busA.Frame[1][0] == 0x10);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 0); // 等待流控期间持有
+
+    Test_Fc(&busA, ecu);
+    TEST_CHECK(Test_BusMessage(&busA, 1, rsp, sizeof(rsp)) == TEST_RSP_LEN && rsp[0] == 0x62);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    Test_Send(ecu, readDid, sizeof(readDid));
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 0);
+    Test_BusAdvance(&busA, ecu, MICROUDS_TIMEOUT_N_BS_MS + 10); // N_Bs 超时中止
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    Test_Send(ecu, readDid, sizeof(readDid));
+    MicroUDS_Destroy(&ecu); // 删除时归还
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+    return 0;
+}
+
+/* 缓冲池已空：需要在发送缓冲区中构建响应的请求得到 NRC 0x21，之后恢复 */
+static int Test_Exhausted(void)
+{
+    uint8_t rsp[TEST_RSP_LEN];
+
+    TEST_CHECK(MicroUDS_PoolInit(&pool, mem, sizeof(mem), TEST_BLOCK) == MICROUDS_OK);
+    MicroUDS_StatsInit(&stats);
+    MicroUDS_Handle_t a = Test_Setup(&busA, NULL);
+    MicroUDS_Handle_t b = Test_Setup(&busB, &stats);
+    TEST_CHECK(a != NULL && b != NULL);
+
+    Test_Send(a, readDid, sizeof(readDid));
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 0);
+
+    Test_Send(b, readDid, sizeof(readDid));
+    TEST_CHECK(busB.Count == 1 && busB.Frame[0][1] == 0x7F && busB.Frame[0][3] == UDS_NRC_BUSY_REPEAT_REQUEST);
+
+    MicroUDS_StatsSnapshot_t snap;
+    MicroUDS_StatsSnapshot(&stats, &snap, false);
+    TEST_CHECK(snap.Counter[MICROUDS_STAT_OVERFLOW] == 1);
+
+    Test_Send(b, testerPresent, sizeof(testerPresent)); // 旧接口处理函数不使用发送缓冲区
+    TEST_CHECK(busB.Count == 2 && busB.Frame[1][1] == 0x7E);
+
+    Test_Fc(&busA, a);
+    TEST_CHECK(Test_BusMessage(&busA, 0, rsp, sizeof(rsp)) == TEST_RSP_LEN);
+
+    Test_Send(b, readDid, sizeof(readDid));
+    TEST_CHECK(busB.Count == 3 && busB.Frame[2][0] == 0x10);
+    Test_Fc(&busB, b);
+    TEST_CHECK(Test_BusMessage(&busB, 2, rsp, sizeof(rsp)) == TEST_RSP_LEN);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    MicroUDS_Destroy(&a);
+    MicroUDS_Destroy(&b);
+    return 0;
+}
+
+/* 挂起的请求保留缓冲区，最终响应放入其中发送后归还 */
+static int Test_Pending(void)
+{
+    uint8_t rsp[TEST_RSP_LEN];
+    uint8_t final[TEST_RSP_LEN] = {0x71, 0x01, 0x02, 0x00};
+
+    TEST_CHECK(MicroUDS_PoolInit(&pool, mem, sizeof(mem), TEST_BLOCK) == MICROUDS_OK);
+    MicroUDS_Handle_t ecu = Test_Setup(&busA, NULL);
+    TEST_CHECK(ecu != NULL);
+
+    Test_Send(ecu, routine, sizeof(routine));
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 0);
+
+    memset(final + 4, 0xA5, sizeof(final) - 4);
+    TEST_CHECK(MicroUDS_CompleteRequest(ecu, UDS_NRC_SUCCESS, final, sizeof(final)) == MICROUDS_OK);
+    Test_BusAdvance(&busA, ecu, 1);
+    size_t first = busA.Count - 1;
+    TEST_CHECK(busA.Frame[first][0] == 0x10);
+
+    Test_Fc(&busA, ecu);
+    TEST_CHECK(Test_BusMessage(&busA, first, rsp, sizeof(rsp)) == sizeof(final) && memcmp(rsp, final, sizeof(final)) == 0);
+    TEST_CHECK(MicroUDS_PoolAvailable(&pool) == 1);
+
+    MicroUDS_Destroy(&ecu);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_Borrow);
+    TEST_RUN(failed, Test_Exhausted);
+    TEST_RUN(failed, Test_Pending);
+
+    return failed;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file test_wheel.c
+ * @brief Shared timer wheel: deadlines that expire across the 32-bit millisecond wrap.
+ */
+
+#include "test_common.h"
+
+#define TEST_START (UINT32_MAX - 299u) // 300 ms 后 32 位毫秒时钟回绕
+
+static Test_Bus_t bus;  // 实例A：使用总线时钟
+static Test_Bus_t bus2; // 实例B：没有时钟，使用时间轮的时钟
+static MicroUDS_Wheel_t wheel;
+static MicroUDS_Stats_t statsA;
+static MicroUDS_Stats_t statsB;
+
+static MicroUDS_NRC_t Test_ReadDid(MicroUDS_Handle_t handle, const MicroUDS_Request_t *req, MicroUDS_Response_t *rsp, void *param)
+{
+    (void)handle;
+    (void)param;
+
+    MicroUDS_ResponseAppend(rsp, req->data, 2);
+    return MicroUDS_ResponseReserve(rsp, 20) != NULL ? UDS_NRC_SUCCESS : UDS_NRC_RESPONSE_TOO_LONG; // 多帧响应
+}
+
+static void Test_Register(MicroUDS_Handle_t ecu)
+{
+    const MicroUDS_ServiceTable_t services[] = {
+        {UDS_DIAGNOSTIC_SESSION_CONTROL, Test_Positive, NULL, NULL, NULL},
+        {UDS_READ_DATA_BY_IDENTIFIER, NULL, NULL, Test_ReadDid, NULL},
+    };
+    MicroUDS_RegisterService(ecu, services, sizeof(services) / sizeof(services[0]));
+}
+
+/* 两个实例的时钟都走到 now（32 位回绕），再运行时间轮 */
+static size_t Test_Run(uint32_t now)
+{
+    bus.Now = now;
+    bus2.Now = now;
+    return MicroUDS_WheelRun(&wheel, now);
+}
+
+static uint32_t Test_Stat(MicroUDS_Stats_t *stats, MicroUDS_Stat_t stat)
+{
+    MicroUDS_StatsSnapshot_t snap;
+
+    MicroUDS_StatsSnapshot(stats, &snap, false);
+    return snap.Counter[stat];
+}
+
+/* N_Bs（1 s）与 S3（5 s）都在时钟回绕之后到期，且恰好在截止时刻到期 */
+static int Test_WrapExpiry(void)
+{
+    static const uint8_t session[] = {0x02, 0x10, 0x03};
+    static const uint8_t read[] = {0x03, 0x22, 0xF1, 0x90};
+
+    TEST_CHECK(MicroUDS_WheelInit(&wheel, TEST_START) == MICROUDS_OK);
+    MicroUDS_StatsInit(&statsA);
+    MicroUDS_StatsInit(&statsB);
+
+    MicroUDS_Conf_t confA = {.Wheel = &wheel, .Stats = &statsA};
+    MicroUDS_Handle_t ecuA = Test_BusCreate(&bus, 0, &confA);
+    TEST_CHECK(ecuA != NULL);
+    Test_Register(ecuA);
+
+    MicroUDS_Handle_t ecuB = NULL;
+    memset(&bus2, 0, sizeof(bus2));
+    bus2.Transport.Tx = Test_BusTx;
+    MicroUDS_Conf_t confB = {.Transport = &bus2.Transport, .TransportCtx = &bus2, .Wheel = &wheel, .Stats = &statsB};
+    TEST_CHECK(MicroUDS_Create(&ecuB, &confB) == MICROUDS_OK);
+    Test_Register(ecuB);
+
+    Test_Run(TEST_START);
+    Test_BusFeed(ecuA, session, sizeof(session), ISOTP_CAN_DL);
+    Test_BusFeed(ecuB, read, sizeof(read), ISOTP_CAN_DL);
+    Test_Run(TEST_START);
+    TEST_CHECK(bus.Count == 1 && bus.Frame[0][1] == 0x50);
+    TEST_CHECK(bus2.Count == 1 && bus2.Frame[0][0] == 0x10); // 首帧，等待流控
+
+    uint32_t next = MicroUDS_WheelNextDeadline(&wheel);
+    TEST_CHECK(next == MICROUDS_TIMEOUT_N_BS_MS);
+
+    Test_Run(TEST_START + 250u);
+    Test_Run(TEST_START + 400u); // 跨过回绕
+    Test_Run(TEST_START + MICROUDS_TIMEOUT_N_BS_MS - 1u);
+    TEST_CHECK(Test_Stat(&statsB, MICROUDS_STAT_TX_ABORT) == 0);
+    Test_Run(TEST_START + MICROUDS_TIMEOUT_N_BS_MS);
+    TEST_CHECK(Test_Stat(&statsB, MICROUDS_STAT_TX_ABORT) == 1);
+
+    next = MicroUDS_WheelNextDeadline(&wheel);
+    TEST_CHECK(next <= MICROUDS_SERVICE_TIMEOUT_MS - MICROUDS_TIMEOUT_N_BS_MS);
+
+    Test_Run(TEST_START + MICROUDS_SERVICE_TIMEOUT_MS - 1u);
+    TEST_CHECK(Test_Stat(&statsA, MICROUDS_STAT_S3_TIMEOUT) == 0);
+    Test_Run(TEST_START + MICROUDS_SERVICE_TIMEOUT_MS);
+    TEST_CHECK(Test_Stat(&statsA, MICROUDS_STAT_S3_TIMEOUT) == 1);
+
+    /* 回绕之后的新请求照常调度 */
+    uint32_t now = TEST_START + MICROUDS_SERVICE_TIMEOUT_MS + 10u;
+    Test_Run(now);
+    Test_BusFeed(ecuA, session, sizeof(session), ISOTP_CAN_DL);
+    Test_Run(now);
+    TEST_CHECK(bus.Count == 2 && bus.Frame[1][1] == 0x50);
+    Test_Run(now + MICROUDS_SERVICE_TIMEOUT_MS);
+    TEST_CHECK(Test_Stat(&statsA, MICROUDS_STAT_S3_TIMEOUT) == 2);
+
+    MicroUDS_Destroy(&ecuA);
+    MicroUDS_Destroy(&ecuB);
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    TEST_RUN(failed, Test_WrapExpiry);
+
+    return failed;
+}